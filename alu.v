@@ -58,6 +58,108 @@ endmodule
 
 
 
+// 32-bit carry-lookahead adder: 4-bit groups with generate/propagate,
+// group carries from the group G/P terms
+module cla_adder_32 (
+  input [31:0] a,
+  input [31:0] b,
+  input cin,
+  output [31:0] sum,
+  output cout
+);
+  wire [31:0] g = a & b;
+  wire [31:0] p = a ^ b;
+  wire [7:0] grp_g, grp_p;
+  wire [8:0] grp_c;
+  wire [31:0] c; // carry into each bit
+
+  assign grp_c[0] = cin;
+
+  genvar k;
+  generate
+    for (k = 0; k < 8; k = k + 1) begin : group
+      wire [3:0] gg = g[4*k +: 4];
+      wire [3:0] pp = p[4*k +: 4];
+      // carries inside the group, all from the group carry-in
+      assign c[4*k]     = grp_c[k];
+      assign c[4*k + 1] = gg[0] | (pp[0] & grp_c[k]);
+      assign c[4*k + 2] = gg[1] | (pp[1] & gg[0]) | (pp[1] & pp[0] & grp_c[k]);
+      assign c[4*k + 3] = gg[2] | (pp[2] & gg[1]) | (pp[2] & pp[1] & gg[0]) |
+                          (pp[2] & pp[1] & pp[0] & grp_c[k]);
+      assign grp_g[k] = gg[3] | (pp[3] & gg[2]) | (pp[3] & pp[2] & gg[1]) |
+                        (pp[3] & pp[2] & pp[1] & gg[0]);
+      assign grp_p[k] = &pp;
+      assign grp_c[k + 1] = grp_g[k] | (grp_p[k] & grp_c[k]);
+    end
+  endgenerate
+
+  assign sum = p ^ c;
+  assign cout = grp_c[8];
+endmodule
+
+// 32-bit Kogge-Stone parallel prefix adder, log2(32) = 5 prefix levels
+module kogge_stone_adder_32 (
+  input [31:0] a,
+  input [31:0] b,
+  input cin,
+  output [31:0] sum,
+  output cout
+);
+  wire [31:0] p = a ^ b;
+  wire [31:0] pg [0:5]; // group generate, bit i covers bits i..0 after level 5
+  wire [31:0] pp [0:5]; // group propagate
+
+  // carry-in folded into bit 0
+  assign pg[0] = (a & b) | {31'b0, p[0] & cin};
+  assign pp[0] = p;
+
+  genvar l, i;
+  generate
+    for (l = 0; l < 5; l = l + 1) begin : level
+      for (i = 0; i < 32; i = i + 1) begin : bit_
+        if (i >= (1 << l)) begin : combine
+          assign pg[l + 1][i] = pg[l][i] | (pp[l][i] & pg[l][i - (1 << l)]);
+          assign pp[l + 1][i] = pp[l][i] & pp[l][i - (1 << l)];
+        end else begin : pass
+          assign pg[l + 1][i] = pg[l][i];
+          assign pp[l + 1][i] = pp[l][i];
+        end
+      end
+    end
+  endgenerate
+
+  assign sum = p ^ {pg[5][30:0], cin};
+  assign cout = pg[5][31];
+endmodule
+
+// adder selectable per instance
+// ARCH: 0 = ripple carry (full_adder chain), 1 = carry lookahead,
+//       2 = Kogge-Stone, 3 = behavioral `+` (left to synthesis, fastest to simulate)
+module adder_32 #(
+  parameter ARCH = 0
+) (
+  input [31:0] a,
+  input [31:0] b,
+  input cin,
+  output [31:0] sum,
+  output cout
+);
+  generate
+    if (ARCH == 1) begin : cla
+      cla_adder_32 add (.a(a), .b(b), .cin(cin), .sum(sum), .cout(cout));
+    end else if (ARCH == 2) begin : ks
+      kogge_stone_adder_32 add (.a(a), .b(b), .cin(cin), .sum(sum), .cout(cout));
+    end else if (ARCH == 3) begin : beh
+      assign {cout, sum} = {1'b0, a} + {1'b0, b} + {32'b0, cin};
+    end else begin : rca
+      ripple_carry_adder_32 add (.a(a), .b(b), .cin(cin), .sum(sum), .cout(cout));
+    end
+  endgenerate
+endmodule
+
+
+
+
 module barrel_shifter (
   input [31:0] data_in,
   input [4:0] shift_amt,
@@ -153,7 +255,9 @@ module barrel_shifter (
   assign data_out = shift_left ? final_data : stage4;
 endmodule
 
-module alu (
+module alu #(
+  parameter ADDER = 0 // adder_32 ARCH: 0 ripple, 1 CLA, 2 Kogge-Stone, 3 behavioral
+) (
   input [31:0] op1,
   input [31:0] op2,
   input [3:0] alu_ctrl,
@@ -177,7 +281,7 @@ module alu (
   assign op2_modified = subtract ? ~op2 : op2;
 
   // Single adder/subtractor unit
-  ripple_carry_adder_32 adder_subtractor (
+  adder_32 #(.ARCH(ADDER)) adder_subtractor (
     .a(op1),
     .b(op2_modified),
     .cin(subtract ? 1'b1 : 1'b0),
@@ -0,0 +1,134 @@
+// branch predictor for the pipelined core's fetch stage
+// Direct-mapped branch target buffer (tag, target, kind) with a separate
+// table of 2-bit bimodal counters for conditional branches, plus a small
+// return address stack for JALR returns.
+//
+//  - lookup is combinational on the PC of the instruction being decoded
+//  - BTB entry kinds: conditional branch (counter decides), jump (always
+//    taken, JAL/JALR), return (always taken, target from the RAS)
+//  - update comes from EX, where instructions are never on a wrong path, so the
+//    counters, BTB and RAS are trained non-speculatively
+//  - call = JAL/JALR with rd = x1/x5, return = JALR x0, 0(x1/x5)
+//  - tables are indexed by PC[..:1], RVC instructions sit on halfwords
+
+module bpred #(
+    parameter BTB_ENTRIES = 16, // power of 2
+    parameter BHT_ENTRIES = 64, // power of 2
+    parameter RAS_DEPTH = 4     // power of 2
+)(
+    input wire clk,
+    input wire rst_n,
+
+    // lookup (IF)
+    input wire [31:0] lookup_pc,
+    output wire pred_taken,
+    output wire [31:0] pred_target,
+
+    // update (EX), one per instruction leaving EX
+    input wire update_valid,
+    input wire [31:0] update_pc,
+    input wire update_is_branch,
+    input wire update_is_jump,   // JAL or JALR
+    input wire update_is_call,
+    input wire update_is_return,
+    input wire [31:0] update_link, // address after the call (PC + 2 or 4)
+    input wire update_taken,
+    input wire [31:0] update_target,
+    input wire update_mispredict,
+
+    output reg [31:0] predict_count,    // control-flow instructions resolved
+    output reg [31:0] mispredict_count  // ... of which redirected the fetch
+);
+
+    localparam BTB_BITS = (BTB_ENTRIES > 1) ? $clog2(BTB_ENTRIES) : 1;
+    localparam BHT_BITS = (BHT_ENTRIES > 1) ? $clog2(BHT_ENTRIES) : 1;
+    localparam RAS_BITS = (RAS_DEPTH > 1) ? $clog2(RAS_DEPTH) : 1;
+    localparam TAG_BITS = 31 - BTB_BITS;
+
+    localparam KIND_BRANCH = 2'b00;
+    localparam KIND_JUMP   = 2'b01;
+    localparam KIND_RETURN = 2'b10;
+
+    reg                btb_valid [0:BTB_ENTRIES-1];
+    reg [TAG_BITS-1:0] btb_tag [0:BTB_ENTRIES-1];
+    reg [31:0]         btb_target [0:BTB_ENTRIES-1];
+    reg [1:0]          btb_kind [0:BTB_ENTRIES-1];
+    reg [1:0]          bht [0:BHT_ENTRIES-1]; // 00/01 not taken, 10/11 taken
+
+    reg [31:0]         ras [0:RAS_DEPTH-1];
+    reg [RAS_BITS-1:0] ras_top;   // index of the newest entry
+    reg [RAS_BITS:0]   ras_count;
+
+    // lookup
+    wire [BTB_BITS-1:0] l_idx = lookup_pc[BTB_BITS:1];
+    wire [TAG_BITS-1:0] l_tag = lookup_pc[31:BTB_BITS+1];
+    wire [BHT_BITS-1:0] l_bht = lookup_pc[BHT_BITS:1];
+    wire l_hit = btb_valid[l_idx] && (btb_tag[l_idx] == l_tag);
+    wire [1:0] l_kind = btb_kind[l_idx];
+
+    assign pred_taken = l_hit && ((l_kind != KIND_BRANCH) || bht[l_bht][1]);
+    assign pred_target = (l_kind == KIND_RETURN && ras_count != 0) ? ras[ras_top] : btb_target[l_idx];
+
+    // update
+    wire [BTB_BITS-1:0] u_idx = update_pc[BTB_BITS:1];
+    wire [TAG_BITS-1:0] u_tag = update_pc[31:BTB_BITS+1];
+    wire [BHT_BITS-1:0] u_bht = update_pc[BHT_BITS:1];
+    wire u_cf = update_is_branch || update_is_jump;
+
+    integer i;
+
+    always @(posedge clk) begin
+        if (!rst_n) begin
+            for (i = 0; i < BTB_ENTRIES; i = i + 1) begin
+                btb_valid[i] <= 1'b0;
+            end
+            for (i = 0; i < BHT_ENTRIES; i = i + 1) begin
+                bht[i] <= 2'b01; // weakly not taken
+            end
+            ras_top <= {RAS_BITS{1'b0}};
+            ras_count <= {(RAS_BITS+1){1'b0}};
+            predict_count <= 32'd0;
+            mispredict_count <= 32'd0;
+        end else if (update_valid) begin
+            if (u_cf) begin
+                predict_count <= predict_count + 32'd1;
+            end
+            if (update_mispredict) begin
+                mispredict_count <= mispredict_count + 32'd1;
+            end
+
+            // bimodal counter
+            if (update_is_branch) begin
+                if (update_taken && bht[u_bht] != 2'b11) begin
+                    bht[u_bht] <= bht[u_bht] + 2'b01;
+                end else if (!update_taken && bht[u_bht] != 2'b00) begin
+                    bht[u_bht] <= bht[u_bht] - 2'b01;
+                end
+            end
+
+            // target buffer: allocate on taken, drop entries that hit a non-branch
+            if (u_cf && update_taken) begin
+                btb_valid[u_idx] <= 1'b1;
+                btb_tag[u_idx] <= u_tag;
+                btb_target[u_idx] <= update_target;
+                btb_kind[u_idx] <= update_is_return ? KIND_RETURN :
+                                   update_is_jump ? KIND_JUMP : KIND_BRANCH;
+            end else if (!u_cf && update_mispredict) begin
+                btb_valid[u_idx] <= 1'b0;
+            end
+
+            // return address stack, overwrites the oldest entry when full
+            if (update_is_return && ras_count != 0) begin
+                ras_top <= ras_top - 1'b1;
+                ras_count <= ras_count - 1'b1;
+            end else if (update_is_call) begin
+                ras[ras_top + 1'b1] <= update_link;
+                ras_top <= ras_top + 1'b1;
+                if (ras_count != RAS_DEPTH) begin
+                    ras_count <= ras_count + 1'b1;
+                end
+            end
+        end
+    end
+
+endmodule
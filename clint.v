@@ -0,0 +1,73 @@
+// Core-local interruptor (CLINT), registers at 0x0200_0000
+// mtime counts clock cycles; the timer interrupt is pending while
+// mtime >= mtimecmp, software clears it by moving mtimecmp forward.
+// msip raises the machine software interrupt.
+
+module clint (
+  input wire clk,
+  input wire resetn,
+
+  // register port (MMIO slave, 1-cycle read response)
+  input wire [15:0] reg_addr,
+  input wire [31:0] reg_wdata,
+  input wire reg_write,
+  input wire reg_valid,
+  output reg [31:0] reg_rdata,
+  output reg reg_resp_valid,
+
+  output wire [63:0] mtime,
+  output wire timer_irq,
+  output wire soft_irq
+);
+
+// address map (offsets as in the SiFive CLINT)
+// 0000: msip        bit0 = software interrupt pending
+// 4000: mtimecmp    low word
+// 4004: mtimecmph   high word
+// bff8: mtime       low word
+// bffc: mtimeh      high word
+
+reg [63:0] mtime_reg;
+reg [63:0] mtimecmp;
+reg msip;
+
+assign mtime = mtime_reg;
+assign timer_irq = (mtime_reg >= mtimecmp);
+assign soft_irq = msip;
+
+always @(posedge clk) begin
+  if (!resetn) begin
+    mtime_reg <= 64'd0;
+    mtimecmp <= {64{1'b1}};
+    msip <= 1'b0;
+    reg_resp_valid <= 1'b0;
+    reg_rdata <= 32'd0;
+  end else begin
+    mtime_reg <= mtime_reg + 64'd1;
+
+    reg_resp_valid <= reg_valid && !reg_write;
+    if (reg_valid && !reg_write) begin
+      case (reg_addr)
+        16'h0000: reg_rdata <= {31'd0, msip};
+        16'h4000: reg_rdata <= mtimecmp[31:0];
+        16'h4004: reg_rdata <= mtimecmp[63:32];
+        16'hbff8: reg_rdata <= mtime_reg[31:0];
+        16'hbffc: reg_rdata <= mtime_reg[63:32];
+        default:  reg_rdata <= 32'd0;
+      endcase
+    end
+
+    if (reg_valid && reg_write) begin
+      case (reg_addr)
+        16'h0000: msip <= reg_wdata[0];
+        16'h4000: mtimecmp[31:0] <= reg_wdata;
+        16'h4004: mtimecmp[63:32] <= reg_wdata;
+        16'hbff8: mtime_reg[31:0] <= reg_wdata;
+        16'hbffc: mtime_reg[63:32] <= reg_wdata;
+        default: ;
+      endcase
+    end
+  end
+end
+
+endmodule
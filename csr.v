@@ -1,16 +1,310 @@
-module csr_file(
+// CSR file: Zicntr / Zihpm counters and machine-mode trap CSRs
+// 64-bit cycle, time and instret plus NUM_HPM programmable hardware
+// performance counters (mhpmcounter3.., selected by mhpmevent3..).
+// Access comes from CSRRW/CSRRS/CSRRC (and the immediate forms, whose
+// zero-extended uimm the core passes as `src`).
+//
+//   0xC00/0xC80  cycle/cycleh        (read-only shadows of mcycle)
+//   0xC01/0xC81  time/timeh          (CLINT mtime)
+//   0xC02/0xC82  instret/instreth    (read-only shadows of minstret)
+//   0xC03+/0xC83+ hpmcounterN(h)     (read-only shadows of mhpmcounterN)
+//   0xB00/0xB80  mcycle/mcycleh
+//   0xB02/0xB82  minstret/minstreth
+//   0xB03+/0xB83+ mhpmcounterN(h)
+//   0x320        mcountinhibit       (bit 0 cycle, bit 2 instret, bit N hpmN)
+//   0x323+       mhpmeventN          (HPM_EV_* in [4:0], bit 31 = OF)
+//   0x300        mstatus             (MIE bit 3, MPIE bit 7, MPP reads as M)
+//   0x304/0x344  mie/mip             (MSI 3, MTI 7, LCOFI 13)
+//   0x305        mtvec               (mode 0 direct, 1 vectored for interrupts)
+//   0x340..0x343 mscratch, mepc, mcause, mtval (reads 0)
+//   0x800        vmask               (vector element mask, bit i = element i)
+//   0xC20/0xC21  vl/vtype            (read-only, set by VSETL; vtype[1:0] = SEW)
+//   0xC22        vlenb               (VLEN/8)
+// Unknown addresses read as 0 and ignore writes.
+//
+// Counter overflow (as in Sscofpmf): when mhpmcounterN wraps from all ones,
+// OF is set and, if it was clear, mip.LCOFIP is raised. Software reloads the
+// counter with -period, clears OF by rewriting mhpmevent and clears LCOFIP.
+//
+// vmask selects the active elements of the masked (funct3=110) vector
+// instructions, one bit per element up to VLEN/8 elements; it resets to all
+// ones. VMSETL sets it to the first min(rs1, VLEN/SEW) elements and returns
+// that count, the length of the next strip of a loop.
+//
+// vl and vtype are the strip of VSETL: vtype holds the SEW that vector
+// instructions with SEW field 11 run at (`vtype_sew`, resolved by the core),
+// vl the elements of that SEW every vector instruction works on (`vl_bytes`,
+// the first vl << vtype bytes). They reset to VLEN/8 elements of SEW=8, i.e.
+// the whole register.
+
+module csr_file #(
+  parameter NUM_HPM = 4, // mhpmcounter3 .. mhpmcounter(3+NUM_HPM-1), at most 28
+  parameter VLEN = 64
+) (
   input clk,
   input resetn,
 
-  input [11:0] waddr,
-  input [31:0] wdata,
-  input        wvalid,
+  // access port, one CSR instruction per valid cycle
+  input [11:0] addr,
+  input [1:0]  op,        // funct3[1:0]: 01 RW, 10 RS, 11 RC
+  input [31:0] src,       // rs1 value or uimm
+  input        src_zero,  // rs1 = x0 / uimm = 0: RS/RC do not write
+  input        valid,
+  output reg [31:0] rdata, // old value, goes to rd
+
+  // vector mask and length: VMSETL/VSETL, byte enables of the active elements at `vsew`
+  input        vset,       // VMSETL in this cycle
+  input        vsetl,      // VSETL in this cycle
+  input [31:0] vset_len,   // rs1: elements left
+  input [1:0]  vsetl_sew,  // rs2[1:0] of VSETL: new vtype
+  output [31:0] vset_grant, // elements in this strip, goes to rd
+  input [1:0]  vsew,       // SEW of the vector instruction (00=8, 01=16, 10=32)
+  output [VLEN/8-1:0] vmask_bytes,
+  output [1:0] vtype_sew,  // SEW of the dynamic (SEW field 11) instructions
+  output [VLEN/8-1:0] vl_bytes, // bytes inside vl
+
+  // events
+  input ev_retire,       // one instruction retired
+  input ev_vec_retire,   // vector instruction retired
+  input ev_vlsu_busy,    // vlsu owns the data bus this cycle
+  input ev_mem_stall,    // core waits for a data memory response
+  input ev_branch_taken, // conditional branch taken
 
-  input [11:0] raddr,
-  input        ravalid,
-  output wire [31:0] rdata
+  // CLINT
+  input [63:0] mtime,
+  input        timer_irq,
+  input        soft_irq,
+
+  // traps: the core takes an interrupt when irq_pending, or an ECALL
+  output        irq_pending,
+  input         trap_take,   // enter the handler, trap_pc goes to mepc
+  input         trap_ecall,  // the trap is an ECALL, not an interrupt
+  input  [31:0] trap_pc,
+  output [31:0] trap_vector, // handler address for this trap
+  input         mret,
+  output [31:0] mepc_out
 );
 
+  localparam HPM_EV_NONE         = 5'd0;
+  localparam HPM_EV_VEC_RETIRE   = 5'd1;
+  localparam HPM_EV_VLSU_BUSY    = 5'd2;
+  localparam HPM_EV_MEM_STALL    = 5'd3;
+  localparam HPM_EV_BRANCH_TAKEN = 5'd4;
+  localparam HPM_EV_CYCLE        = 5'd5;
+  localparam HPM_EV_RETIRE       = 5'd6;
+
+  localparam VMASK_BITS = VLEN / 8; // elements at SEW=8
+  localparam [31:0] VMASK_ALL = {32{1'b1}} >> (32 - VMASK_BITS);
+
+  localparam IRQ_MSI   = 4'd3;
+  localparam IRQ_MTI   = 4'd7;
+  localparam IRQ_LCOFI = 4'd13;
+  localparam EXC_ECALL = 4'd11;
+
+  reg [63:0] mcycle;
+  reg [63:0] minstret;
+  reg [63:0] mhpmcounter [0:NUM_HPM-1];
+  reg [4:0]  mhpmevent [0:NUM_HPM-1];
+  reg [NUM_HPM-1:0] hpm_of;
+  reg [31:0] mcountinhibit;
+
+  reg        mstatus_mie;
+  reg        mstatus_mpie;
+  reg        mie_msie, mie_mtie, mie_lcofie;
+  reg        mip_lcofip;
+  reg [31:0] mtvec;
+  reg [31:0] mscratch;
+  reg [31:0] mepc;
+  reg [31:0] mcause;
+  reg [31:0] vmask; // bits past VMASK_BITS stay 0
+  reg [31:0] vl;
+  reg [1:0]  vtype;
+
+  wire [31:0] mstatus = {19'd0, 2'b11, 3'd0, mstatus_mpie, 3'd0, mstatus_mie, 3'd0};
+  wire [31:0] mie = {18'd0, mie_lcofie, 5'd0, mie_mtie, 3'd0, mie_msie, 3'd0};
+  wire [31:0] mip = {18'd0, mip_lcofip, 5'd0, timer_irq, 3'd0, soft_irq, 3'd0};
+
+  // read
+  integer i;
+  always @(*) begin
+    rdata = 32'd0;
+    case (addr)
+      12'hC00, 12'hB00: rdata = mcycle[31:0];
+      12'hC80, 12'hB80: rdata = mcycle[63:32];
+      12'hC01:          rdata = mtime[31:0];
+      12'hC81:          rdata = mtime[63:32];
+      12'hC02, 12'hB02: rdata = minstret[31:0];
+      12'hC82, 12'hB82: rdata = minstret[63:32];
+      12'h320:          rdata = mcountinhibit;
+      12'h300:          rdata = mstatus;
+      12'h304:          rdata = mie;
+      12'h305:          rdata = mtvec;
+      12'h340:          rdata = mscratch;
+      12'h341:          rdata = mepc;
+      12'h342:          rdata = mcause;
+      12'h344:          rdata = mip;
+      12'h800:          rdata = vmask;
+      12'hC20:          rdata = vl;
+      12'hC21:          rdata = {30'd0, vtype};
+      12'hC22:          rdata = VMASK_BITS;
+      default: begin
+        for (i = 0; i < NUM_HPM; i = i + 1) begin
+          if (addr == (12'hC03 + i[11:0]) || addr == (12'hB03 + i[11:0])) rdata = mhpmcounter[i][31:0];
+          if (addr == (12'hC83 + i[11:0]) || addr == (12'hB83 + i[11:0])) rdata = mhpmcounter[i][63:32];
+          if (addr == (12'h323 + i[11:0])) rdata = {hpm_of[i], 26'd0, mhpmevent[i]};
+        end
+      end
+    endcase
+  end
+
+  // write value of the read-modify-write
+  wire do_write = valid && (op == 2'b01 || !src_zero);
+  wire [31:0] wdata = (op == 2'b01) ? src :
+                      (op == 2'b10) ? (rdata | src) :
+                      (rdata & ~src);
+
+  // event selected by each mhpmevent
+  reg [NUM_HPM-1:0] hpm_hit;
+  integer j;
+  always @(*) begin
+    for (j = 0; j < NUM_HPM; j = j + 1) begin
+      case (mhpmevent[j])
+        HPM_EV_VEC_RETIRE:   hpm_hit[j] = ev_vec_retire;
+        HPM_EV_VLSU_BUSY:    hpm_hit[j] = ev_vlsu_busy;
+        HPM_EV_MEM_STALL:    hpm_hit[j] = ev_mem_stall;
+        HPM_EV_BRANCH_TAKEN: hpm_hit[j] = ev_branch_taken;
+        HPM_EV_CYCLE:        hpm_hit[j] = 1'b1;
+        HPM_EV_RETIRE:       hpm_hit[j] = ev_retire;
+        default:             hpm_hit[j] = 1'b0;
+      endcase
+    end
+  end
+
+  // VMSETL/VSETL: the strip is the elements left, at most one register full
+  wire [1:0] vset_sew = !vsetl ? vsew : (vsetl_sew == 2'b11) ? 2'b10 : vsetl_sew;
+  wire [31:0] vset_lanes = VMASK_BITS >> ((vset_sew == 2'b11) ? 2'b10 : vset_sew);
+  assign vset_grant = (vset_len < vset_lanes) ? vset_len : vset_lanes;
+  reg [31:0] vset_mask;
+  integer k;
+  always @(*) begin
+    for (k = 0; k < 32; k = k + 1) begin
+      vset_mask[k] = (k < vset_grant);
+    end
+  end
+
+  // element i of SEW covers bytes i*SEW/8 .. (i+1)*SEW/8-1
+  genvar b;
+  generate
+    for (b = 0; b < VMASK_BITS; b = b + 1) begin: gen_vmask_bytes
+      assign vmask_bytes[b] = (vsew == 2'b00) ? vmask[b] :
+                              (vsew == 2'b01) ? vmask[b / 2] : vmask[b / 4];
+      assign vl_bytes[b] = (b < (vl << vtype));
+    end
+  endgenerate
+  assign vtype_sew = vtype;
+
+  // interrupts, highest priority first: software, timer, counter overflow
+  wire msi = soft_irq && mie_msie;
+  wire mti = timer_irq && mie_mtie;
+  wire lcofi = mip_lcofip && mie_lcofie;
+  wire [3:0] irq_cause = msi ? IRQ_MSI : mti ? IRQ_MTI : IRQ_LCOFI;
+
+  assign irq_pending = mstatus_mie && (msi || mti || lcofi);
+  assign trap_vector = (mtvec[0] && !trap_ecall) ? {mtvec[31:2], 2'b00} + {26'd0, irq_cause, 2'b00} :
+                       {mtvec[31:2], 2'b00};
+  assign mepc_out = mepc;
+
+  integer n;
+  always @(posedge clk) begin
+    if (!resetn) begin
+      mcycle <= 64'd0;
+      minstret <= 64'd0;
+      mcountinhibit <= 32'd0;
+      for (n = 0; n < NUM_HPM; n = n + 1) begin
+        mhpmcounter[n] <= 64'd0;
+        mhpmevent[n] <= HPM_EV_NONE;
+      end
+      hpm_of <= {NUM_HPM{1'b0}};
+      mstatus_mie <= 1'b0;
+      mstatus_mpie <= 1'b0;
+      mie_msie <= 1'b0;
+      mie_mtie <= 1'b0;
+      mie_lcofie <= 1'b0;
+      mip_lcofip <= 1'b0;
+      mtvec <= 32'd0;
+      mscratch <= 32'd0;
+      mepc <= 32'd0;
+      mcause <= 32'd0;
+      vmask <= VMASK_ALL;
+      vl <= VMASK_BITS;
+      vtype <= 2'b00;
+    end else begin
+      if (!mcountinhibit[0]) mcycle <= mcycle + 64'd1;
+      if (!mcountinhibit[2] && ev_retire) minstret <= minstret + 64'd1;
+      for (n = 0; n < NUM_HPM; n = n + 1) begin
+        if (!mcountinhibit[3 + n] && hpm_hit[n]) begin
+          mhpmcounter[n] <= mhpmcounter[n] + 64'd1;
+          if (mhpmcounter[n] == {64{1'b1}}) begin
+            hpm_of[n] <= 1'b1;
+            if (!hpm_of[n]) mip_lcofip <= 1'b1;
+          end
+        end
+      end
+
+      if (trap_take) begin
+        mepc <= trap_pc;
+        mcause <= trap_ecall ? {28'd0, EXC_ECALL} : {1'b1, 27'd0, irq_cause};
+        mstatus_mpie <= mstatus_mie;
+        mstatus_mie <= 1'b0;
+      end else if (mret) begin
+        mstatus_mie <= mstatus_mpie;
+        mstatus_mpie <= 1'b1;
+      end
+
+      if (vset) begin
+        vmask <= vset_mask;
+      end
+      if (vsetl) begin
+        vl <= vset_grant;
+        vtype <= vset_sew;
+      end
 
+      // CSR writes win over the increments
+      if (do_write) begin
+        case (addr)
+          12'hB00: mcycle[31:0] <= wdata;
+          12'hB80: mcycle[63:32] <= wdata;
+          12'hB02: minstret[31:0] <= wdata;
+          12'hB82: minstret[63:32] <= wdata;
+          12'h320: mcountinhibit <= wdata & {{(29 - NUM_HPM){1'b0}}, {NUM_HPM{1'b1}}, 3'b101};
+          12'h300: begin
+            mstatus_mie <= wdata[3];
+            mstatus_mpie <= wdata[7];
+          end
+          12'h304: begin
+            mie_msie <= wdata[3];
+            mie_mtie <= wdata[7];
+            mie_lcofie <= wdata[13];
+          end
+          12'h305: mtvec <= {wdata[31:2], 1'b0, wdata[0]};
+          12'h340: mscratch <= wdata;
+          12'h341: mepc <= {wdata[31:1], 1'b0}; // IALIGN=16 with RVC
+          12'h342: mcause <= wdata;
+          12'h344: mip_lcofip <= wdata[13]; // MSIP/MTIP come from the CLINT
+          12'h800: vmask <= wdata & VMASK_ALL;
+          default: begin
+            for (n = 0; n < NUM_HPM; n = n + 1) begin
+              if (addr == (12'hB03 + n[11:0])) mhpmcounter[n][31:0] <= wdata;
+              if (addr == (12'hB83 + n[11:0])) mhpmcounter[n][63:32] <= wdata;
+              if (addr == (12'h323 + n[11:0])) begin
+                mhpmevent[n] <= wdata[4:0];
+                hpm_of[n] <= wdata[31];
+              end
+            end
+          end
+        endcase
+      end
+    end
+  end
 
-endmodule
\ No newline at end of file
+endmodule
@@ -1,7 +1,9 @@
 
 // Combined decoder and control unit
 // Decodes instruction and generates all control signals
-module decoder_control (
+module decoder_control #(
+  parameter VLEN = 64 // vector register width, the VLD.PI/VST.PI increment is VLEN/8
+) (
   input [31:0] insn,
 
   // Decoded fields (outputs for use in datapath)
@@ -34,16 +36,35 @@ module decoder_control (
   // 7.6 Performance counter signals (from Lab 5)
   output            is_rdwrctr,
   output            rdwrctr_wen,
-  output [1:0]      rdwrctr_ctr_id,
+  output [2:0]      rdwrctr_ctr_id,
 
   // new vector extension signals
   output is_vec_op,
-  output reg [2:0] vec_op,
-  output reg [1:0] vec_sew, // element width (00=8, 01=16, 10=32)
+  output reg [3:0] vec_op, // VALU op; VLD/VST reuse 1000/1001 but go to the VLSU
+  output reg [1:0] vec_sew, // element width (00=8, 01=16, 10=32, 11=vtype)
   output is_vec_load,
   output is_vec_store,
   output vec_reg_write,
-  output is_vec_vmac  // VMAC.B writes to scalar register
+  output is_vec_vmac, // VMAC/VREDACC/VMOV_V2S/reductions write to scalar register
+  output vec_vx, // the rs2 field is a scalar register (.vx forms: broadcast as vs2; VNCLIP)
+  output vec_base_write, // post-increment VLD/VST: rs1 <= rs1 + imm/rs2 (ALU result)
+  output reg [1:0] vec_ld_mode, // VLD addressing: 00 unit, 01 strided (rs2), 10 indexed (vs2)
+  output vec_masked, // funct3=110: only the elements enabled in vmask are active
+  output is_vset, // VMSETL rd, rs1: vmask = first min(rs1, VLEN/SEW) elements, rd = that count
+  output is_vsetl, // VSETL rd, rs1, rs2: vtype = rs2, vl = min(rs1, VLEN/SEW), rd = vl
+
+  // M extension
+  output is_muldiv,
+  output [2:0] muldiv_ctrl, // funct3
+
+  // Zicsr: CSRRW/CSRRS/CSRRC(I), address in imm[11:0]
+  output is_csr,
+  output [2:0] csr_op, // funct3, bit 2 = uimm form (rs1 field is the zero-extended operand)
+  output is_ecall,
+  output is_mret,
+
+  // hardware loop: lp.setup rs1, end (imm = halfwords to the last body instruction)
+  output is_lpsetup
 );
 
   // Extract fields from instruction
@@ -59,14 +80,23 @@ module decoder_control (
   wire is_b_type = (opcode == 7'b1100011);
   wire is_u_type = (opcode == 7'b0110111) || (opcode == 7'b0010111);
   wire is_j_type = (opcode == 7'b1101111);
+  // M extension: R-type with funct7=0000001
+  wire is_muldiv_type = is_r_type && (funct7 == 7'b0000001);
+  // Zicsr: SYSTEM with funct3 != 000 (ECALL/EBREAK) and != 100 (reserved)
+  wire is_csr_type = (opcode == 7'b1110011) && (funct3[1:0] != 2'b00);
   // 7.2 VMAC type
   wire is_vmac_type = (opcode == 7'b1011011) && (funct3 == 3'b001);  // Opcode=0x5B, funct3=001
   // 7.6 RDWRCTR type (from Lab 5)
   wire is_rdwrctr_type = (opcode == 7'b1011011) && (funct3 == 3'b000);  // Opcode=0x5B, funct3=000
 
   // new vector extension types
-  // opcode=0x5B, funct3=010 for new vector instructions
-  wire is_vec_type = (opcode == 7'b1011011) && (funct3 == 3'b010);
+  // opcode=0x5B, funct3=010 for new vector instructions, 110 for their masked forms
+  wire is_vec_type = (opcode == 7'b1011011) && (funct3[1:0] == 2'b10);
+  // vector configuration: opcode=0x5B, funct3=111, SEW in funct7[6:5]
+  wire is_vcfg_type = (opcode == 7'b1011011) && (funct3 == 3'b111);
+
+  // hardware loop setup: opcode=0x5B, funct3=011, I-type, rd unused
+  wire is_lpsetup_type = (opcode == 7'b1011011) && (funct3 == 3'b011);
 
   // vector operation codes from funct7[4:0]
   localparam VOP_VADD = 5'b00000;
@@ -75,8 +105,31 @@ module decoder_control (
   localparam VOP_VMAC = 5'b00011;     // 8-lane MAC (multiply-accumulate, result is scalar)
   localparam VOP_VLD = 5'b00100;
   localparam VOP_VST = 5'b00101;
+  localparam VOP_VLD_PI = 5'b00110;   // VLD, then rs1 += VLEN/8
+  localparam VOP_VST_PI = 5'b00111;   // VST, then rs1 += VLEN/8
+  localparam VOP_VLD_PR = 5'b01100;   // VLD, then rs1 += rs2
+  localparam VOP_VLDS = 5'b01101;     // strided: element k from rs1 + k*rs2
+  localparam VOP_VLDX = 5'b01110;     // indexed: element k from rs1 + vs2[k]
   localparam VOP_VMOV_S2V = 5'b01000; // scalar to vector
   localparam VOP_VMOV_V2S = 5'b01001; // vector to scalar
+  localparam VOP_VMACC = 5'b01010;    // per-lane multiply-accumulate into the VALU accumulator
+  localparam VOP_VREDACC = 5'b01011;  // sum of the accumulator lanes to rd, clears it
+  localparam VOP_VADD_VX = 5'b10000;  // .vx forms: vs2 is rs2 in every lane
+  localparam VOP_VSUB_VX = 5'b10001;
+  localparam VOP_VMUL_VX = 5'b10010;
+  localparam VOP_VMAC_VX = 5'b10011;
+  localparam VOP_VNCLIP = 5'b10100;   // int32 lanes -> SEW (rounding shift, offset, saturate)
+  localparam VOP_VNCLIP_RELU = 5'b10101; // same, clamped at 0
+  localparam VOP_VREDSUM = 5'b10110;  // reductions of vs1 to rd
+  localparam VOP_VREDMAX = 5'b10111;
+  localparam VOP_VREDMIN = 5'b11000;
+  localparam VOP_VARGMAX = 5'b11001;  // lane of the maximum
+  localparam VOP_VNCLIP_ACC = 5'b11010; // VALU accumulator lanes -> int8, clears it
+  localparam VOP_VNCLIP_ACC_RELU = 5'b11011; // same, clamped at 0
+
+  // vector configuration codes from funct7[4:0] (funct3=111)
+  localparam VCFG_VMSETL = 5'b00000; // mask of the next strip from a remaining count
+  localparam VCFG_VSETL = 5'b00001; // SEW and length of the next strip
 
   assign rd  = insn[11:7];
   assign rs1 = is_u_type ? 5'b00000 : insn[19:15];
@@ -89,8 +142,14 @@ module decoder_control (
   wire [31:0] imm_u = {insn[31:12], 12'b0};
   wire [31:0] imm_j = {{11{insn[31]}}, insn[31], insn[19:12], insn[20], insn[30:21], 1'b0};
 
+  // post-increment forms, the ALU adds the increment to rs1
+  wire is_vec_pi = is_vec_type && (funct7[4:0] == VOP_VLD_PI || funct7[4:0] == VOP_VST_PI);
+  wire is_vec_pr = is_vec_type && (funct7[4:0] == VOP_VLD_PR);
+  wire [31:0] imm_vinc = VLEN / 8;
+
   // Select appropriate immediate
-  assign imm = is_i_type ? imm_i :
+  assign imm = (is_i_type || is_lpsetup_type) ? imm_i :
+               is_vec_pi ? imm_vinc :
                is_s_type ? imm_s :
                is_b_type ? imm_b :
                is_u_type ? imm_u :
@@ -111,7 +170,7 @@ module decoder_control (
         10'b0100000_101: alu_ctrl = 4'b0111; // SRA
         10'b0000000_010: alu_ctrl = 4'b1000; // SLT
         10'b0000000_011: alu_ctrl = 4'b1001; // SLTU
-        default:         alu_ctrl = 4'bxxxx;
+        default:         alu_ctrl = is_muldiv_type ? 4'b0000 : 4'bxxxx; // MUL/DIV: result from muldiv
       endcase
     end else if (is_i_type && opcode == 7'b0010011) begin // OP-IMM
       case (funct3)
@@ -134,6 +193,8 @@ module decoder_control (
         3'b110, 3'b111: alu_ctrl = 4'b1001; // BLTU, BGEU (SLTU)
         default:        alu_ctrl = 4'bxxxx;
       endcase
+    end else if (is_vec_pi || is_vec_pr) begin
+      alu_ctrl = 4'b0000; // ADD: rs1 + increment
     // 7.2 VMAC ALU control
     end else if (is_vmac_type || is_vec_type) begin
       alu_ctrl = 4'bxxxx;  
@@ -145,8 +206,8 @@ module decoder_control (
   // new vector extension control signals
   // SEW decoding from funct7[6:5]
   always @(*) begin
-    if (is_vec_type) begin
-      vec_sew = funct7[6:5]; // 00=8bit, 01=16bit, 10=32bit
+    if (is_vec_type || is_vcfg_type) begin
+      vec_sew = funct7[6:5]; // 00=8bit, 01=16bit, 10=32bit, 11=from vtype (core resolves)
     end else begin
       vec_sew = 2'b00;
     end
@@ -156,37 +217,80 @@ module decoder_control (
   always @(*) begin
     if (is_vec_type) begin
       case (funct7[4:0])
-        VOP_VADD: vec_op = 3'b000; // VADD -> VALU op=00
-        VOP_VSUB: vec_op = 3'b001; // VSUB -> VALU op=01
-        VOP_VMUL: vec_op = 3'b010; // VMUL -> VALU op=10
-        VOP_VMAC: vec_op = 3'b011; // VMAC -> VALU op=11 (8-lane MAC, scalar result)
-        VOP_VLD:  vec_op = 3'b100; // VLD
-        VOP_VST:  vec_op = 3'b101; // VST
-        VOP_VMOV_S2V: vec_op = 3'b110; // VMOV_S2V
-        VOP_VMOV_V2S: vec_op = 3'b111; // VMOV_V2S
-        default: vec_op = 3'b000;
+        VOP_VADD: vec_op = 4'b0000; // VADD -> VALU op=000
+        VOP_VSUB: vec_op = 4'b0001; // VSUB -> VALU op=001
+        VOP_VMUL: vec_op = 4'b0010; // VMUL -> VALU op=010
+        VOP_VMAC: vec_op = 4'b0011; // VMAC -> VALU op=011 (8-lane MAC, scalar result)
+        VOP_VMACC: vec_op = 4'b0100; // VMACC -> VALU op=100 (accumulator, no result)
+        VOP_VREDACC: vec_op = 4'b0101; // VREDACC -> VALU op=101 (scalar result)
+        VOP_VLD, VOP_VLD_PI, VOP_VLD_PR,
+        VOP_VLDS, VOP_VLDX: vec_op = 4'b1000; // VLD
+        VOP_VST, VOP_VST_PI: vec_op = 4'b1001; // VST
+        VOP_VMOV_S2V: vec_op = 4'b0110; // VMOV_S2V -> VALU op=110 (vd[lane] = rs1)
+        VOP_VMOV_V2S: vec_op = 4'b0111; // VMOV_V2S -> VALU op=111 (rd = vs1[lane])
+        VOP_VADD_VX: vec_op = 4'b0000;
+        VOP_VSUB_VX: vec_op = 4'b0001;
+        VOP_VMUL_VX: vec_op = 4'b0010;
+        VOP_VMAC_VX: vec_op = 4'b0011;
+        VOP_VNCLIP: vec_op = 4'b1010; // VNCLIP -> VALU op=1010
+        VOP_VNCLIP_RELU: vec_op = 4'b1011; // VNCLIP.RELU -> VALU op=1011
+        VOP_VREDSUM: vec_op = 4'b1100; // VREDSUM -> VALU op=1100 (scalar result)
+        VOP_VREDMAX: vec_op = 4'b1101; // VREDMAX -> VALU op=1101 (scalar result)
+        VOP_VREDMIN: vec_op = 4'b1110; // VREDMIN -> VALU op=1110 (scalar result)
+        VOP_VARGMAX: vec_op = 4'b1111; // VARGMAX -> VALU op=1111 (scalar result)
+        VOP_VNCLIP_ACC: vec_op = 4'b1000; // VNCLIP.ACC -> VALU op=1000 (not a load)
+        VOP_VNCLIP_ACC_RELU: vec_op = 4'b1001; // VNCLIP.ACC.RELU -> VALU op=1001
+        default: vec_op = 4'b0000;
       endcase
     end else begin
-      vec_op = 3'b000;
+      vec_op = 4'b0000;
     end
   end
 
   // vector conrol signal assignments
   assign is_vec_op = is_vec_type;
-  assign is_vec_load = is_vec_type && (funct7[4:0] == VOP_VLD);
-  assign is_vec_store = is_vec_type && (funct7[4:0] == VOP_VST);
+  assign is_vec_load = is_vec_type && (funct7[4:0] == VOP_VLD || funct7[4:0] == VOP_VLD_PI ||
+                                      funct7[4:0] == VOP_VLD_PR || funct7[4:0] == VOP_VLDS ||
+                                      funct7[4:0] == VOP_VLDX);
+  assign is_vec_store = is_vec_type && (funct7[4:0] == VOP_VST || funct7[4:0] == VOP_VST_PI);
+  assign vec_base_write = is_vec_pi || is_vec_pr;
+  assign vec_masked = is_vec_type && funct3[2];
+  assign is_vset = is_vcfg_type && (funct7[4:0] == VCFG_VMSETL);
+  assign is_vsetl = is_vcfg_type && (funct7[4:0] == VCFG_VSETL);
+
+  always @(*) begin
+    if (is_vec_type && funct7[4:0] == VOP_VLDS) begin
+      vec_ld_mode = 2'b01;
+    end else if (is_vec_type && funct7[4:0] == VOP_VLDX) begin
+      vec_ld_mode = 2'b10;
+    end else begin
+      vec_ld_mode = 2'b00;
+    end
+  end
   
-  // is_vec_vmac: VMAC result goes to scalar register, not vector register
-  assign is_vec_vmac = is_vec_type && (funct7[4:0] == VOP_VMAC);
+  // is_vec_vmac: VMAC/VREDACC/VMOV_V2S/reduction result goes to scalar register, not vector register
+  assign is_vec_vmac = is_vec_type && (funct7[4:0] == VOP_VMAC || funct7[4:0] == VOP_VREDACC ||
+                                       funct7[4:0] == VOP_VMAC_VX || funct7[4:0] == VOP_VMOV_V2S ||
+                                       funct7[4:0] == VOP_VREDSUM || funct7[4:0] == VOP_VREDMAX ||
+                                       funct7[4:0] == VOP_VREDMIN || funct7[4:0] == VOP_VARGMAX);
+  assign vec_vx = is_vec_type && (funct7[4:2] == 3'b100 || funct7[4:0] == VOP_VNCLIP ||
+                                  funct7[4:0] == VOP_VNCLIP_RELU || funct7[4:1] == 4'b1101);
 
-  // write to vector register for: VADD, VSUB, VMUL, VLD, VMOV_S2V
+  // write to vector register for: VADD, VSUB, VMUL (.vv/.vx), VLD (all forms), VMOV_S2V, VNCLIP[.ACC]
   // Note: VMAC writes to scalar register, not vector register
   assign vec_reg_write = is_vec_type &&
                           (funct7[4:0] == VOP_VADD ||
                            funct7[4:0] == VOP_VSUB ||
                            funct7[4:0] == VOP_VMUL ||
-                           funct7[4:0] == VOP_VLD ||
-                           funct7[4:0] == VOP_VMOV_S2V);
+                           funct7[4:0] == VOP_VADD_VX ||
+                           funct7[4:0] == VOP_VSUB_VX ||
+                           funct7[4:0] == VOP_VMUL_VX ||
+                           is_vec_load ||
+                           funct7[4:0] == VOP_VMOV_S2V ||
+                           funct7[4:0] == VOP_VNCLIP ||
+                           funct7[4:0] == VOP_VNCLIP_RELU ||
+                           funct7[4:0] == VOP_VNCLIP_ACC ||
+                           funct7[4:0] == VOP_VNCLIP_ACC_RELU);
   
   // Memory mask
   always @(*) begin
@@ -215,7 +319,7 @@ module decoder_control (
     end
   end
   // Control signals
-  assign alu_src2_sel = is_i_type || is_s_type || is_u_type;
+  assign alu_src2_sel = is_i_type || is_s_type || is_u_type || is_vec_pi;
   assign mem_write = is_s_type;
   assign mem_read  = (is_i_type && opcode == 7'b0000011);
   assign wb_from_mem = mem_read;
@@ -231,16 +335,30 @@ module decoder_control (
   // 7.2 modified reg_write
   // 7.6 added RDWRCTR read (not write)
   // VMAC.B (vec_type) also writes to scalar register
-  assign reg_write = (!is_b_type && !is_s_type && !is_vec_type) || is_vmac_type || (is_rdwrctr_type && !insn[31]) || is_vec_vmac;
+  assign reg_write = (!is_b_type && !is_s_type && !is_vec_type && !is_lpsetup_type) || is_vmac_type || (is_rdwrctr_type && !insn[31]) || is_vec_vmac;
 
-  assign ebreak_hit = (is_i_type && opcode == 7'b1110011) && (funct3 == 3'b000);
+  // SYSTEM funct3=000: ECALL (imm 0x000), EBREAK (0x001), MRET (0x302), WFI (0x105, runs as a NOP)
+  wire is_priv_type = (opcode == 7'b1110011) && (funct3 == 3'b000);
+  assign ebreak_hit = is_priv_type && (insn[31:20] == 12'h001);
+  assign is_ecall = is_priv_type && (insn[31:20] == 12'h000);
+  assign is_mret = is_priv_type && (insn[31:20] == 12'h302);
 
   // 7.2 modified is_vmac
   assign is_vmac = is_vmac_type;
 
+  // M extension
+  assign is_muldiv = is_muldiv_type;
+  assign muldiv_ctrl = funct3;
+
+  // Zicsr
+  assign is_csr = is_csr_type;
+  assign csr_op = funct3;
+
+  assign is_lpsetup = is_lpsetup_type;
+
   // 7.6 Performance counter signals (from Lab 5)
   assign is_rdwrctr = is_rdwrctr_type;
   assign rdwrctr_wen = is_rdwrctr_type && insn[31];  // imm[11] is insn[31], 1=write, 0=read
-  assign rdwrctr_ctr_id = insn[21:20];  // imm[1:0] is insn[21:20], counter ID
+  assign rdwrctr_ctr_id = insn[22:20];  // imm[2:0] is insn[22:20], counter ID (4/5 = prefetch useful/useless)
 
 endmodule
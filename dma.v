@@ -0,0 +1,156 @@
+// MMIO DMA engine for background copies between SRAM and the vector scratchpad
+// Copies ROWS rows of LEN bytes (word granular). After each row the source and
+// destination advance by their own stride, so a 2D block (weight tile) can be
+// gathered out of a larger matrix. The core keeps priority on the data ports;
+// the engine only issues a request in cycles where the core does not.
+
+module dma (
+  input wire clk,
+  input wire resetn,
+
+  // register port (MMIO slave, 1-cycle read response)
+  input wire [4:0] reg_addr,
+  input wire [31:0] reg_wdata,
+  input wire reg_write,
+  input wire reg_valid,
+  output reg [31:0] reg_rdata,
+  output reg reg_resp_valid,
+
+  // memory master port (one outstanding read)
+  output wire [31:0] m_addr,
+  output wire [31:0] m_wdata,
+  output wire m_write,
+  output wire m_valid,
+  input wire m_ready,
+  input wire m_resp_valid,
+  input wire [31:0] m_resp_rdata
+);
+
+// address map
+// 00: src        source address (word aligned)
+// 04: dst        destination address (word aligned)
+// 08: len        bytes per row (multiple of 4)
+// 0c: rows       number of rows (0 is treated as 1)
+// 10: src_stride bytes between source rows
+// 14: dst_stride bytes between destination rows
+// 18: ctrl       write bit0 = start (ignored while busy)
+// 1c: status     bit0 = busy, bit1 = done (write 1 to bit1 to clear)
+
+reg [31:0] src, dst, len, rows, src_stride, dst_stride;
+reg busy, done;
+
+localparam S_IDLE  = 2'd0;
+localparam S_READ  = 2'd1;
+localparam S_WAIT  = 2'd2;
+localparam S_WRITE = 2'd3;
+
+reg [1:0] state;
+reg [31:0] src_row, dst_row; // start of the current row
+reg [31:0] col;              // byte offset inside the row
+reg [31:0] row;
+reg [31:0] data;
+
+assign m_valid = (state == S_READ) || (state == S_WRITE);
+assign m_write = (state == S_WRITE);
+assign m_addr = (state == S_WRITE) ? (dst_row + col) : (src_row + col);
+assign m_wdata = data;
+
+wire last_col = (col + 32'd4 >= len);
+wire last_row = (row + 32'd1 >= rows);
+
+always @(posedge clk) begin
+  if (!resetn) begin
+    src <= 32'd0;
+    dst <= 32'd0;
+    len <= 32'd0;
+    rows <= 32'd0;
+    src_stride <= 32'd0;
+    dst_stride <= 32'd0;
+    busy <= 1'b0;
+    done <= 1'b0;
+    state <= S_IDLE;
+    reg_resp_valid <= 1'b0;
+    reg_rdata <= 32'd0;
+  end else begin
+    // register access
+    reg_resp_valid <= reg_valid && !reg_write;
+    if (reg_valid && !reg_write) begin
+      case (reg_addr[4:2])
+        3'd0: reg_rdata <= src;
+        3'd1: reg_rdata <= dst;
+        3'd2: reg_rdata <= len;
+        3'd3: reg_rdata <= rows;
+        3'd4: reg_rdata <= src_stride;
+        3'd5: reg_rdata <= dst_stride;
+        3'd6: reg_rdata <= 32'd0;
+        3'd7: reg_rdata <= {30'd0, done, busy};
+      endcase
+    end
+    if (reg_valid && reg_write) begin
+      case (reg_addr[4:2])
+        3'd0: src <= reg_wdata;
+        3'd1: dst <= reg_wdata;
+        3'd2: len <= reg_wdata;
+        3'd3: rows <= reg_wdata;
+        3'd4: src_stride <= reg_wdata;
+        3'd5: dst_stride <= reg_wdata;
+        3'd6: begin
+          if (reg_wdata[0] && !busy) begin
+            busy <= 1'b1;
+            done <= 1'b0;
+            src_row <= src;
+            dst_row <= dst;
+            col <= 32'd0;
+            row <= 32'd0;
+            state <= (len == 32'd0) ? S_IDLE : S_READ;
+            if (len == 32'd0) begin
+              busy <= 1'b0;
+              done <= 1'b1;
+            end
+          end
+        end
+        3'd7: begin
+          if (reg_wdata[1]) begin
+            done <= 1'b0;
+          end
+        end
+      endcase
+    end
+
+    // copy engine, one word at a time
+    case (state)
+      S_READ: begin
+        if (m_ready) begin
+          state <= S_WAIT;
+        end
+      end
+      S_WAIT: begin
+        if (m_resp_valid) begin
+          data <= m_resp_rdata;
+          state <= S_WRITE;
+        end
+      end
+      S_WRITE: begin
+        if (m_ready) begin
+          if (!last_col) begin
+            col <= col + 32'd4;
+            state <= S_READ;
+          end else if (!last_row) begin
+            col <= 32'd0;
+            row <= row + 32'd1;
+            src_row <= src_row + src_stride;
+            dst_row <= dst_row + dst_stride;
+            state <= S_READ;
+          end else begin
+            busy <= 1'b0;
+            done <= 1'b1;
+            state <= S_IDLE;
+          end
+        end
+      end
+      default: ;
+    endcase
+  end
+end
+
+endmodule
@@ -0,0 +1,100 @@
+// instruction prefetch buffer for the multi-cycle core
+// The imem port is idle while an instruction is in DECODE/EXEC/MEM/WB, so this
+// keeps fetching the following instructions into a small FIFO. When the core
+// reaches WB and the next PC is at the head, it goes straight to DECODE and
+// STATE_FETCH is skipped.
+//
+//  - imem returns the word one cycle after the address, the word arriving in
+//    the current cycle is visible at the head before it is written to the FIFO
+//  - with RVC the next address depends on the length of the arriving
+//    instruction (low bits != 11: 2 bytes), so it is computed from imem_rdata;
+//    entries hold the raw 32-bit window, the core expands it
+//  - `flush` drops everything and restarts fetching at `flush_pc` in the same
+//    cycle (taken branch/jump in EXEC, or a head that does not match the PC)
+//  - stores are not snooped: as on any RISC-V core without Zifencei,
+//    self-modifying code needs an explicit flush
+
+module iprefetch #(
+    parameter DEPTH = 2 // buffered instructions, power of 2
+)(
+    input wire clk,
+    input wire rst_n,
+    input wire enable,
+
+    // instruction memory port
+    output wire [31:0] imem_addr,
+    input wire [31:0] imem_rdata,
+
+    // redirect
+    input wire flush,
+    input wire [31:0] flush_pc,
+
+    // oldest instruction
+    output wire head_valid,
+    output wire [31:0] head_pc,
+    output wire [31:0] head_insn,
+    input wire pop
+);
+
+    localparam PTR_BITS = (DEPTH > 1) ? $clog2(DEPTH) : 1;
+
+    reg [31:0] q_pc [0:DEPTH-1];
+    reg [31:0] q_insn [0:DEPTH-1];
+    reg [PTR_BITS-1:0] rd_ptr, wr_ptr;
+    reg [PTR_BITS:0] count;
+
+    reg req_valid;      // imem_rdata holds the word at req_pc this cycle
+    reg [31:0] req_pc;
+    reg [31:0] next_pc; // next sequential address to request, when no word is arriving
+
+    assign head_valid = (count != 0) || req_valid;
+    assign head_pc = (count != 0) ? q_pc[rd_ptr] : req_pc;
+    assign head_insn = (count != 0) ? q_insn[rd_ptr] : imem_rdata;
+
+    wire pop_q = pop && (count != 0);      // pop a buffered word
+    wire pop_in = pop && (count == 0);     // consume the arriving word directly
+    wire push = req_valid && !pop_in;
+    wire [PTR_BITS:0] count_next = count - {{PTR_BITS{1'b0}}, pop_q} + {{PTR_BITS{1'b0}}, push};
+    // only request what has room when it arrives
+    wire issue = enable && (count_next < DEPTH);
+
+    wire [31:0] follow_pc = req_pc + ((imem_rdata[1:0] == 2'b11) ? 32'd4 : 32'd2);
+    wire [31:0] fetch_pc = req_valid ? follow_pc : next_pc;
+
+    assign imem_addr = flush ? flush_pc : fetch_pc;
+
+    always @(posedge clk) begin
+        if (!rst_n) begin
+            rd_ptr <= {PTR_BITS{1'b0}};
+            wr_ptr <= {PTR_BITS{1'b0}};
+            count <= {(PTR_BITS+1){1'b0}};
+            req_valid <= 1'b0;
+            req_pc <= 32'd0;
+            next_pc <= 32'd0;
+        end else if (flush) begin
+            rd_ptr <= {PTR_BITS{1'b0}};
+            wr_ptr <= {PTR_BITS{1'b0}};
+            count <= {(PTR_BITS+1){1'b0}};
+            req_valid <= enable;
+            req_pc <= flush_pc;
+            next_pc <= flush_pc;
+        end else begin
+            if (push) begin
+                q_pc[wr_ptr] <= req_pc;
+                q_insn[wr_ptr] <= imem_rdata;
+                wr_ptr <= wr_ptr + 1'b1;
+            end
+            if (pop_q) begin
+                rd_ptr <= rd_ptr + 1'b1;
+            end
+            count <= count_next;
+
+            req_valid <= issue;
+            next_pc <= fetch_pc;
+            if (issue) begin
+                req_pc <= fetch_pc;
+            end
+        end
+    end
+
+endmodule
@@ -0,0 +1,157 @@
+// RV32M multiply / divide unit
+// Same handshake as vmac: valid_in pulse starts an operation, valid_out is a
+// 1-cycle pulse, result holds until the next operation.
+//
+// MUL/MULH/MULHSU/MULHU: 2-stage pipeline (partial products, then sum/select),
+//   a new multiply can start every cycle, result after 2 cycles
+// DIV/DIVU/REM/REMU: radix-4 restoring divider (2 quotient bits per cycle)
+//   with early termination: leading zero bit pairs of the dividend are skipped,
+//   |a| < |b|, divide by zero and signed overflow finish in 1 cycle
+
+module muldiv(
+    input wire clk,
+    input wire rst_n, // for active low reset
+    input wire [2:0] ctrl, // funct3: 000 MUL, 001 MULH, 010 MULHSU, 011 MULHU, 100 DIV, 101 DIVU, 110 REM, 111 REMU
+    input wire [31:0] a, // rs1
+    input wire [31:0] b, // rs2
+    input wire valid_in,
+    output reg valid_out,
+    output reg [31:0] result
+);
+
+    //=========================================================================
+    // Multiplier
+    //=========================================================================
+
+    // operands extended to 33 bits, signed or unsigned per funct3
+    wire a_signed = (ctrl == 3'b001) || (ctrl == 3'b010); // MULH, MULHSU
+    wire b_signed = (ctrl == 3'b001);                     // MULH
+    wire signed [32:0] mul_a = {a_signed & a[31], a};
+    wire signed [32:0] mul_b = {b_signed & b[31], b};
+
+    // stage 1: two 33x17 partial products (low 16 bits of b, high 17 bits of b)
+    wire signed [17:0] mul_b_lo = {2'b00, mul_b[15:0]};
+    wire signed [16:0] mul_b_hi = mul_b[32:16];
+    reg signed [50:0] pp_lo;
+    reg signed [49:0] pp_hi;
+    reg mul_v1;     // stage 1 holds a multiply
+    reg mul_upper;  // result is product[63:32]
+
+    // stage 2: sum (64 bits are enough for MULH/MULHSU/MULHU)
+    wire signed [63:0] product = {{13{pp_lo[50]}}, pp_lo} + ({{14{pp_hi[49]}}, pp_hi} <<< 16);
+
+    //=========================================================================
+    // Divider
+    //=========================================================================
+
+    wire div_signed = !ctrl[0];  // DIV, REM
+    wire div_rem = ctrl[1];      // REM, REMU
+    wire a_neg = div_signed && a[31];
+    wire b_neg = div_signed && b[31];
+    wire [31:0] a_abs = a_neg ? -a : a;
+    wire [31:0] b_abs = b_neg ? -b : b;
+
+    // leading all-zero bit pairs of the dividend, skipped by the divider
+    function [4:0] lz_pairs;
+        input [31:0] x;
+        integer i;
+        begin
+            lz_pairs = 5'd16;
+            for (i = 0; i < 16; i = i + 1) begin
+                if (x[2*i +: 2] != 2'b00) begin
+                    lz_pairs = 5'd15 - i[4:0];
+                end
+            end
+        end
+    endfunction
+
+    wire [4:0] a_skip = lz_pairs(a_abs);
+
+    reg div_busy;
+    reg div_rem_reg;
+    reg q_neg, r_neg;
+    reg [31:0] divisor;
+    reg [31:0] rem_acc;  // partial remainder, always < divisor
+    reg [31:0] quo;      // dividend bits shifted out at the top, quotient bits in at the bottom
+    reg [4:0] steps;     // remaining radix-4 steps
+
+    // one radix-2 step, applied twice per cycle; the borrow of the subtraction
+    // is the compare (shifted remainder < 2*divisor, so the difference fits 32 bits)
+    wire [32:0] rem_sh1 = {rem_acc, quo[31]};
+    wire [32:0] diff1 = rem_sh1 - {1'b0, divisor};
+    wire [31:0] rem_1 = diff1[32] ? rem_sh1[31:0] : diff1[31:0];
+    wire [31:0] quo_1 = {quo[30:0], !diff1[32]};
+
+    wire [32:0] rem_sh2 = {rem_1, quo_1[31]};
+    wire [32:0] diff2 = rem_sh2 - {1'b0, divisor};
+    wire [31:0] rem_2 = diff2[32] ? rem_sh2[31:0] : diff2[31:0];
+    wire [31:0] quo_2 = {quo_1[30:0], !diff2[32]};
+
+    wire [31:0] q_final = q_neg ? -quo_2 : quo_2;
+    wire [31:0] r_final = r_neg ? -rem_2 : rem_2;
+
+    always @(posedge clk) begin
+        if (!rst_n) begin
+            valid_out <= 1'b0;
+            result <= 32'b0;
+            mul_v1 <= 1'b0;
+            mul_upper <= 1'b0;
+            div_busy <= 1'b0;
+            div_rem_reg <= 1'b0;
+            q_neg <= 1'b0;
+            r_neg <= 1'b0;
+            steps <= 5'd0;
+        end else begin
+            valid_out <= 1'b0;
+
+            // multiplier stage 1
+            mul_v1 <= valid_in && !ctrl[2];
+            if (valid_in && !ctrl[2]) begin
+                pp_lo <= mul_a * mul_b_lo;
+                pp_hi <= mul_a * mul_b_hi;
+                mul_upper <= (ctrl != 3'b000);
+            end
+
+            // multiplier stage 2
+            if (mul_v1) begin
+                result <= mul_upper ? product[63:32] : product[31:0];
+                valid_out <= 1'b1;
+            end
+
+            // divider
+            if (valid_in && ctrl[2] && !div_busy) begin
+                if (b == 32'd0) begin
+                    // divide by zero: quotient all ones, remainder = dividend
+                    result <= div_rem ? a : 32'hFFFFFFFF;
+                    valid_out <= 1'b1;
+                end else if (div_signed && a == 32'h80000000 && b == 32'hFFFFFFFF) begin
+                    // signed overflow: quotient = dividend, remainder = 0
+                    result <= div_rem ? 32'd0 : a;
+                    valid_out <= 1'b1;
+                end else if (a_abs < b_abs) begin
+                    result <= div_rem ? a : 32'd0;
+                    valid_out <= 1'b1;
+                end else begin
+                    div_busy <= 1'b1;
+                    div_rem_reg <= div_rem;
+                    q_neg <= a_neg ^ b_neg;
+                    r_neg <= a_neg;
+                    divisor <= b_abs;
+                    rem_acc <= 32'd0;
+                    quo <= a_abs << {a_skip, 1'b0};
+                    steps <= 5'd16 - a_skip;
+                end
+            end else if (div_busy) begin
+                rem_acc <= rem_2;
+                quo <= quo_2;
+                steps <= steps - 5'd1;
+                if (steps == 5'd1) begin
+                    result <= div_rem_reg ? r_final : q_final;
+                    valid_out <= 1'b1;
+                    div_busy <= 1'b0;
+                end
+            end
+        end
+    end
+
+endmodule
@@ -0,0 +1,133 @@
+// RV32C expander in front of decoder_control
+// `insn_in` is the 32-bit window fetched at the PC (halfword aligned). If its
+// low two bits are not 11 the low half is a compressed instruction and
+// `insn_out` is the equivalent 32-bit instruction, otherwise `insn_in` passes
+// through. Reserved and RV64/FP-only encodings expand to 0 (illegal), which the
+// decoder treats like any other unknown instruction.
+
+module rvc_expand (
+    input wire [31:0] insn_in,
+    output reg [31:0] insn_out,
+    output wire is_rvc // instruction is 2 bytes long
+);
+
+    wire [15:0] c = insn_in[15:0];
+    assign is_rvc = (c[1:0] != 2'b11);
+
+    // register fields
+    wire [4:0] rd = c[11:7];          // rd/rs1 of the full-register forms
+    wire [4:0] rs2 = c[6:2];
+    wire [4:0] rdp = {2'b01, c[4:2]}; // rd'/rs2' (x8-x15)
+    wire [4:0] rs1p = {2'b01, c[9:7]}; // rs1'/rd'
+
+    // immediates
+    wire [11:0] imm6 = {{7{c[12]}}, c[6:2]};                                   // C.ADDI/LI/ANDI
+    wire [11:0] uimm_addi4spn = {2'b00, c[10:7], c[12:11], c[5], c[6], 2'b00};
+    wire [11:0] uimm_lw = {5'b00000, c[5], c[12:10], c[6], 2'b00};              // C.LW/C.SW
+    wire [11:0] uimm_lwsp = {4'b0000, c[3:2], c[12], c[6:4], 2'b00};
+    wire [11:0] uimm_swsp = {4'b0000, c[8:7], c[12:9], 2'b00};
+    wire [11:0] imm_addi16sp = {{3{c[12]}}, c[4:3], c[5], c[2], c[6], 4'b0000};
+    wire [19:0] imm_lui = {{15{c[12]}}, c[6:2]};
+    wire [20:1] imm_j = {{10{c[12]}}, c[8], c[10:9], c[6], c[7], c[2], c[11], c[5:3]};
+    wire [12:1] imm_b = {{5{c[12]}}, c[6:5], c[2], c[11:10], c[4:3]};
+
+    // 32-bit formats
+    localparam OP_IMM = 7'b0010011;
+    localparam OP     = 7'b0110011;
+    localparam LOAD   = 7'b0000011;
+    localparam STORE  = 7'b0100011;
+    localparam LUI    = 7'b0110111;
+    localparam JAL    = 7'b1101111;
+    localparam JALR   = 7'b1100111;
+    localparam BRANCH = 7'b1100011;
+
+    always @(*) begin
+        insn_out = 32'd0;
+        if (!is_rvc) begin
+            insn_out = insn_in;
+        end else begin
+            case ({c[1:0], c[15:13]})
+                // quadrant 0
+                5'b00_000: // C.ADDI4SPN: addi rd', x2, nzuimm
+                    if (uimm_addi4spn != 12'd0)
+                        insn_out = {uimm_addi4spn, 5'd2, 3'b000, rdp, OP_IMM};
+                5'b00_010: // C.LW: lw rd', uimm(rs1')
+                    insn_out = {uimm_lw, rs1p, 3'b010, rdp, LOAD};
+                5'b00_110: // C.SW: sw rs2', uimm(rs1')
+                    insn_out = {uimm_lw[11:5], rdp, rs1p, 3'b010, uimm_lw[4:0], STORE};
+
+                // quadrant 1
+                5'b01_000: // C.ADDI / C.NOP: addi rd, rd, imm
+                    insn_out = {imm6, rd, 3'b000, rd, OP_IMM};
+                5'b01_001: // C.JAL: jal x1, offset
+                    insn_out = {imm_j[20], imm_j[10:1], imm_j[11], imm_j[19:12], 5'd1, JAL};
+                5'b01_010: // C.LI: addi rd, x0, imm
+                    insn_out = {imm6, 5'd0, 3'b000, rd, OP_IMM};
+                5'b01_011:
+                    if (rd == 5'd2) begin
+                        // C.ADDI16SP: addi x2, x2, nzimm
+                        if (imm_addi16sp != 12'd0)
+                            insn_out = {imm_addi16sp, 5'd2, 3'b000, 5'd2, OP_IMM};
+                    end else if (imm_lui != 20'd0) begin
+                        // C.LUI: lui rd, nzimm
+                        insn_out = {imm_lui, rd, LUI};
+                    end
+                5'b01_100:
+                    case (c[11:10])
+                        2'b00: // C.SRLI
+                            if (!c[12]) insn_out = {7'b0000000, c[6:2], rs1p, 3'b101, rs1p, OP_IMM};
+                        2'b01: // C.SRAI
+                            if (!c[12]) insn_out = {7'b0100000, c[6:2], rs1p, 3'b101, rs1p, OP_IMM};
+                        2'b10: // C.ANDI
+                            insn_out = {imm6, rs1p, 3'b111, rs1p, OP_IMM};
+                        default:
+                            if (!c[12]) begin
+                                case (c[6:5])
+                                    2'b00: insn_out = {7'b0100000, rdp, rs1p, 3'b000, rs1p, OP}; // C.SUB
+                                    2'b01: insn_out = {7'b0000000, rdp, rs1p, 3'b100, rs1p, OP}; // C.XOR
+                                    2'b10: insn_out = {7'b0000000, rdp, rs1p, 3'b110, rs1p, OP}; // C.OR
+                                    default: insn_out = {7'b0000000, rdp, rs1p, 3'b111, rs1p, OP}; // C.AND
+                                endcase
+                            end
+                    endcase
+                5'b01_101: // C.J: jal x0, offset
+                    insn_out = {imm_j[20], imm_j[10:1], imm_j[11], imm_j[19:12], 5'd0, JAL};
+                5'b01_110: // C.BEQZ: beq rs1', x0, offset
+                    insn_out = {imm_b[12], imm_b[10:5], 5'd0, rs1p, 3'b000, imm_b[4:1], imm_b[11], BRANCH};
+                5'b01_111: // C.BNEZ: bne rs1', x0, offset
+                    insn_out = {imm_b[12], imm_b[10:5], 5'd0, rs1p, 3'b001, imm_b[4:1], imm_b[11], BRANCH};
+
+                // quadrant 2
+                5'b10_000: // C.SLLI
+                    if (!c[12]) insn_out = {7'b0000000, c[6:2], rd, 3'b001, rd, OP_IMM};
+                5'b10_010: // C.LWSP: lw rd, uimm(x2)
+                    if (rd != 5'd0) insn_out = {uimm_lwsp, 5'd2, 3'b010, rd, LOAD};
+                5'b10_100:
+                    if (!c[12]) begin
+                        if (rs2 == 5'd0) begin
+                            // C.JR: jalr x0, 0(rs1)
+                            if (rd != 5'd0) insn_out = {12'd0, rd, 3'b000, 5'd0, JALR};
+                        end else begin
+                            // C.MV: add rd, x0, rs2
+                            insn_out = {7'b0000000, rs2, 5'd0, 3'b000, rd, OP};
+                        end
+                    end else begin
+                        if (rs2 == 5'd0 && rd == 5'd0) begin
+                            insn_out = 32'h00100073; // C.EBREAK
+                        end else if (rs2 == 5'd0) begin
+                            // C.JALR: jalr x1, 0(rs1)
+                            insn_out = {12'd0, rd, 3'b000, 5'd1, JALR};
+                        end else begin
+                            // C.ADD: add rd, rd, rs2
+                            insn_out = {7'b0000000, rs2, rd, 3'b000, rd, OP};
+                        end
+                    end
+                5'b10_110: // C.SWSP: sw rs2, uimm(x2)
+                    insn_out = {uimm_swsp[11:5], rs2, 5'd2, 3'b010, uimm_swsp[4:0], STORE};
+
+                default: insn_out = 32'd0; // FP loads/stores, reserved
+            endcase
+        end
+    end
+
+endmodule
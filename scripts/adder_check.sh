@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# =============================================================================
+# adder_32 check
+# =============================================================================
+# Verilates adder_32 alone for each architecture and runs sim/adder_check.cc,
+# which compares {cout, sum} against a + b + cin on exhaustive byte operands,
+# every carry chain and random operands.
+#
+# Usage: bash scripts/adder_check.sh
+#
+# Knobs:
+# ARCHS: adder_32 ARCH values to check (default "0 1 2 3")
+ARCHS=${ARCHS:-"0 1 2 3"}
+
+cd "$(dirname "$0")/.." || exit 1
+
+for a in $ARCHS; do
+    verilator -Wall \
+       -Wno-DECLFILENAME \
+       -Werror-UNUSED \
+       --cc --exe --build --top adder_32 -j 0 \
+       --Mdir obj_dir_adder_$a \
+       -CFLAGS "-std=c++17 -DARCH=$a" \
+       -GARCH=$a \
+       alu.v sim/adder_check.cc > /dev/null || exit 1
+    ./obj_dir_adder_$a/Vadder_32 || exit 1
+    echo
+done
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""
+Sampling profile report
+Reads the "PROF <pc>" lines printed by sw/mnist-newlib/profile.c from a
+simulation log and prints a per-function histogram, using the symbol table of
+the firmware ELF.
+
+Usage: python3 scripts/profile_report.py firmware.elf sim.log [--top N]
+       ./test_top.sh firmware32_mnist_sew.hex | python3 scripts/profile_report.py firmware_mnist_sew.elf -
+
+NM (default riscv64-unknown-elf-nm) selects the nm binary.
+"""
+
+import argparse
+import bisect
+import os
+import re
+import subprocess
+import sys
+from collections import Counter
+
+
+def load_symbols(elf):
+    nm = os.environ.get("NM", "riscv64-unknown-elf-nm")
+    out = subprocess.run([nm, "-n", "-C", elf], check=True, capture_output=True, text=True).stdout
+    addrs, names = [], []
+    for line in out.splitlines():
+        parts = line.split(maxsplit=2)
+        if len(parts) == 3 and parts[1] in "tTwW":
+            addrs.append(int(parts[0], 16))
+            names.append(parts[2])
+    return addrs, names
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("elf")
+    ap.add_argument("log", help="simulation output, - for stdin")
+    ap.add_argument("--top", type=int, default=20)
+    args = ap.parse_args()
+
+    addrs, names = load_symbols(args.elf)
+    log = sys.stdin if args.log == "-" else open(args.log)
+
+    pcs = []
+    header = None
+    for line in log:
+        m = re.match(r"PROF ([0-9a-fA-F]{8})\s*$", line)
+        if m:
+            pcs.append(int(m.group(1), 16))
+        elif line.startswith("PROF "):
+            header = line[5:].strip()
+
+    if not pcs:
+        print("no PROF samples found")
+        return 1
+
+    funcs = Counter()
+    for pc in pcs:
+        i = bisect.bisect_right(addrs, pc) - 1
+        funcs[names[i] if i >= 0 else "??"] += 1
+
+    if header:
+        print(header)
+    total = len(pcs)
+    print(f"{'samples':>8} {'%':>6}  function")
+    for name, n in funcs.most_common(args.top):
+        print(f"{n:8d} {100.0 * n / total:6.2f}  {name}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
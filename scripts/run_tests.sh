@@ -0,0 +1,59 @@
+#!/bin/bash
+
+# =============================================================================
+# Result-checking test run
+# =============================================================================
+# Builds every tests/*.S as its own image (make tests/<name>.hex, see
+# sim/test_start.S), verilates top.v through test_top.sh once per core and
+# runs each image on it. Prints one line per test with its result, cycles
+# and CPI and exits 1 if any test fails or does not reach its ebreak.
+#
+# Usage: bash scripts/run_tests.sh
+#
+# Knobs:
+# PIPELINES: cores to run, PIPELINE values (default "0 1")
+# TESTS:     test names (default: every tests/*.S)
+# TIMEOUT:   seconds per test before it counts as hung (default 60)
+# FIRMWARE:  sw/mnist-newlib variants to run after the tests (default none), e.g.
+#            "int32 matmul pvmac wide_vec sew_compare mnist_sew"; they need the
+#            RISC-V C compiler, pass when they reach their ebreak and take
+#            minutes each (raise TIMEOUT). make -C sw/mnist-newlib clean after
+#            changing VLEN, the hex files do not depend on it.
+# The test_top.sh knobs (VLEN, BPRED, DMEM_LATENCY, ...) pass through.
+PIPELINES=${PIPELINES:-"0 1"}
+TIMEOUT=${TIMEOUT:-60}
+
+cd "$(dirname "$0")/.." || exit 1
+
+if [ -z "$TESTS" ]; then
+    TESTS=$(ls tests/*.S | xargs -n1 basename | sed 's/\.S$//')
+fi
+make $(for t in $TESTS; do echo tests/$t.hex; done) > /dev/null || exit 1
+for f in $FIRMWARE; do
+    make -C sw/mnist-newlib firmware32_$f.hex > /dev/null || exit 1
+done
+
+mkdir -p obj_dir_tests
+fail=0
+for p in $PIPELINES; do
+    first=$(echo $TESTS | cut -d' ' -f1)
+    PIPELINE=$p bash test_top.sh tests/$first.hex < /dev/null > /dev/null || exit 1
+    echo "PIPELINE=$p"
+    for t in $TESTS $FIRMWARE; do
+        hex=tests/$t.hex
+        [ -f $hex ] || hex=sw/mnist-newlib/firmware32_$t.hex
+        # the simulator writes its traces to the working directory
+        out=$(cd obj_dir_tests && timeout $TIMEOUT ../obj_dir/Vtop ../$hex < /dev/null 2>&1)
+        if [ $hex = tests/$t.hex ]; then
+            res=$(echo "$out" | grep -o -E "\.\.(OK|ERROR.*)$" | head -1 | sed 's/^\.\.//')
+        else
+            res=$(echo "$out" | grep -q "^\[EBREAK\]" && echo OK)
+        fi
+        cycles=$(echo "$out" | sed -n 's/^Total cycles: //p')
+        cpi=$(echo "$out" | sed -n 's/^CPI: //p')
+        [ -n "$res" ] || res="NO RESULT"
+        [ "$res" = "OK" ] || fail=1
+        printf "  %-12s %-12s cycles %-10s CPI %s\n" "$t" "$res" "$cycles" "$cpi"
+    done
+done
+exit $fail
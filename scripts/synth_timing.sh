@@ -0,0 +1,100 @@
+#!/bin/bash
+
+# =============================================================================
+# Synthesis timing report
+# =============================================================================
+# Synthesizes the core with yosys and reports the critical path, so fmax can be
+# read next to the cycle counts from test_top.sh (time = cycles / fmax).
+#
+# Without a liberty file the report is the longest path in generic gates
+# (yosys `ltp`), good enough to compare adder architectures. With LIBERTY set,
+# the design is mapped to that library and, if OpenSTA (`sta`) is installed,
+# timed against CLOCK_PERIOD; fmax is derived from the worst slack.
+#
+# Usage: bash scripts/synth_timing.sh
+#
+# Knobs:
+# TOP:          module to synthesize (ucrv32, ucrv32_pipe, alu, adder_32, ...)
+# ALU_ADDER:    adder_32 ARCH for the ALU, 0 ripple, 1 CLA, 2 Kogge-Stone, 3 behavioral
+# PC_ADDER:     adder_32 ARCH for the PC+4 / branch target adders
+# VLEN:         vector register width for the cores and vector units (64, 128, 256)
+# LIBERTY:      standard cell library (.lib), optional
+# CLOCK_PERIOD: target clock period in ns (default 10)
+TOP=${TOP:-ucrv32}
+ALU_ADDER=${ALU_ADDER:-0}
+PC_ADDER=${PC_ADDER:-0}
+VLEN=${VLEN:-64}
+LIBERTY=${LIBERTY:-}
+CLOCK_PERIOD=${CLOCK_PERIOD:-10}
+
+cd "$(dirname "$0")/.." || exit 1
+
+OUT=synth_out
+mkdir -p $OUT
+
+SOURCES="ucrv32.v ucrv32_pipe.v alu.v decoder_control.v csr.v vmac.v muldiv.v valu.v vlsu.v \
+vreg_file.v vprefetch.v wbuf.v iprefetch.v bpred.v viq.v rvc_expand.v"
+
+# only core-level modules take the adder parameters
+CHPARAM=""
+case "$TOP" in
+    ucrv32|ucrv32_pipe)
+        CHPARAM="chparam -set ALU_ADDER $ALU_ADDER -set PC_ADDER $PC_ADDER -set VLEN $VLEN $TOP"
+        ;;
+    valu|vlsu|vreg_file|vprefetch)
+        CHPARAM="chparam -set VLEN $VLEN $TOP"
+        ;;
+    alu)
+        CHPARAM="chparam -set ADDER $ALU_ADDER alu"
+        ;;
+    adder_32)
+        CHPARAM="chparam -set ARCH $ALU_ADDER adder_32"
+        ;;
+esac
+
+if [ -z "$LIBERTY" ]; then
+    MAP="abc -g AND,NAND,OR,NOR,XOR,XNOR,MUX"
+else
+    PERIOD_PS=$(awk "BEGIN { print int($CLOCK_PERIOD * 1000) }")
+    MAP="dfflibmap -liberty $LIBERTY; abc -D $PERIOD_PS -liberty $LIBERTY; opt_clean; stat -liberty $LIBERTY"
+fi
+
+yosys -q -l $OUT/${TOP}_yosys.log -p "
+    read_verilog $SOURCES;
+    $CHPARAM;
+    synth -top $TOP -flatten;
+    $MAP;
+    tee -o $OUT/${TOP}_ltp.txt ltp -noff;
+    tee -o $OUT/${TOP}_stat.txt stat;
+    write_verilog -noattr $OUT/${TOP}_netlist.v
+"
+
+if [ $? -ne 0 ]; then
+    echo "Synthesis failed, see $OUT/${TOP}_yosys.log"
+    exit 1
+fi
+
+echo "=== $TOP (ALU_ADDER=$ALU_ADDER, PC_ADDER=$PC_ADDER, VLEN=$VLEN) ==="
+grep -i "longest topological path" $OUT/${TOP}_ltp.txt
+grep -i "number of cells" $OUT/${TOP}_stat.txt | head -1
+
+if [ -n "$LIBERTY" ] && command -v sta > /dev/null; then
+    cat > $OUT/${TOP}_sta.tcl << EOF
+read_liberty $LIBERTY
+read_verilog $OUT/${TOP}_netlist.v
+link_design $TOP
+create_clock -name clk -period $CLOCK_PERIOD [get_ports clk]
+set_input_delay 0 -clock clk [delete_from_list [all_inputs] [get_ports clk]]
+set_output_delay 0 -clock clk [all_outputs]
+report_checks -path_delay max -digits 3
+report_worst_slack -max -digits 3
+exit
+EOF
+    sta -no_init -exit $OUT/${TOP}_sta.tcl | tee $OUT/${TOP}_sta.txt
+    SLACK=$(awk '/^worst slack/ { print $3 }' $OUT/${TOP}_sta.txt)
+    if [ -n "$SLACK" ]; then
+        awk "BEGIN { p = $CLOCK_PERIOD - ($SLACK); printf \"Critical path: %.3f ns, fmax: %.1f MHz\n\", p, 1000.0 / p }"
+    fi
+elif [ -n "$LIBERTY" ]; then
+    echo "OpenSTA (sta) not found, mapped netlist in $OUT/${TOP}_netlist.v"
+fi
@@ -0,0 +1,33 @@
+#!/bin/bash
+
+# =============================================================================
+# VALU throughput sweep
+# =============================================================================
+# Verilates valu.v alone for each multiplier count and runs sim/valu_sweep.cc,
+# which issues back-to-back VMUL/VMAC/VMACC ops per SEW, checks the results and
+# prints MACs per cycle. Running the unit alone keeps the fetch/issue rate of
+# either core out of the numbers.
+#
+# Usage: bash scripts/valu_sweep.sh
+#
+# Knobs:
+# MULS: multiplier counts to sweep (default "4 8 16")
+# VLEN: vector length in bits, 64, 128 or 256 (default 64)
+MULS=${MULS:-"4 8 16"}
+VLEN=${VLEN:-64}
+
+cd "$(dirname "$0")/.." || exit 1
+
+for n in $MULS; do
+    verilator -Wall \
+       -Wno-DECLFILENAME \
+       -Werror-UNUSED \
+       --cc --exe --build --top valu -j 0 \
+       --Mdir obj_dir_valu_${VLEN}_$n \
+       -CFLAGS "-std=c++17 -DVLEN=$VLEN" \
+       -GVLEN=$VLEN -GNUM_MULS=$n \
+       valu.v sim/valu_sweep.cc > /dev/null || exit 1
+    echo "NUM_MULS=$n"
+    ./obj_dir_valu_${VLEN}_$n/Vvalu || exit 1
+    echo
+done
@@ -0,0 +1,98 @@
+// adder_32 check
+// Drives adder_32 on its own and compares {cout, sum} against a + b + cin:
+//   - exhaustive 8-bit operands and carry-in at every byte position, with the
+//     other bytes all zero or all ones (carries die or run through them)
+//   - every carry chain: a run of ones of each length at each bit, plus 1
+//   - random operands (xorshift, fixed seed)
+// Built once per ARCH by scripts/adder_check.sh.
+
+#include <verilated.h>
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
+#include "Vadder_32.h"
+
+#ifndef ARCH
+#define ARCH 0
+#endif
+
+static const uint64_t NUM_RANDOM = 10000000;
+
+static Vadder_32* dut;
+static uint64_t checked;
+static int errors;
+
+static void check(uint32_t a, uint32_t b, uint32_t cin) {
+  dut->a = a;
+  dut->b = b;
+  dut->cin = cin;
+  dut->eval();
+  uint64_t expect = (uint64_t)a + b + cin;
+  uint64_t got = ((uint64_t)dut->cout << 32) | dut->sum;
+  checked++;
+  if (got != expect) {
+    if (errors < 10) {
+      fprintf(stderr, "mismatch: %08x + %08x + %u: got %09llx expected %09llx\n", a, b, cin,
+              (unsigned long long)got, (unsigned long long)expect);
+    }
+    errors++;
+  }
+}
+
+static uint32_t xorshift32() {
+  static uint32_t s = 2463534242u;
+  s ^= s << 13;
+  s ^= s >> 17;
+  s ^= s << 5;
+  return s;
+}
+
+int main(int argc, char** argv) {
+  Verilated::commandArgs(argc, argv);
+  dut = new Vadder_32;
+
+  // exhaustive bytes
+  uint64_t n0 = checked;
+  for (int pos = 0; pos < 32; pos += 8) {
+    for (uint32_t fill = 0; fill < 2; fill++) {
+      uint32_t rest = fill ? ~(0xffu << pos) : 0;
+      for (uint32_t x = 0; x < 256; x++) {
+        for (uint32_t y = 0; y < 256; y++) {
+          for (uint32_t cin = 0; cin < 2; cin++) {
+            check(rest | (x << pos), (y << pos), cin);
+            check(rest | (x << pos), rest | (y << pos), cin);
+          }
+        }
+      }
+    }
+  }
+  printf("ARCH=%d exhaustive bytes: %llu\n", ARCH, (unsigned long long)(checked - n0));
+
+  // carry chains
+  n0 = checked;
+  for (int start = 0; start < 32; start++) {
+    for (int len = 1; start + len <= 32; len++) {
+      uint32_t run = (len >= 32) ? 0xffffffffu : (((1u << len) - 1) << start);
+      for (uint32_t cin = 0; cin < 2; cin++) {
+        check(run, 1u << start, cin);
+        check(run, 0, cin);
+        check(run, ~run, cin);
+      }
+    }
+  }
+  printf("ARCH=%d carry chains:     %llu\n", ARCH, (unsigned long long)(checked - n0));
+
+  // random
+  n0 = checked;
+  for (uint64_t i = 0; i < NUM_RANDOM; i++) {
+    uint32_t a = xorshift32();
+    uint32_t b = xorshift32();
+    check(a, b, a >> 31);
+  }
+  printf("ARCH=%d random:           %llu\n", ARCH, (unsigned long long)(checked - n0));
+
+  dut->final();
+  delete dut;
+  printf("ARCH=%d %d mismatches in %llu additions\n", ARCH, errors, (unsigned long long)checked);
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,38 @@
+// Binary data-memory transaction trace
+// Written by top.cc when MEM_TRACE=1 (<test>_mem_trace.bin), read by
+// tools/memreplay. One record per accepted request, in cycle order:
+//   - core data bus (scalar or vector through vlsu/prefetcher)
+//   - DMA engine on the SRAM/TCM ports
+//   - vector scratchpad (TCM) port
+// All fields little endian, no padding.
+
+#ifndef MEM_TRACE_H
+#define MEM_TRACE_H
+
+#include <stdint.h>
+
+#define MEM_TRACE_MAGIC   0x52544d44u  // "DMTR"
+#define MEM_TRACE_VERSION 1u
+
+// record flags
+#define MEM_TRACE_WRITE   0x01u  // store (otherwise load)
+#define MEM_TRACE_VECTOR  0x02u  // issued by the vector unit
+#define MEM_TRACE_DMA     0x04u  // issued by the DMA engine
+#define MEM_TRACE_TCM     0x08u  // private VLEN-bit scratchpad port
+
+struct __attribute__((packed)) MemTraceHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t reserved;
+};
+
+struct __attribute__((packed)) MemTraceRecord {
+  uint64_t cycle;
+  uint32_t addr;
+  uint8_t  size;   // bytes touched (1/2/4, VLEN/8 on the TCM port)
+  uint8_t  flags;
+  uint16_t reserved;
+};
+
+#endif
@@ -0,0 +1,201 @@
+// VALU throughput sweep
+// Drives valu.v on its own: issues back-to-back VMUL/VMAC/VMACC ops for each
+// SEW, checks the results against a C model and prints MACs per cycle.
+// Built once per NUM_MULS by scripts/valu_sweep.sh; VLEN must match the
+// -GVLEN the unit was verilated with.
+
+#include <verilated.h>
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
+#include <vector>
+#include "Vvalu.h"
+
+#ifndef VLEN
+#define VLEN 64
+#endif
+#define VWORDS (VLEN / 32)
+
+enum { OP_VADD, OP_VSUB, OP_VMUL, OP_VMAC, OP_VMACC, OP_VREDACC };
+
+static const int NUM_OPS = 1024;
+
+static Vvalu* dut;
+static uint64_t cycles;
+
+static void tick() {
+  dut->clk = 0;
+  dut->eval();
+  dut->clk = 1;
+  dut->eval();
+  cycles++;
+}
+
+// one vector register, 32-bit words, word 0 = lane 0
+struct Vec {
+  uint32_t w[VWORDS];
+  bool operator!=(const Vec& o) const {
+    for (int i = 0; i < VWORDS; i++) {
+      if (w[i] != o.w[i]) return true;
+    }
+    return false;
+  }
+};
+
+// Verilator ports are uint64_t up to 64 bits, word arrays above
+#if VLEN == 64
+static void set_port(uint64_t& p, const Vec& v) { p = ((uint64_t)v.w[1] << 32) | v.w[0]; }
+static Vec get_port(uint64_t p) { Vec v = { { (uint32_t)p, (uint32_t)(p >> 32) } }; return v; }
+#else
+template <typename P> static void set_port(P& p, const Vec& v) {
+  for (int i = 0; i < VWORDS; i++) p[i] = v.w[i];
+}
+template <typename P> static Vec get_port(const P& p) {
+  Vec v;
+  for (int i = 0; i < VWORDS; i++) v.w[i] = p[i];
+  return v;
+}
+#endif
+
+static int lanes(int sew) { return (VLEN / 8) >> sew; }
+
+// element `lane` of a register, sign-extended
+static int32_t elem(const Vec& v, int sew, int lane) {
+  int bits = 8 << sew;
+  uint32_t word = v.w[lane * bits / 32];
+  int shift = (lane * bits) % 32;
+  switch (sew) {
+    case 0: return (int8_t)(word >> shift);
+    case 1: return (int16_t)(word >> shift);
+    default: return (int32_t)word;
+  }
+}
+
+static Vec ref_vmul(const Vec& a, const Vec& b, int sew) {
+  int bits = 8 << sew;
+  uint32_t mask = (bits == 32) ? ~0u : ((1u << bits) - 1);
+  Vec r = {};
+  for (int l = 0; l < lanes(sew); l++) {
+    uint32_t p = (uint32_t)elem(a, sew, l) * (uint32_t)elem(b, sew, l);
+    r.w[l * bits / 32] |= (p & mask) << ((l * bits) % 32);
+  }
+  return r;
+}
+
+static uint32_t ref_vmac(const Vec& a, const Vec& b, int sew) {
+  uint32_t s = 0;
+  for (int l = 0; l < lanes(sew); l++) {
+    s += (uint32_t)elem(a, sew, l) * (uint32_t)elem(b, sew, l);
+  }
+  return s;
+}
+
+static Vec scalar(uint32_t x) {
+  Vec v = {};
+  v.w[0] = x;
+  return v;
+}
+
+static Vec rand_vec() {
+  Vec v;
+  for (int i = 0; i < VWORDS; i++) {
+    v.w[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+  }
+  return v;
+}
+
+// Issue `ops` in order as fast as in_ready allows, results are taken every
+// cycle. Returns the cycles from the first issue to the last result.
+struct Op { int op; Vec a, b; Vec expect; bool check; };
+
+static uint64_t run(const std::vector<Op>& ops, int sew, int* errors) {
+  dut->rst_n = 0;
+  dut->valid_in = 0;
+  dut->out_ready = 1;
+  dut->vx = 0;
+  dut->vmask = (uint32_t)((1ull << (VLEN / 8)) - 1); // unmasked
+  tick();
+  tick();
+  dut->rst_n = 1;
+
+  size_t issued = 0, done = 0;
+  cycles = 0;
+  while (done < ops.size()) {
+    if (issued < ops.size()) {
+      dut->valid_in = 1;
+      dut->op = ops[issued].op;
+      dut->sew = sew;
+      set_port(dut->vs1_data, ops[issued].a);
+      set_port(dut->vs2_data, ops[issued].b);
+    } else {
+      dut->valid_in = 0;
+    }
+    dut->eval();
+    bool take = dut->valid_in && dut->in_ready;
+    if (dut->valid_out) {
+      const Op& o = ops[done];
+      Vec got = get_port(dut->result);
+      if (o.check && got != o.expect) {
+        if (*errors < 5) {
+          fprintf(stderr, "mismatch: op %d sew %d #%zu: got %08x expected %08x (word 0)\n",
+                  o.op, sew, done, got.w[0], o.expect.w[0]);
+        }
+        (*errors)++;
+      }
+      done++;
+    }
+    tick();
+    if (take) issued++;
+    if (cycles > 100ull * ops.size() + 100) {
+      fprintf(stderr, "timeout: %zu of %zu results\n", done, ops.size());
+      (*errors)++;
+      break;
+    }
+  }
+  return cycles;
+}
+
+int main(int argc, char** argv) {
+  Verilated::commandArgs(argc, argv);
+  dut = new Vvalu;
+  srand(1);
+
+  static const char* sew_name[] = { "SEW8", "SEW16", "SEW32" };
+  static const char* op_name[] = { "VADD", "VSUB", "VMUL", "VMAC", "VMACC" };
+  static const int sweep_ops[] = { OP_VMUL, OP_VMAC, OP_VMACC };
+  int errors = 0;
+
+  printf("VLEN=%d\n", VLEN);
+  printf("%-6s %-6s %8s %8s %12s\n", "SEW", "op", "ops", "cycles", "MACs/cycle");
+  for (int sew = 0; sew < 3; sew++) {
+    for (int op : sweep_ops) {
+      std::vector<Op> ops;
+      uint32_t acc = 0;
+      for (int i = 0; i < NUM_OPS; i++) {
+        Op o = { op, rand_vec(), rand_vec(), Vec(), true };
+        if (op == OP_VMUL) {
+          o.expect = ref_vmul(o.a, o.b, sew);
+        } else if (op == OP_VMAC) {
+          o.expect = scalar(ref_vmac(o.a, o.b, sew));
+        } else {
+          o.check = false;
+          acc += ref_vmac(o.a, o.b, sew);
+        }
+        ops.push_back(o);
+      }
+      if (op == OP_VMACC) {
+        // the accumulator is only visible through VREDACC
+        Op r = { OP_VREDACC, Vec(), Vec(), scalar(acc), true };
+        ops.push_back(r);
+      }
+      uint64_t c = run(ops, sew, &errors);
+      printf("%-6s %-6s %8d %8llu %12.2f\n", sew_name[sew], op_name[op], NUM_OPS,
+             (unsigned long long)c, (double)NUM_OPS * lanes(sew) / c);
+    }
+  }
+
+  dut->final();
+  delete dut;
+  printf("%d result mismatches\n", errors);
+  return errors ? 1 : 0;
+}
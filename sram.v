@@ -1,4 +1,6 @@
-module sram (
+module sram #(
+  parameter DMEM_LATENCY = 1  // data port read latency in cycles (>= 1)
+) (
   input clk,
   input resetn,
 
@@ -18,29 +20,38 @@ module sram (
 
   reg [31:0] mem [0:32'h00400000-1];  // 4M words = 16MB
 
-  // Instruction port: read-only, responds with data on next cycle
+  // Instruction port: read-only, responds with data on next cycle. The address
+  // only has to be halfword aligned (RVC): at addr[1] the upper half of the word
+  // and the lower half of the next one are returned, so the low 16 bits are
+  // always the instruction at the address.
   reg [31:0] imem_addr_reg;
   always @(posedge clk) begin
     imem_addr_reg <= imem_addr;
   end
-  assign imem_rdata = mem[imem_addr_reg[23:2]];
+  wire [21:0] imem_word = imem_addr_reg[23:2];
+  wire [21:0] imem_word_next = imem_word + 22'd1;
+  assign imem_rdata = imem_addr_reg[1] ? {mem[imem_word_next][15:0], mem[imem_word][31:16]} :
+                                         mem[imem_word];
 
-  // Data port: read-write, responds with read data on next cycle
-  reg [31:0] dmem_addr_reg;
-  reg dmem_resp_valid_reg;
+  // Data port: read-write, responds with read data DMEM_LATENCY cycles later.
+  // Reads are pipelined, so a new request can still be accepted every cycle.
+  reg [31:0] dmem_addr_pipe [0:DMEM_LATENCY-1];
+  reg [DMEM_LATENCY-1:0] dmem_valid_pipe;
 
+  integer s;
   always @(posedge clk) begin
     if (dmem_valid && !dmem_write) begin
-      dmem_addr_reg <= dmem_addr;
+      dmem_addr_pipe[0] <= dmem_addr;
+    end
+    dmem_valid_pipe[0] <= (dmem_valid && !dmem_write);
+    for (s = 1; s < DMEM_LATENCY; s = s + 1) begin
+      dmem_addr_pipe[s] <= dmem_addr_pipe[s-1];
+      dmem_valid_pipe[s] <= dmem_valid_pipe[s-1];
     end
   end
 
-  always @(posedge clk) begin
-    dmem_resp_valid_reg <= (dmem_valid && !dmem_write);
-  end
-
-  assign dmem_rdata = mem[dmem_addr_reg[23:2]];
-  assign dmem_resp_valid = dmem_resp_valid_reg;
+  assign dmem_rdata = mem[dmem_addr_pipe[DMEM_LATENCY-1][23:2]];
+  assign dmem_resp_valid = dmem_valid_pipe[DMEM_LATENCY-1];
 
   // Write logic
   always @(posedge clk) begin
@@ -1,5 +1,5 @@
 // MNIST Scalar vs Vector Comparison Benchmark
-// Compare: Scalar (no SIMD) vs Lab7 PVMAC (4 lanes) vs Wide Vector (8 lanes)
+// Compare: Scalar (no SIMD) vs Lab7 PVMAC (4 lanes) vs Wide Vector (VLEN/8 lanes)
 // Based on README.md 4.4.6: "Compare scalar vs. vector implementations"
 
 #include <stdio.h>
@@ -9,32 +9,65 @@
 #define HIDDEN_SIZE 32
 #define OUTPUT_SIZE 10
 
+// Vector register width of the core, make VLEN=128/256 (test_top.sh VLEN)
+#ifndef VLEN
+#define VLEN 64
+#endif
+#define VBYTES (VLEN / 8)       // bytes per VLD
+#define LANES_B VBYTES          // int8 lanes
+#define LANES_H (VBYTES / 2)    // int16 lanes
+#define LANES_W (VBYTES / 4)    // int32 lanes
+
+// Layer-1 rows padded to whole int8 vectors (784 is not a multiple of 32);
+// the padding is zero in the inputs and the weights
+#define INPUT_PAD ((INPUT_SIZE + LANES_B - 1) / LANES_B * LANES_B)
+// int8 outputs padded the same way for VREDUCE, the padding is -128
+#define OUTPUT_PAD ((OUTPUT_SIZE + LANES_B - 1) / LANES_B * LANES_B)
+// Layer-1 inputs of the whole-chunk loop of the VMAC.B kernel; with VMASK the
+// INPUT_TAIL left over (16 at VLEN=256) is one masked chunk and the padding is
+// never read
+#ifdef VMASK
+#define INPUT_BODY (INPUT_SIZE / LANES_B * LANES_B)
+#define INPUT_TAIL (INPUT_SIZE % LANES_B)
+#else
+#define INPUT_BODY INPUT_PAD
+#define INPUT_TAIL 0
+#endif
+#define VALIGN __attribute__((aligned(VBYTES)))
+
 #include "weights/mnist_weights_int8.h"
 #include "weights/test_data.h"
+#include "hpm.h"
+#include "profile.h"
+
+// Vector scratchpad (64 KB at 0x20000000, see riscv.ld): VLD/VST there take
+// the private VLEN-bit TCM port instead of the shared data bus
+#define TCM __attribute__((section(".tcm"), aligned(VBYTES)))
 
-// Pre-packed weights for vector access (INT8)
-int8_t W1_packed[HIDDEN_SIZE][INPUT_SIZE] __attribute__((aligned(8)));
-int8_t W2_packed[OUTPUT_SIZE][HIDDEN_SIZE] __attribute__((aligned(8)));
+// Pre-packed weights for vector access (INT8), kept in the scratchpad
+int8_t W1_packed[HIDDEN_SIZE][INPUT_PAD] TCM;
+int8_t W2_packed[OUTPUT_SIZE][HIDDEN_SIZE] TCM;
 
 // Pre-packed weights for VMAC.H (INT16)
-int16_t W1_packed_h[HIDDEN_SIZE][INPUT_SIZE] __attribute__((aligned(8)));
-int16_t W2_packed_h[OUTPUT_SIZE][HIDDEN_SIZE] __attribute__((aligned(8)));
+int16_t W1_packed_h[HIDDEN_SIZE][INPUT_PAD] VALIGN;
+int16_t W2_packed_h[OUTPUT_SIZE][HIDDEN_SIZE] VALIGN;
 
 // Pre-packed weights for VMAC.W (INT32)
-int32_t W1_packed_w[HIDDEN_SIZE][INPUT_SIZE] __attribute__((aligned(8)));
-int32_t W2_packed_w[OUTPUT_SIZE][HIDDEN_SIZE] __attribute__((aligned(8)));
+int32_t W1_packed_w[HIDDEN_SIZE][INPUT_PAD] VALIGN;
+int32_t W2_packed_w[OUTPUT_SIZE][HIDDEN_SIZE] VALIGN;
 
 // Input buffers for different SEWs
-int16_t input_h[INPUT_SIZE] __attribute__((aligned(8)));
-int32_t input_w[INPUT_SIZE] __attribute__((aligned(8)));
+int16_t input_h[INPUT_PAD] VALIGN;
+int32_t input_w[INPUT_PAD] VALIGN;
 
 void prepare_weights(void) {
     // Transpose and align W1/W2 for vector access (all SEWs)
     for (int j = 0; j < HIDDEN_SIZE; j++) {
-        for (int i = 0; i < INPUT_SIZE; i++) {
-            W1_packed[j][i] = W1_i8[i][j];
-            W1_packed_h[j][i] = (int16_t)W1_i8[i][j];
-            W1_packed_w[j][i] = (int32_t)W1_i8[i][j];
+        for (int i = 0; i < INPUT_PAD; i++) {
+            int8_t w = (i < INPUT_SIZE) ? W1_i8[i][j] : 0;
+            W1_packed[j][i] = w;
+            W1_packed_h[j][i] = (int16_t)w;
+            W1_packed_w[j][i] = (int32_t)w;
         }
     }
     for (int j = 0; j < OUTPUT_SIZE; j++) {
@@ -53,6 +86,32 @@ static inline unsigned int read_cycle_counter(void) {
     return count;
 }
 
+// Vector prefetcher counters (RDWRCTR ids 4/5)
+static inline unsigned int read_pf_useful_counter(void) {
+    unsigned int count;
+    asm volatile (".insn i 0x5B, 0, %0, x0, 4" : "=r"(count));
+    return count;
+}
+
+static inline unsigned int read_pf_useless_counter(void) {
+    unsigned int count;
+    asm volatile (".insn i 0x5B, 0, %0, x0, 5" : "=r"(count));
+    return count;
+}
+
+// Branch predictor counters (RDWRCTR ids 6/7, pipelined core only)
+static inline unsigned int read_bp_predict_counter(void) {
+    unsigned int count;
+    asm volatile (".insn i 0x5B, 0, %0, x0, 6" : "=r"(count));
+    return count;
+}
+
+static inline unsigned int read_bp_mispredict_counter(void) {
+    unsigned int count;
+    asm volatile (".insn i 0x5B, 0, %0, x0, 7" : "=r"(count));
+    return count;
+}
+
 static inline int8_t relu_int8(int32_t x) {
     if (x < 0) return 0;
     if (x > 127) return 127;
@@ -132,7 +191,7 @@ int mlp_forward_pvmac(const int8_t *input, int8_t *hidden, int8_t *output) {
 // ============================================================
 // Wide Vector: VLD and VMAC instructions
 // ============================================================
-// VLD (load 64-bit to vector register)
+// VLD (load VLEN bits to vector register)
 static inline void vld_v1(const void *addr) {
     asm volatile (".insn r 0x5B, 2, 4, x1, %0, x0" : : "r"(addr) : "memory");
 }
@@ -140,68 +199,349 @@ static inline void vld_v2(const void *addr) {
     asm volatile (".insn r 0x5B, 2, 4, x2, %0, x0" : : "r"(addr) : "memory");
 }
 
-// VMAC.B: 8 x int8 lanes, funct7 = 0x03 (00_00011)
+#ifdef VLDS
+// VLDS.B v2: LANES_B bytes, `stride` bytes apart, funct7 = 0x0D
+static inline void vlds_b_v2(const void *addr, int32_t stride) {
+    asm volatile (".insn r 0x5B, 2, 0x0D, x2, %0, %1" : : "r"(addr), "r"(stride) : "memory");
+}
+#endif
+
+// VMAC.B: VLEN/8 x int8 lanes, funct7 = 0x03 (00_00011)
 static inline int32_t vmac_b(void) {
     int32_t result;
     asm volatile (".insn r 0x5B, 2, 0x03, %0, x1, x2" : "=r"(result));
     return result;
 }
 
-// VMAC.H: 4 x int16 lanes, funct7 = 0x23 (01_00011)
+// VMAC.H: VLEN/16 x int16 lanes, funct7 = 0x23 (01_00011)
 static inline int32_t vmac_h(void) {
     int32_t result;
     asm volatile (".insn r 0x5B, 2, 0x23, %0, x1, x2" : "=r"(result));
     return result;
 }
 
-// VMAC.W: 2 x int32 lanes, funct7 = 0x43 (10_00011)
+// VMAC.W: VLEN/32 x int32 lanes, funct7 = 0x43 (10_00011)
 static inline int32_t vmac_w(void) {
     int32_t result;
     asm volatile (".insn r 0x5B, 2, 0x43, %0, x1, x2" : "=r"(result));
     return result;
 }
 
+// VMACC.B: acc[lane] += v1[lane] * v2[lane] into the VALU accumulator, funct7 = 0x0A
+static inline void vmacc_b(void) {
+    asm volatile (".insn r 0x5B, 2, 0x0A, x0, x1, x2");
+}
+
+// VREDACC: sum of the accumulator lanes, clears the accumulator, funct7 = 0x0B
+static inline int32_t vredacc(void) {
+    int32_t result;
+    asm volatile (".insn r 0x5B, 2, 0x0B, %0, x0, x0" : "=r"(result));
+    return result;
+}
+
+#ifdef VSETL
+// VSETL rd, rs1, rs2: SEW = `sew` (0 = 8, 1 = 16, 2 = 32), vl = min(n, VLEN/SEW)
+// elements, returns vl; funct3 = 7, funct7 = 0x01. VLD/VMAC work on the first
+// vl elements only.
+static inline uint32_t vsetl(uint32_t n, uint32_t sew) {
+    uint32_t vl;
+    asm volatile (".insn r 0x5B, 7, 0x01, %0, %1, %2" : "=r"(vl) : "r"(n), "r"(sew));
+    return vl;
+}
+
+// VMAC.V: VMAC at the SEW of the last vsetl, funct7 = 0x63 (11_00011)
+static inline int32_t vmac_v(void) {
+    int32_t result;
+    asm volatile (".insn r 0x5B, 2, 0x63, %0, x1, x2" : "=r"(result));
+    return result;
+}
+#endif
+
+#ifdef VMASK
+// VMSETL.B rd, rs1: vmask = the first min(n, LANES_B) int8 elements, returns
+// that count; funct3 = 7, funct7 = 0x00
+static inline uint32_t vmsetl_b(uint32_t n) {
+    uint32_t vl;
+    asm volatile (".insn r 0x5B, 7, 0x00, %0, %1, x0" : "=r"(vl) : "r"(n));
+    return vl;
+}
+
+// Masked VLD.B (funct3 = 6): inactive elements load as 0, words without an
+// active element are not read
+static inline void vld_m_b_v1(const void *addr) {
+    asm volatile (".insn r 0x5B, 6, 4, x1, %0, x0" : : "r"(addr) : "memory");
+}
+static inline void vld_m_b_v2(const void *addr) {
+    asm volatile (".insn r 0x5B, 6, 4, x2, %0, x0" : : "r"(addr) : "memory");
+}
+#ifdef VLDS
+static inline void vlds_m_b_v2(const void *addr, int32_t stride) {
+    asm volatile (".insn r 0x5B, 6, 0x0D, x2, %0, %1" : : "r"(addr), "r"(stride) : "memory");
+}
+#endif
+#define VRED_F3 "6" // masked reductions, the elements past vmask do not take part
+#else
+#define VRED_F3 "2"
+#endif
+
+#ifdef VREDUCE
+// VREDMAX.B / VARGMAX.B rd, v1: largest int8 lane / its index, funct7 = 0x17 / 0x19
+static inline int32_t vredmax_b(void) {
+    int32_t result;
+    asm volatile (".insn r 0x5B, " VRED_F3 ", 0x17, %0, x1, x0" : "=r"(result));
+    return result;
+}
+static inline int32_t vargmax_b(void) {
+    int32_t result;
+    asm volatile (".insn r 0x5B, " VRED_F3 ", 0x19, %0, x1, x0" : "=r"(result));
+    return result;
+}
+#endif
+
+#ifdef REQUANT
+// VNCLIP.RELU.B v3, v1, ctl: int32 lanes of v1 -> int8 with ReLU in the low
+// LANES_W bytes of v3; ctl[4:0] = shift, ctl[31:16] = offset; funct7 = 0x15
+static inline void vnclip_relu_b_v3(uint32_t ctl) {
+    asm volatile (".insn r 0x5B, 2, 0x15, x3, x1, %0" : : "r"(ctl));
+}
+
+// VMOV.V2S rd, v3, lane: the lane is the rs2 field; funct7 0x29 (.H), 0x49 (.W)
+#define VMOV_V2S_V3(funct7, lane) ({ int32_t r_; \
+    asm volatile (".insn r 0x5B, 2, " #funct7 ", %0, x3, x" #lane : "=r"(r_)); r_; })
+
+// Layer-1 accumulators, requantized LANES_W at a time
+static int32_t hidden_acc[HIDDEN_SIZE] VALIGN;
+
+// hidden[j] = relu_int8(hidden_acc[j]) for all j
+static void requant_hidden(int8_t *hidden) {
+    for (int j = 0; j < HIDDEN_SIZE; j += LANES_W) {
+        vld_v1(&hidden_acc[j]);
+        vnclip_relu_b_v3(0);
+#if LANES_W == 2
+        *(int16_t *)&hidden[j] = (int16_t)VMOV_V2S_V3(0x29, 0);
+#else
+        *(int32_t *)&hidden[j] = VMOV_V2S_V3(0x49, 0);
+#if LANES_W == 8
+        *(int32_t *)&hidden[j + 4] = VMOV_V2S_V3(0x49, 1);
+#endif
+#endif
+    }
+}
+#endif
+
+#ifdef HWLOOP
+// Loads of one chunk of a and b. POSTINC: vld.pi moves the base register on
+// by VBYTES itself, otherwise two addi follow the loads.
+#ifdef POSTINC
+#define VLD_AB_STEP \
+        ".insn r 0x5B, 2, 6, x1, %[a], x0\n\t"      /* vld.pi v1, (a) */ \
+        ".insn r 0x5B, 2, 6, x2, %[b], x0\n\t"      /* vld.pi v2, (b) */
+#else
+#define VLD_AB_STEP \
+        ".insn r 0x5B, 2, 4, x1, %[a], x0\n\t"      /* vld v1, (a) */ \
+        ".insn r 0x5B, 2, 4, x2, %[b], x0\n\t"      /* vld v2, (b) */ \
+        "addi %[a], %[a], %[step]\n\t" \
+        "addi %[b], %[b], %[step]\n\t"
+#endif
+
+// Dot product of `chunks` VBYTES-byte chunks (chunks >= 1) in a hardware loop:
+// lp.setup makes the instructions up to the `1:` label run `chunks` times,
+// no addi/bne. The end is a label, so the body may be compressed in RVC builds.
+static inline int32_t dot_vmac_b(const int8_t *a, const int8_t *b, uint32_t chunks) {
+#ifdef VACC
+    // 5-instruction body (3 with POSTINC), one reduction after the loop
+    int32_t acc;
+    asm volatile (
+        "lp.setup %[n], 1f\n\t"
+        VLD_AB_STEP
+        "1: .insn r 0x5B, 2, 0x0A, x0, x1, x2\n\t"  // vmacc.b v1, v2
+        ".insn r 0x5B, 2, 0x0B, %[acc], x0, x0"       // vredacc acc
+        : [acc] "=r"(acc), [a] "+r"(a), [b] "+r"(b)
+        : [n] "r"(chunks), [step] "i"(VBYTES)
+        : "memory");
+    return acc;
+#else
+    int32_t acc = 0, t;
+    asm volatile (
+        "lp.setup %[n], 1f\n\t"
+        VLD_AB_STEP
+        ".insn r 0x5B, 2, 0x03, %[t], x1, x2\n\t"   // vmac.b t, v1, v2
+        "1: add %[acc], %[acc], %[t]"
+        : [acc] "+r"(acc), [a] "+r"(a), [b] "+r"(b), [t] "=&r"(t)
+        : [n] "r"(chunks), [step] "i"(VBYTES)
+        : "memory");
+    return acc;
+#endif
+}
+#endif
+
 int mlp_forward_vmac_b(const int8_t *input, int8_t *hidden, int8_t *output) {
-    // Layer 1: 784 / 8 = 98 iterations per neuron (8 lanes)
+#if INPUT_TAIL
+    // the same tail for every neuron, unmasked ops ignore vmask
+    vmsetl_b(INPUT_TAIL);
+#endif
+    // Layer 1: INPUT_BODY / LANES_B iterations per neuron (98 at VLEN=64)
     for (int j = 0; j < HIDDEN_SIZE; j++) {
+#if defined(HWLOOP) && !defined(VLDS)
+        int32_t acc = dot_vmac_b(input, W1_packed[j], INPUT_BODY / LANES_B);
+#else
         int32_t acc = 0;
-        for (int i = 0; i < INPUT_SIZE; i += 8) {
+        for (int i = 0; i < INPUT_BODY; i += LANES_B) {
             vld_v1(&input[i]);
+#ifdef VLDS
+            // column j of W1_i8 as stored, no transpose (rows past 783 meet zero inputs)
+            vlds_b_v2(&W1_i8[0][j] + i * HIDDEN_SIZE, HIDDEN_SIZE);
+#else
             vld_v2(&W1_packed[j][i]);
+#endif
+#ifdef VACC
+            vmacc_b();
+#else
             acc += vmac_b();
+#endif
         }
+#ifdef VACC
+        acc = vredacc();
+#endif
+#endif
+#if INPUT_TAIL
+        vld_m_b_v1(&input[INPUT_BODY]);
+#ifdef VLDS
+        vlds_m_b_v2(&W1_i8[INPUT_BODY][j], HIDDEN_SIZE);
+#else
+        vld_m_b_v2(&W1_packed[j][INPUT_BODY]);
+#endif
+        acc += vmac_b();
+#endif
+#ifdef REQUANT
+        hidden_acc[j] = acc;
+#else
         hidden[j] = relu_int8(acc);
+#endif
     }
+#ifdef REQUANT
+    requant_hidden(hidden);
+#endif
     
-    // Layer 2: 32 / 8 = 4 iterations per neuron
+    // Layer 2: HIDDEN_SIZE / LANES_B iterations per neuron (4 at VLEN=64)
     for (int j = 0; j < OUTPUT_SIZE; j++) {
+#ifdef HWLOOP
+        int32_t acc = dot_vmac_b(hidden, W2_packed[j], HIDDEN_SIZE / LANES_B);
+#else
         int32_t acc = 0;
-        for (int i = 0; i < HIDDEN_SIZE; i += 8) {
+        for (int i = 0; i < HIDDEN_SIZE; i += LANES_B) {
             vld_v1(&hidden[i]);
             vld_v2(&W2_packed[j][i]);
+#ifdef VACC
+            vmacc_b();
+#else
             acc += vmac_b();
+#endif
         }
+#ifdef VACC
+        acc = vredacc();
+#endif
+#endif
         output[j] = relu_int8(acc);
     }
     
+#ifdef VREDUCE
+    // OUTPUT_PAD / LANES_B chunks (one at VLEN>=128); the -128 padding never
+    // beats a ReLU output, the first maximum wins as in the scalar loop. With
+    // VMASK the lanes past OUTPUT_SIZE are masked off instead.
+    int pred = 0;
+    int32_t best = -129;
+    for (int i = 0; i < OUTPUT_SIZE; i += LANES_B) {
+#ifdef VMASK
+        vmsetl_b(OUTPUT_SIZE - i);
+        vld_m_b_v1(&output[i]);
+#else
+        vld_v1(&output[i]);
+#endif
+        int32_t m = vredmax_b();
+        if (m > best) {
+            best = m;
+            pred = i + vargmax_b();
+        }
+    }
+#else
     int pred = 0;
     for (int i = 1; i < OUTPUT_SIZE; i++) {
         if (output[i] > output[pred]) pred = i;
     }
+#endif
+    return pred;
+}
+
+#ifdef VSETL
+// ============================================================
+// Wide Vector: one strip-mined body for VMAC.H and VMAC.W
+// ============================================================
+// Dot product of `n` elements of 1 << sew bytes: every strip is what vsetl
+// grants, the last one shorter, so the rows need no padding
+static int32_t dot_vmac_v(const void *a, const void *b, uint32_t n, uint32_t sew) {
+    const uint8_t *pa = a, *pb = b;
+    int32_t acc = 0;
+    while (n) {
+        uint32_t vl = vsetl(n, sew);
+        vld_v1(pa);
+        vld_v2(pb);
+        acc += vmac_v();
+        pa += vl << sew;
+        pb += vl << sew;
+        n -= vl;
+    }
+    return acc;
+}
+
+// ReLU, and the int16 clamp of the VMAC.H kernel
+static void store_relu(void *out, int j, int32_t acc, uint32_t sew) {
+    if (acc < 0) acc = 0;
+    if (sew == 1) {
+        ((int16_t *)out)[j] = (acc > 32767) ? 32767 : (int16_t)acc;
+    } else {
+        ((int32_t *)out)[j] = acc;
+    }
+}
+
+// The MLP at SEW 1 << sew bytes (1 or 2); w1/w2 are W1_packed_h/_w, W2_packed_h/_w
+static int mlp_forward_vmac_v(uint32_t sew, const void *input, void *hidden, void *output,
+                              const void *w1, const void *w2) {
+    for (int j = 0; j < HIDDEN_SIZE; j++) {
+        const uint8_t *row = (const uint8_t *)w1 + ((uint32_t)j * INPUT_PAD << sew);
+        store_relu(hidden, j, dot_vmac_v(input, row, INPUT_SIZE, sew), sew);
+    }
+    for (int j = 0; j < OUTPUT_SIZE; j++) {
+        const uint8_t *row = (const uint8_t *)w2 + ((uint32_t)j * HIDDEN_SIZE << sew);
+        store_relu(output, j, dot_vmac_v(hidden, row, HIDDEN_SIZE, sew), sew);
+    }
+    // whole registers again for the fixed-SEW kernels
+    vsetl(LANES_B, 0);
+
+    int pred = 0;
+    for (int i = 1; i < OUTPUT_SIZE; i++) {
+        int32_t o = (sew == 1) ? ((int16_t *)output)[i] : ((int32_t *)output)[i];
+        int32_t best = (sew == 1) ? ((int16_t *)output)[pred] : ((int32_t *)output)[pred];
+        if (o > best) pred = i;
+    }
     return pred;
 }
+#endif
 
 // ============================================================
-// Wide Vector: VMAC.H (64-bit, 4 x int16 lanes)
+// Wide Vector: VMAC.H (VLEN/16 x int16 lanes)
 // ============================================================
-int16_t hidden_h[HIDDEN_SIZE] __attribute__((aligned(8)));
-int16_t output_h[OUTPUT_SIZE] __attribute__((aligned(8)));
+int16_t hidden_h[HIDDEN_SIZE] VALIGN;
+int16_t output_h[OUTPUT_SIZE] VALIGN;
 
 int mlp_forward_vmac_h(const int16_t *input, int16_t *hidden, int16_t *output) {
-    // Layer 1: 784 / 4 = 196 iterations per neuron (4 lanes)
+#ifdef VSETL
+    return mlp_forward_vmac_v(1, input, hidden, output, W1_packed_h, W2_packed_h);
+#else
+    // Layer 1: INPUT_PAD / LANES_H iterations per neuron (196 at VLEN=64)
     for (int j = 0; j < HIDDEN_SIZE; j++) {
         int32_t acc = 0;
-        for (int i = 0; i < INPUT_SIZE; i += 4) {
+        for (int i = 0; i < INPUT_PAD; i += LANES_H) {
             vld_v1(&input[i]);
             vld_v2(&W1_packed_h[j][i]);
             acc += vmac_h();
@@ -209,10 +549,10 @@ int mlp_forward_vmac_h(const int16_t *input, int16_t *hidden, int16_t *output) {
         hidden[j] = (acc < 0) ? 0 : (acc > 32767 ? 32767 : (int16_t)acc);
     }
     
-    // Layer 2: 32 / 4 = 8 iterations per neuron
+    // Layer 2: HIDDEN_SIZE / LANES_H iterations per neuron (8 at VLEN=64)
     for (int j = 0; j < OUTPUT_SIZE; j++) {
         int32_t acc = 0;
-        for (int i = 0; i < HIDDEN_SIZE; i += 4) {
+        for (int i = 0; i < HIDDEN_SIZE; i += LANES_H) {
             vld_v1(&hidden[i]);
             vld_v2(&W2_packed_h[j][i]);
             acc += vmac_h();
@@ -225,19 +565,23 @@ int mlp_forward_vmac_h(const int16_t *input, int16_t *hidden, int16_t *output) {
         if (output[i] > output[pred]) pred = i;
     }
     return pred;
+#endif
 }
 
 // ============================================================
-// Wide Vector: VMAC.W (64-bit, 2 x int32 lanes)
+// Wide Vector: VMAC.W (VLEN/32 x int32 lanes)
 // ============================================================
-int32_t hidden_w[HIDDEN_SIZE] __attribute__((aligned(8)));
-int32_t output_w[OUTPUT_SIZE] __attribute__((aligned(8)));
+int32_t hidden_w[HIDDEN_SIZE] VALIGN;
+int32_t output_w[OUTPUT_SIZE] VALIGN;
 
 int mlp_forward_vmac_w(const int32_t *input, int32_t *hidden, int32_t *output) {
-    // Layer 1: 784 / 2 = 392 iterations per neuron (2 lanes)
+#ifdef VSETL
+    return mlp_forward_vmac_v(2, input, hidden, output, W1_packed_w, W2_packed_w);
+#else
+    // Layer 1: INPUT_PAD / LANES_W iterations per neuron (392 at VLEN=64)
     for (int j = 0; j < HIDDEN_SIZE; j++) {
         int32_t acc = 0;
-        for (int i = 0; i < INPUT_SIZE; i += 2) {
+        for (int i = 0; i < INPUT_PAD; i += LANES_W) {
             vld_v1(&input[i]);
             vld_v2(&W1_packed_w[j][i]);
             acc += vmac_w();
@@ -245,10 +589,10 @@ int mlp_forward_vmac_w(const int32_t *input, int32_t *hidden, int32_t *output) {
         hidden[j] = (acc < 0) ? 0 : acc;
     }
     
-    // Layer 2: 32 / 2 = 16 iterations per neuron
+    // Layer 2: HIDDEN_SIZE / LANES_W iterations per neuron (16 at VLEN=64)
     for (int j = 0; j < OUTPUT_SIZE; j++) {
         int32_t acc = 0;
-        for (int i = 0; i < HIDDEN_SIZE; i += 2) {
+        for (int i = 0; i < HIDDEN_SIZE; i += LANES_W) {
             vld_v1(&hidden[i]);
             vld_v2(&W2_packed_w[j][i]);
             acc += vmac_w();
@@ -261,21 +605,25 @@ int mlp_forward_vmac_w(const int32_t *input, int32_t *hidden, int32_t *output) {
         if (output[i] > output[pred]) pred = i;
     }
     return pred;
+#endif
 }
 
 // ============================================================
 // Main
 // ============================================================
 int main(void) {
-    printf("=== SEW Compare ===\n");
+    printf("=== SEW Compare (VLEN=%d) ===\n", VLEN);
     
     // Prepare input for INT8
-    int8_t input[INPUT_SIZE] __attribute__((aligned(8)));
-    int8_t hidden[HIDDEN_SIZE] __attribute__((aligned(8)));
-    int8_t output[OUTPUT_SIZE] __attribute__((aligned(8)));
+    static int8_t input[INPUT_PAD] TCM;
+    static int8_t hidden[HIDDEN_SIZE] TCM;
+    int8_t output[OUTPUT_PAD] VALIGN;
+    for (int i = OUTPUT_SIZE; i < OUTPUT_PAD; i++) {
+        output[i] = -128;
+    }
     
-    for (int i = 0; i < INPUT_SIZE; i++) {
-        int8_t val = (int8_t)(test_images[0][i] * 127.0f);
+    for (int i = 0; i < INPUT_PAD; i++) {
+        int8_t val = (i < INPUT_SIZE) ? (int8_t)(test_images[0][i] * 127.0f) : 0;
         input[i] = val;
         input_h[i] = (int16_t)val;  // Extend to INT16
         input_w[i] = (int32_t)val;  // Extend to INT32
@@ -293,6 +641,20 @@ int main(void) {
     
     unsigned int c0, c1, c2, c3, c4, c5;
     
+    // hardware performance counters over the timed section
+    hpm_set_event(3, HPM_EV_VEC_RETIRE);
+    hpm_set_event(4, HPM_EV_VLSU_BUSY);
+    hpm_set_event(5, HPM_EV_MEM_STALL);
+    hpm_set_event(6, HPM_EV_BRANCH_TAKEN);
+    for (int n = 3; n < 3 + HPM_NUM_COUNTERS; n++) {
+        hpm_write_counter(n, 0);
+    }
+    uint64_t i0 = read_instret64();
+#ifdef PROFILE
+    // sample the timed section every 1000 cycles (timer, the HPM counters are in use)
+    profile_start(PROF_SRC_TIMER, 0, 1000);
+#endif
+    
     // Benchmark Scalar (no SIMD, 1 lane)
     c0 = read_cycle_counter();
     mlp_forward_scalar(input, hidden, output);
@@ -301,20 +663,33 @@ int main(void) {
     c1 = read_cycle_counter();
     mlp_forward_pvmac(input, hidden, output);
     
-    // Benchmark VMAC.B (8 lanes, SEW=8)
+    // Benchmark VMAC.B (VLEN/8 lanes, SEW=8)
     c2 = read_cycle_counter();
     mlp_forward_vmac_b(input, hidden, output);
     
-    // Benchmark VMAC.H (4 lanes, SEW=16)
+    // Benchmark VMAC.H (VLEN/16 lanes, SEW=16)
     c3 = read_cycle_counter();
     mlp_forward_vmac_h(input_h, hidden_h, output_h);
     
-    // Benchmark VMAC.W (2 lanes, SEW=32)
+    // Benchmark VMAC.W (VLEN/32 lanes, SEW=32)
     c4 = read_cycle_counter();
     mlp_forward_vmac_w(input_w, hidden_w, output_w);
     c5 = read_cycle_counter();
+    uint64_t i1 = read_instret64();
+#ifdef PROFILE
+    profile_stop();
+#endif
     
     printf("Done.\n");
+    printf("HPM: %u instret, %u vector ops, %u VLSU busy, %u MEM stall, %u branches taken\n",
+           (unsigned int)(i1 - i0), hpm_read(3), hpm_read(4), hpm_read(5), hpm_read(6));
+    printf("Prefetch: %u useful, %u useless\n",
+           read_pf_useful_counter(), read_pf_useless_counter());
+    printf("Branches: %u predicted, %u mispredicted\n",
+           read_bp_predict_counter(), read_bp_mispredict_counter());
+#ifdef PROFILE
+    profile_dump();
+#endif
     
     asm volatile ("ebreak");
     return 0;
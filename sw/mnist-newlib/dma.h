@@ -0,0 +1,65 @@
+// MMIO DMA engine (dma.v), registers at 0x10001000
+// Copies `rows` rows of `len` bytes (multiple of 4) while the core keeps
+// running; the core has priority on the data ports, the DMA uses idle cycles.
+//
+// Double-buffering example (weight tiles in the scratchpad):
+//   dma_copy_2d(tile[1], &W[next][0], TILE_BYTES, 1, 0, 0);
+//   ... VLD/VMAC on tile[0] ...
+//   dma_wait();
+//
+// Ordering with the core (DESIGN_DECISIONS.md section 11):
+// - Stores and VSTs before dma_copy*() need no fence. MMIO accesses wait for
+//   queued VLD/VSTs and for the write buffer to drain, so the DMA_CTRL store
+//   that starts the copy is ordered behind them.
+// - Copy writes drop matching lines in the vector prefetcher. The instruction
+//   prefetch buffer does not see them, so never copy into code.
+// - Core accesses to a buffer a copy is reading or writing race with it:
+//   dma_wait() before reading the destination or reusing the source.
+
+#ifndef DMA_H
+#define DMA_H
+
+#include <stdint.h>
+
+#define DMA_BASE        0x10001000u
+#define DMA_SRC         (*(volatile uint32_t *)(DMA_BASE + 0x00))
+#define DMA_DST         (*(volatile uint32_t *)(DMA_BASE + 0x04))
+#define DMA_LEN         (*(volatile uint32_t *)(DMA_BASE + 0x08))
+#define DMA_ROWS        (*(volatile uint32_t *)(DMA_BASE + 0x0c))
+#define DMA_SRC_STRIDE  (*(volatile uint32_t *)(DMA_BASE + 0x10))
+#define DMA_DST_STRIDE  (*(volatile uint32_t *)(DMA_BASE + 0x14))
+#define DMA_CTRL        (*(volatile uint32_t *)(DMA_BASE + 0x18))
+#define DMA_STATUS      (*(volatile uint32_t *)(DMA_BASE + 0x1c))
+
+#define DMA_CTRL_START   0x1u
+#define DMA_STATUS_BUSY  0x1u
+#define DMA_STATUS_DONE  0x2u
+
+// Start a 2D copy: `rows` rows of `len` bytes, rows `src_stride`/`dst_stride` apart
+static inline void dma_copy_2d(void *dst, const void *src, uint32_t len, uint32_t rows,
+                               uint32_t src_stride, uint32_t dst_stride) {
+    DMA_SRC = (uint32_t)src;
+    DMA_DST = (uint32_t)dst;
+    DMA_LEN = len;
+    DMA_ROWS = rows;
+    DMA_SRC_STRIDE = src_stride;
+    DMA_DST_STRIDE = dst_stride;
+    DMA_CTRL = DMA_CTRL_START;
+}
+
+static inline void dma_copy(void *dst, const void *src, uint32_t len) {
+    dma_copy_2d(dst, src, len, 1, 0, 0);
+}
+
+static inline int dma_busy(void) {
+    return (DMA_STATUS & DMA_STATUS_BUSY) != 0;
+}
+
+// Wait for the last copy and clear the done flag
+static inline void dma_wait(void) {
+    while (dma_busy()) {
+    }
+    DMA_STATUS = DMA_STATUS_DONE;
+}
+
+#endif
@@ -0,0 +1,85 @@
+// Zicntr / Zihpm counters (csr.v)
+// 64-bit cycle, time and instret, plus hpmcounter3..6 counting the event
+// selected in mhpmevent3..6. Bit 31 of mhpmevent is the overflow flag.
+//
+// Example, vector work and stalls of one kernel:
+//   hpm_set_event(3, HPM_EV_VEC_RETIRE);
+//   hpm_set_event(4, HPM_EV_MEM_STALL);
+//   hpm_write_counter(3, 0); hpm_write_counter(4, 0);
+//   ... kernel ...
+//   printf("%u vector ops, %u stall cycles\n", hpm_read(3), hpm_read(4));
+
+#ifndef HPM_H
+#define HPM_H
+
+#include <stdint.h>
+
+// mhpmevent values
+#define HPM_EV_NONE          0u
+#define HPM_EV_VEC_RETIRE    1u  // vector instructions retired
+#define HPM_EV_VLSU_BUSY     2u  // cycles the vector load/store unit owns the data bus
+#define HPM_EV_MEM_STALL     3u  // cycles waiting for a data memory response
+#define HPM_EV_BRANCH_TAKEN  4u  // conditional branches taken
+#define HPM_EV_CYCLE         5u  // every cycle (sampling period for profile.c)
+#define HPM_EV_RETIRE        6u  // instructions retired
+
+#define HPM_NUM_COUNTERS     4   // hpmcounter3 .. hpmcounter6
+
+#define HPM_STR(x) #x
+#define HPM_XSTR(x) HPM_STR(x)
+
+#define csr_read(addr) ({ \
+    uint32_t __v; \
+    asm volatile ("csrr %0, " HPM_XSTR(addr) : "=r"(__v)); \
+    __v; \
+})
+
+#define csr_write(addr, val) \
+    asm volatile ("csrw " HPM_XSTR(addr) ", %0" :: "r"((uint32_t)(val)))
+
+// 64-bit read of a counter pair, retried if the low half wrapped in between
+#define csr_read64(lo, hi) ({ \
+    uint32_t __h, __l, __h2; \
+    do { \
+        __h = csr_read(hi); \
+        __l = csr_read(lo); \
+        __h2 = csr_read(hi); \
+    } while (__h != __h2); \
+    ((uint64_t)__h << 32) | __l; \
+})
+
+static inline uint64_t read_cycle64(void)   { return csr_read64(0xC00, 0xC80); }
+static inline uint64_t read_time64(void)    { return csr_read64(0xC01, 0xC81); }
+static inline uint64_t read_instret64(void) { return csr_read64(0xC02, 0xC82); }
+
+// n = 3 .. 6; the CSR address has to be a constant, hence the switch
+static inline void hpm_set_event(int n, uint32_t event) {
+    switch (n) {
+    case 3: csr_write(0x323, event); break;
+    case 4: csr_write(0x324, event); break;
+    case 5: csr_write(0x325, event); break;
+    case 6: csr_write(0x326, event); break;
+    }
+}
+
+static inline void hpm_write_counter(int n, uint32_t value) {
+    switch (n) {
+    case 3: csr_write(0xB83, 0); csr_write(0xB03, value); break;
+    case 4: csr_write(0xB84, 0); csr_write(0xB04, value); break;
+    case 5: csr_write(0xB85, 0); csr_write(0xB05, value); break;
+    case 6: csr_write(0xB86, 0); csr_write(0xB06, value); break;
+    }
+}
+
+// low 32 bits of hpmcounterN
+static inline uint32_t hpm_read(int n) {
+    switch (n) {
+    case 3: return csr_read(0xC03);
+    case 4: return csr_read(0xC04);
+    case 5: return csr_read(0xC05);
+    case 6: return csr_read(0xC06);
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,112 @@
+// Sampling profiler, see profile.h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "profile.h"
+
+#define MSTATUS_MIE  (1u << 3)
+#define MIE_MTIE     (1u << 7)
+#define MIE_LCOFIE   (1u << 13)
+#define MIP_LCOFIP   (1u << 13)
+
+#define MCAUSE_IRQ   0x80000000u
+#define IRQ_MTI      7u
+#define IRQ_LCOFI    13u
+
+static uint32_t prof_pc[PROFILE_MAX_SAMPLES];
+static volatile uint32_t prof_count;
+static volatile uint32_t prof_dropped;
+static uint32_t prof_period;
+static uint32_t prof_event;
+static int prof_registered;
+
+// next timer sample `prof_period` cycles after the current compare value
+static void timer_rearm(void) {
+    uint32_t lo = CLINT_MTIMECMP;
+    uint32_t hi = CLINT_MTIMECMPH;
+    uint32_t next = lo + prof_period;
+    if (next < lo) {
+        hi++;
+    }
+    // no spurious interrupt while the halves are updated
+    CLINT_MTIMECMPH = 0xffffffffu;
+    CLINT_MTIMECMP = next;
+    CLINT_MTIMECMPH = hi;
+}
+
+// hpmcounter3 overflows after `prof_period` more events
+static void hpm_rearm(void) {
+    csr_write(0xB83, 0xffffffffu);
+    csr_write(0xB03, 0u - prof_period);
+    csr_write(0x323, prof_event);  // clears OF
+    asm volatile ("csrc mip, %0" :: "r"(MIP_LCOFIP));
+}
+
+static void __attribute__((interrupt("machine"), aligned(4))) profile_trap(void) {
+    uint32_t cause = csr_read(0x342);
+    uint32_t n = prof_count;
+
+    if (n < PROFILE_MAX_SAMPLES) {
+        prof_pc[n] = csr_read(0x341);
+        prof_count = n + 1;
+    } else {
+        prof_dropped++;
+    }
+
+    if (cause == (MCAUSE_IRQ | IRQ_MTI)) {
+        timer_rearm();
+    } else if (cause == (MCAUSE_IRQ | IRQ_LCOFI)) {
+        hpm_rearm();
+    } else {
+        // not ours (ECALL or an unexpected interrupt): stop the simulation
+        asm volatile ("ebreak");
+    }
+}
+
+void profile_start(int source, uint32_t event, uint32_t period) {
+    prof_count = 0;
+    prof_dropped = 0;
+    prof_period = period;
+    prof_event = event;
+    if (!prof_registered) {
+        atexit(profile_dump);
+        prof_registered = 1;
+    }
+
+    csr_write(0x305, (uint32_t)(uintptr_t)profile_trap);  // mtvec, direct mode
+    if (source == PROF_SRC_TIMER) {
+        uint32_t hi = CLINT_MTIMEH;
+        uint32_t lo = CLINT_MTIME;
+        CLINT_MTIMECMPH = 0xffffffffu;
+        CLINT_MTIMECMP = lo;
+        CLINT_MTIMECMPH = hi;
+        timer_rearm();
+        csr_write(0x304, MIE_MTIE);
+    } else {
+        hpm_rearm();
+        csr_write(0x304, MIE_LCOFIE);
+    }
+    asm volatile ("csrs mstatus, %0" :: "r"(MSTATUS_MIE));
+}
+
+void profile_stop(void) {
+    asm volatile ("csrc mstatus, %0" :: "r"(MSTATUS_MIE));
+    csr_write(0x304, 0);
+    csr_write(0x323, HPM_EV_NONE);
+}
+
+void profile_dump(void) {
+    static int dumped;
+
+    profile_stop();
+    if (dumped) {
+        return;
+    }
+    dumped = 1;
+
+    printf("PROF samples=%u dropped=%u period=%u\n",
+           (unsigned int)prof_count, (unsigned int)prof_dropped, (unsigned int)prof_period);
+    for (uint32_t i = 0; i < prof_count; i++) {
+        printf("PROF %08x\n", (unsigned int)prof_pc[i]);
+    }
+}
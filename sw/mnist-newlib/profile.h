@@ -0,0 +1,42 @@
+// Sampling profiler: the interrupt handler records the interrupted PC
+// (mepc) every `period` cycles (CLINT timer) or every `period` events
+// (hpmcounter3 overflow), profile_dump() prints the samples over the UART.
+//
+//   profile_start(PROF_SRC_HPM, HPM_EV_CYCLE, 1000);
+//   ... workload ...
+//   profile_dump();
+//
+// Output lines are "PROF <pc>"; scripts/profile_report.py turns them into a
+// per-function histogram using the firmware ELF.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include "hpm.h"
+
+#ifndef PROFILE_MAX_SAMPLES
+#define PROFILE_MAX_SAMPLES 4096
+#endif
+
+#define PROF_SRC_TIMER  0  // CLINT mtimecmp, period in cycles
+#define PROF_SRC_HPM    1  // hpmcounter3 overflow (takes that counter), period in HPM_EV_* events
+
+// CLINT registers (clint.v)
+#define CLINT_BASE       0x02000000u
+#define CLINT_MSIP       (*(volatile uint32_t *)(CLINT_BASE + 0x0000))
+#define CLINT_MTIMECMP   (*(volatile uint32_t *)(CLINT_BASE + 0x4000))
+#define CLINT_MTIMECMPH  (*(volatile uint32_t *)(CLINT_BASE + 0x4004))
+#define CLINT_MTIME      (*(volatile uint32_t *)(CLINT_BASE + 0xbff8))
+#define CLINT_MTIMEH     (*(volatile uint32_t *)(CLINT_BASE + 0xbffc))
+
+// Install the handler and start sampling; `event` is only used with PROF_SRC_HPM
+void profile_start(int source, uint32_t event, uint32_t period);
+
+// Stop sampling (interrupts off), samples are kept
+void profile_stop(void);
+
+// Stop sampling and print the samples; also registered with atexit()
+void profile_dump(void);
+
+#endif
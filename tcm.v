@@ -0,0 +1,71 @@
+// tightly-coupled vector scratchpad (TCM)
+// 64 KB at 0x2000_0000, stored as VLEN-bit lines.
+// Port A: 32-bit scalar port on the shared data bus (decoded in top.v),
+//         used by firmware to fill/read the scratchpad.
+// Port V: VLEN-bit port private to the vector unit, one VLD/VST line per
+//         request (VLEN/8-byte aligned), read data valid on the next cycle. It never touches the
+//         shared bus, so it does not contend with scalar loads, fetch or UART.
+
+module tcm #(
+  parameter SIZE_BYTES = 65536,
+  parameter VLEN = 64
+) (
+  input clk,
+
+  // scalar port (32-bit)
+  input [31:0] a_addr,
+  input [31:0] a_wdata,
+  input [3:0]  a_wmask,
+  input        a_write,
+  input        a_valid,
+  output [31:0] a_rdata,
+  output reg   a_resp_valid,
+
+  // vector port (VLEN bits)
+  input [31:0] v_addr,
+  input [VLEN-1:0] v_wdata,
+  input        v_write,
+  input        v_valid,
+  output reg [VLEN-1:0] v_rdata
+);
+
+  localparam LINE_SHIFT = $clog2(VLEN / 8); // byte offset bits of a line
+  localparam LINES = SIZE_BYTES / (VLEN / 8);
+  localparam IDX_BITS = $clog2(LINES);
+
+  reg [VLEN-1:0] mem [0:LINES-1];
+
+  wire [IDX_BITS-1:0] a_idx = a_addr[IDX_BITS+LINE_SHIFT-1:LINE_SHIFT];
+  wire [IDX_BITS-1:0] v_idx = v_addr[IDX_BITS+LINE_SHIFT-1:LINE_SHIFT];
+
+  // scalar port, same 1-cycle response as the SRAM
+  reg [31:0] a_raddr_reg;
+  always @(posedge clk) begin
+    if (a_valid && !a_write) begin
+      a_raddr_reg <= a_addr;
+    end
+    a_resp_valid <= a_valid && !a_write;
+  end
+  wire [VLEN-1:0] a_line = mem[a_raddr_reg[IDX_BITS+LINE_SHIFT-1:LINE_SHIFT]];
+  assign a_rdata = a_line[a_raddr_reg[LINE_SHIFT-1:2]*32 +: 32];
+
+  integer b;
+  always @(posedge clk) begin
+    if (a_valid && a_write) begin
+      for (b = 0; b < 4; b = b + 1) begin
+        if (a_wmask[b]) begin
+          mem[a_idx][a_addr[LINE_SHIFT-1:2]*32 + b*8 +: 8] <= a_wdata[b*8 +: 8];
+        end
+      end
+    end
+
+    // vector port, whole line
+    if (v_valid && v_write) begin
+      mem[v_idx] <= v_wdata;
+    end
+    if (v_valid && !v_write) begin
+      v_rdata <= mem[v_idx];
+    end
+  end
+
+endmodule
@@ -7,6 +7,34 @@
 # Default: disabled for long simulations like MNIST
 ENABLE_TRACE=${ENABLE_TRACE:-0}
 
+# Memory system knobs (passed to top.v as parameters)
+# DMEM_LATENCY: SRAM data port read latency in cycles (default 1)
+# VPREFETCH:    1 = vector stride prefetcher enabled, 0 = pass-through
+# WBUF:         1 = stores retire into the write buffer, 0 = wait for the bus
+# IPREFETCH:    1 = instruction prefetch buffer (FSM core skips STATE_FETCH), 0 = off
+# VDECOUPLE:    1 = vector ops retire into an issue queue (FSM core), 0 = wait for the vector units
+# BPRED:        1 = BTB/bimodal/RAS branch prediction (pipelined core), 0 = not-taken
+# ALU_ADDER/PC_ADDER: adder_32 architecture, 0 = ripple carry, 1 = carry lookahead,
+#               2 = Kogge-Stone, 3 = behavioral (fastest to simulate)
+# VALU_MULS:    VALU lane multipliers, 4, 8 or 16 (see scripts/valu_sweep.sh)
+# VLEN:         vector register width, 64, 128 or 256; build the firmware with
+#               the same VLEN (make VLEN=128 ...)
+# PIPELINE:     1 = five-stage pipelined core (ucrv32_pipe.v), 0 = multi-cycle FSM core
+DMEM_LATENCY=${DMEM_LATENCY:-1}
+VPREFETCH=${VPREFETCH:-1}
+WBUF=${WBUF:-1}
+IPREFETCH=${IPREFETCH:-1}
+VDECOUPLE=${VDECOUPLE:-1}
+BPRED=${BPRED:-1}
+ALU_ADDER=${ALU_ADDER:-0}
+PC_ADDER=${PC_ADDER:-0}
+VALU_MULS=${VALU_MULS:-4}
+VLEN=${VLEN:-64}
+PIPELINE=${PIPELINE:-0}
+
+# MEM_TRACE=1 makes the simulator write <test>_mem_trace.bin, one record per
+# data memory request (see sim/mem_trace.h, replay it with tools/memreplay)
+
 # =============================================================================
 # Verilator Compilation
 # =============================================================================
@@ -27,7 +55,10 @@ verilator -Wall \
    -Werror-UNUSED \
    --cc --exe --build --top top --public -j 0 $TRACE_FLAG \
    -CFLAGS "-std=c++17" \
-   top.v ucrv32.v efu.v alu.v decoder_control.v top.cc sim/libSimHelper.cc
+   -GDMEM_LATENCY=$DMEM_LATENCY -GVPREFETCH_EN=$VPREFETCH -GWBUF_EN=$WBUF \
+   -GIPREFETCH_EN=$IPREFETCH -GVDECOUPLE_EN=$VDECOUPLE -GBPRED_EN=$BPRED -GPIPELINE=$PIPELINE \
+   -GALU_ADDER=$ALU_ADDER -GPC_ADDER=$PC_ADDER -GVALU_MULS=$VALU_MULS -GVLEN=$VLEN \
+   top.v ucrv32.v efu.v alu.v decoder_control.v csr.v top.cc sim/libSimHelper.cc
 
 if [ $? -eq 0 ]; then
     echo "Compilation successful. Running simulation..."
@@ -1380,6 +1380,7 @@ validate_riscv_insn (const struct riscv_opcode *opc, int length)
 	case 'j': used_bits |= ENCODE_ITYPE_IMM (-1U); break;
 	case 'a': used_bits |= ENCODE_JTYPE_IMM (-1U); break;
 	case 'p': used_bits |= ENCODE_BTYPE_IMM (-1U); break;
+	case 'h': used_bits |= ENCODE_ITYPE_IMM (-1U); break;
 	case 'q': used_bits |= ENCODE_STYPE_IMM (-1U); break;
 	case 'u': used_bits |= ENCODE_UTYPE_IMM (-1U); break;
 	case 'z': break; /* Zero immediate.  */
@@ -1619,6 +1620,9 @@ append_insn (struct riscv_cl_insn *ip, expressionS *address_expr,
 			    address_expr->X_add_number);
 	  return;
 	}
+      else if (reloc_type == BFD_RELOC_RISCV_LP_END)
+	ip->fixp = fix_new_exp (ip->frag, ip->where, 4, address_expr, true,
+				reloc_type);
       else
 	{
 	  howto = bfd_reloc_type_lookup (stdoutput, reloc_type);
@@ -3346,6 +3350,12 @@ riscv_ip (char *str, struct riscv_cl_insn *ip, expressionS *imm_expr,
 	      asarg = expr_parse_end;
 	      continue;
 
+	    case 'h': /* lp.setup loop end, halfwords from this insn.  */
+	      *imm_reloc = BFD_RELOC_RISCV_LP_END;
+	      my_getExpression (imm_expr, asarg);
+	      asarg = expr_parse_end;
+	      continue;
+
 	    case 'u': /* Upper 20 bits.  */
 	      p = percent_op_utype;
 	      if (!my_getSmallExpression (imm_expr, imm_reloc, asarg, p))
@@ -3996,6 +4006,23 @@ md_apply_fix (fixS *fixP, valueT *valP, segT seg ATTRIBUTE_UNUSED)
   /* Remember value for tc_gen_reloc.  */
   fixP->fx_addnumber = *valP;
 
+  /* The lp.setup loop end never reaches the object file.  */
+  if (fixP->fx_r_type == BFD_RELOC_RISCV_LP_END)
+    {
+      if (fixP->fx_addsy)
+	as_bad_where (fixP->fx_file, fixP->fx_line,
+		      _("lp.setup end must be a label in the same section"));
+      else if ((*valP & 1) != 0 || *valP == 0 || *valP >= 2 * RISCV_IMM_REACH)
+	as_bad_where (fixP->fx_file, fixP->fx_line,
+		      _("lp.setup end out of range (%d bytes)"), (int) *valP);
+      else
+	{
+	  bfd_putl32 (bfd_getl32 (buf) | ENCODE_ITYPE_IMM (*valP >> 1), buf);
+	  fixP->fx_done = true;
+	}
+      return;
+    }
+
   switch (fixP->fx_r_type)
     {
     case BFD_RELOC_RISCV_HI20:
@@ -80,6 +80,11 @@ extern int riscv_parse_long_option (const char *);
 extern void riscv_pre_output_hook (void);
 #define GAS_SORT_RELOCS 1
 
+/* The lp.setup loop end, a halfword offset in the ITYPE immediate.  There
+   is no ELF relocation for it, the assembler resolves it (the end label
+   must be in the same section).  */
+#define BFD_RELOC_RISCV_LP_END ((bfd_reloc_code_real_type) (BFD_RELOC_UNUSED + 1))
+
 /* Let the linker resolve all the relocs due to relaxation.  */
 #define tc_fix_adjustable(fixp) 0
 #define md_allow_local_subtract(l,r,s) 0
@@ -98,7 +103,8 @@ extern void riscv_pre_output_hook (void);
    || ((SEG)->flags & SEC_CODE) != 0)
 #define TC_FORCE_RELOCATION_SUB_LOCAL(FIX, SEG) 1
 #define TC_VALIDATE_FIX_SUB(FIX, SEG) 1
-#define TC_FORCE_RELOCATION_LOCAL(FIX) 1
+#define TC_FORCE_RELOCATION_LOCAL(FIX) \
+  ((FIX)->fx_r_type != BFD_RELOC_RISCV_LP_END)
 #define DIFF_EXPR_OK 1
 
 extern void riscv_pop_insert (void);
@@ -2988,10 +2988,10 @@
 #define MATCH_VMAC_B      0x0600205b
 #define MASK_VMAC_B       0xfe00707f
 /* VMAC.H: SEW=01 (16-bit, 4 lanes) */
-#define MATCH_VMAC_H      0x2600205b
+#define MATCH_VMAC_H      0x4600205b
 #define MASK_VMAC_H       0xfe00707f
 /* VMAC.W: SEW=10 (32-bit, 2 lanes) */
-#define MATCH_VMAC_W      0x4600205b
+#define MATCH_VMAC_W      0x8600205b
 #define MASK_VMAC_W       0xfe00707f
 
 /* VLD  */
@@ -3002,6 +3002,248 @@
 #define MATCH_VST         0x0a00205b
 #define MASK_VST          0xfe00707f  /* d,s,t format - rd specified by assembler */
 
+/* Post-increment VLD/VST: rs1 += VLEN/8 (.pi) or rs1 += rs2 (.pr) after the access */
+/* VLD.PI vd, rs1: funct7=0000110, rs2=0 */
+#define MATCH_VLD_PI      0x0c00205b
+#define MASK_VLD_PI       0xfff0707f
+/* VST.PI vs2, rs1: funct7=0000111, rd=0 */
+#define MATCH_VST_PI      0x0e00205b
+#define MASK_VST_PI       0xfe007fff
+/* VLD.PR vd, rs1, rs2: funct7=0001100 */
+#define MATCH_VLD_PR      0x1800205b
+#define MASK_VLD_PR       0xfe00707f
+
+/* VLDS vd, rs1, rs2 - strided: element k from rs1 + k*rs2; funct7[4:0]=01101, [6:5]=SEW */
+#define MATCH_VLDS_B      0x1a00205b
+#define MASK_VLDS_B       0xfe00707f
+#define MATCH_VLDS_H      0x5a00205b
+#define MASK_VLDS_H       0xfe00707f
+#define MATCH_VLDS_W      0x9a00205b
+#define MASK_VLDS_W       0xfe00707f
+
+/* VLDX vd, rs1, vs2 - indexed: element k from rs1 + vs2[k] (unsigned); funct7[4:0]=01110 */
+#define MATCH_VLDX_B      0x1c00205b
+#define MASK_VLDX_B       0xfe00707f
+#define MATCH_VLDX_H      0x5c00205b
+#define MASK_VLDX_H       0xfe00707f
+#define MATCH_VLDX_W      0x9c00205b
+#define MASK_VLDX_W       0xfe00707f
+
+/* VMACC - per-lane multiply-accumulate into the VALU accumulator, rd=0 */
+/* funct7[4:0]=01010, funct7[6:5]=SEW */
+#define MATCH_VMACC_B     0x1400205b
+#define MASK_VMACC_B      0xfe007fff
+#define MATCH_VMACC_H     0x5400205b
+#define MASK_VMACC_H      0xfe007fff
+#define MATCH_VMACC_W     0x9400205b
+#define MASK_VMACC_W      0xfe007fff
+
+/* VREDACC rd - sum of the accumulator lanes, clears it; funct7=0001011, rs1=rs2=0 */
+#define MATCH_VREDACC     0x1600205b
+#define MASK_VREDACC      0xfffff07f
+
+/* VMOV.S2V vd, rs1, lane - vd[lane] = rs1; funct7[4:0]=01000, lane in the rs2 field */
+#define MATCH_VMOV_S2V_B  0x1000205b
+#define MASK_VMOV_S2V_B   0xfe00707f
+#define MATCH_VMOV_S2V_H  0x5000205b
+#define MASK_VMOV_S2V_H   0xfe00707f
+#define MATCH_VMOV_S2V_W  0x9000205b
+#define MASK_VMOV_S2V_W   0xfe00707f
+
+/* VMOV.V2S rd, vs1, lane - rd = vs1[lane] sign-extended; funct7[4:0]=01001 */
+#define MATCH_VMOV_V2S_B  0x1200205b
+#define MASK_VMOV_V2S_B   0xfe00707f
+#define MATCH_VMOV_V2S_H  0x5200205b
+#define MASK_VMOV_V2S_H   0xfe00707f
+#define MATCH_VMOV_V2S_W  0x9200205b
+#define MASK_VMOV_V2S_W   0xfe00707f
+
+/* .vx forms vd, vs1, rs2 - rs2 broadcast to every lane; funct7[4:0]=100xx (xx = .vv op) */
+#define MATCH_VADD_VX_B   0x2000205b
+#define MASK_VADD_VX_B    0xfe00707f
+#define MATCH_VADD_VX_H   0x6000205b
+#define MASK_VADD_VX_H    0xfe00707f
+#define MATCH_VADD_VX_W   0xa000205b
+#define MASK_VADD_VX_W    0xfe00707f
+#define MATCH_VSUB_VX_B   0x2200205b
+#define MASK_VSUB_VX_B    0xfe00707f
+#define MATCH_VSUB_VX_H   0x6200205b
+#define MASK_VSUB_VX_H    0xfe00707f
+#define MATCH_VSUB_VX_W   0xa200205b
+#define MASK_VSUB_VX_W    0xfe00707f
+#define MATCH_VMUL_VX_B   0x2400205b
+#define MASK_VMUL_VX_B    0xfe00707f
+#define MATCH_VMUL_VX_H   0x6400205b
+#define MASK_VMUL_VX_H    0xfe00707f
+#define MATCH_VMUL_VX_W   0xa400205b
+#define MASK_VMUL_VX_W    0xfe00707f
+#define MATCH_VMAC_VX_B   0x2600205b
+#define MASK_VMAC_VX_B    0xfe00707f
+#define MATCH_VMAC_VX_H   0x6600205b
+#define MASK_VMAC_VX_H    0xfe00707f
+#define MATCH_VMAC_VX_W   0xa600205b
+#define MASK_VMAC_VX_W    0xfe00707f
+
+/* VNCLIP vd, vs1, rs2 - int32 lanes of vs1, (x + round) >> rs2[4:0] + rs2[31:16],
+   saturated to SEW and packed into the low elements of vd; .relu clamps at 0 */
+#define MATCH_VNCLIP_B    0x2800205b
+#define MASK_VNCLIP_B     0xfe00707f
+#define MATCH_VNCLIP_H    0x6800205b
+#define MASK_VNCLIP_H     0xfe00707f
+#define MATCH_VNCLIP_RELU_B 0x2a00205b
+#define MASK_VNCLIP_RELU_B  0xfe00707f
+#define MATCH_VNCLIP_RELU_H 0x6a00205b
+#define MASK_VNCLIP_RELU_H  0xfe00707f
+
+/* VNCLIP.ACC vd, rs2 - the same on the VLEN/8 VMACC accumulator lanes, always to
+   int8, so vd is filled; rs1=0, clears the accumulator. funct7[4:0]=11010, .relu 11011 */
+#define MATCH_VNCLIP_ACC_B      0x3400205b
+#define MASK_VNCLIP_ACC_B       0xfe0ff07f
+#define MATCH_VNCLIP_ACC_RELU_B 0x3600205b
+#define MASK_VNCLIP_ACC_RELU_B  0xfe0ff07f
+
+/* Reductions rd, vs1 - signed elements of vs1 to a scalar, rs2=0; VARGMAX is the
+   lowest lane holding the maximum. funct7[4:0]=10110 sum, 10111 max, 11000 min, 11001 argmax */
+#define MATCH_VREDSUM_B   0x2c00205b
+#define MASK_VREDSUM_B    0xfff0707f
+#define MATCH_VREDSUM_H   0x6c00205b
+#define MASK_VREDSUM_H    0xfff0707f
+#define MATCH_VREDSUM_W   0xac00205b
+#define MASK_VREDSUM_W    0xfff0707f
+#define MATCH_VREDMAX_B   0x2e00205b
+#define MASK_VREDMAX_B    0xfff0707f
+#define MATCH_VREDMAX_H   0x6e00205b
+#define MASK_VREDMAX_H    0xfff0707f
+#define MATCH_VREDMAX_W   0xae00205b
+#define MASK_VREDMAX_W    0xfff0707f
+#define MATCH_VREDMIN_B   0x3000205b
+#define MASK_VREDMIN_B    0xfff0707f
+#define MATCH_VREDMIN_H   0x7000205b
+#define MASK_VREDMIN_H    0xfff0707f
+#define MATCH_VREDMIN_W   0xb000205b
+#define MASK_VREDMIN_W    0xfff0707f
+#define MATCH_VARGMAX_B   0x3200205b
+#define MASK_VARGMAX_B    0xfff0707f
+#define MATCH_VARGMAX_H   0x7200205b
+#define MASK_VARGMAX_H    0xfff0707f
+#define MATCH_VARGMAX_W   0xb200205b
+#define MASK_VARGMAX_W    0xfff0707f
+
+/* Masked forms (funct3=110): only the elements enabled in the vmask CSR (0x800) are
+   active. Inactive elements load as 0 and are not stored, read as 0 in the VALU
+   and are skipped by the reductions. vld.m vd, rs1 / vst.m vs2, rs1 carry the SEW. */
+#define MATCH_VADD_M_B    0x0000605b
+#define MASK_VADD_M_B     0xfe00707f
+#define MATCH_VADD_M_H    0x4000605b
+#define MASK_VADD_M_H     0xfe00707f
+#define MATCH_VADD_M_W    0x8000605b
+#define MASK_VADD_M_W     0xfe00707f
+#define MATCH_VSUB_M_B    0x0200605b
+#define MASK_VSUB_M_B     0xfe00707f
+#define MATCH_VSUB_M_H    0x4200605b
+#define MASK_VSUB_M_H     0xfe00707f
+#define MATCH_VSUB_M_W    0x8200605b
+#define MASK_VSUB_M_W     0xfe00707f
+#define MATCH_VMUL_M_B    0x0400605b
+#define MASK_VMUL_M_B     0xfe00707f
+#define MATCH_VMUL_M_H    0x4400605b
+#define MASK_VMUL_M_H     0xfe00707f
+#define MATCH_VMUL_M_W    0x8400605b
+#define MASK_VMUL_M_W     0xfe00707f
+#define MATCH_VMAC_M_B    0x0600605b
+#define MASK_VMAC_M_B     0xfe00707f
+#define MATCH_VMAC_M_H    0x4600605b
+#define MASK_VMAC_M_H     0xfe00707f
+#define MATCH_VMAC_M_W    0x8600605b
+#define MASK_VMAC_M_W     0xfe00707f
+#define MATCH_VLD_M_B     0x0800605b
+#define MASK_VLD_M_B      0xfff0707f
+#define MATCH_VLD_M_H     0x4800605b
+#define MASK_VLD_M_H      0xfff0707f
+#define MATCH_VLD_M_W     0x8800605b
+#define MASK_VLD_M_W      0xfff0707f
+#define MATCH_VST_M_B     0x0a00605b
+#define MASK_VST_M_B      0xfe007fff
+#define MATCH_VST_M_H     0x4a00605b
+#define MASK_VST_M_H      0xfe007fff
+#define MATCH_VST_M_W     0x8a00605b
+#define MASK_VST_M_W      0xfe007fff
+#define MATCH_VMACC_M_B   0x1400605b
+#define MASK_VMACC_M_B    0xfe007fff
+#define MATCH_VMACC_M_H   0x5400605b
+#define MASK_VMACC_M_H    0xfe007fff
+#define MATCH_VMACC_M_W   0x9400605b
+#define MASK_VMACC_M_W    0xfe007fff
+#define MATCH_VREDSUM_M_B 0x2c00605b
+#define MASK_VREDSUM_M_B  0xfff0707f
+#define MATCH_VREDSUM_M_H 0x6c00605b
+#define MASK_VREDSUM_M_H  0xfff0707f
+#define MATCH_VREDSUM_M_W 0xac00605b
+#define MASK_VREDSUM_M_W  0xfff0707f
+#define MATCH_VREDMAX_M_B 0x2e00605b
+#define MASK_VREDMAX_M_B  0xfff0707f
+#define MATCH_VREDMAX_M_H 0x6e00605b
+#define MASK_VREDMAX_M_H  0xfff0707f
+#define MATCH_VREDMAX_M_W 0xae00605b
+#define MASK_VREDMAX_M_W  0xfff0707f
+#define MATCH_VREDMIN_M_B 0x3000605b
+#define MASK_VREDMIN_M_B  0xfff0707f
+#define MATCH_VREDMIN_M_H 0x7000605b
+#define MASK_VREDMIN_M_H  0xfff0707f
+#define MATCH_VREDMIN_M_W 0xb000605b
+#define MASK_VREDMIN_M_W  0xfff0707f
+#define MATCH_VARGMAX_M_B 0x3200605b
+#define MASK_VARGMAX_M_B  0xfff0707f
+#define MATCH_VARGMAX_M_H 0x7200605b
+#define MASK_VARGMAX_M_H  0xfff0707f
+#define MATCH_VARGMAX_M_W 0xb200605b
+#define MASK_VARGMAX_M_W  0xfff0707f
+
+/* VMSETL rd, rs1 - vmask = first min(rs1, VLEN/SEW) elements, rd = that count;
+   funct3=111, funct7[4:0]=00000, [6:5]=SEW */
+#define MATCH_VMSETL_B    0x0000705b
+#define MASK_VMSETL_B     0xfff0707f
+#define MATCH_VMSETL_H    0x4000705b
+#define MASK_VMSETL_H     0xfff0707f
+#define MATCH_VMSETL_W    0x8000705b
+#define MASK_VMSETL_W     0xfff0707f
+
+/* VSETL rd, rs1, rs2 - vtype = rs2 (SEW: 0=8, 1=16, 2=32), vl = min(rs1, VLEN/SEW),
+   rd = vl; funct3=111, funct7=0000001. Every vector instruction works on the first vl
+   elements; the .v forms (funct7[6:5]=11) run at the SEW in vtype. */
+#define MATCH_VSETL       0x0200705b
+#define MASK_VSETL        0xfe00707f
+#define MATCH_VADD_V      0xc000205b
+#define MASK_VADD_V       0xfe00707f
+#define MATCH_VSUB_V      0xc200205b
+#define MASK_VSUB_V       0xfe00707f
+#define MATCH_VMUL_V      0xc400205b
+#define MASK_VMUL_V       0xfe00707f
+#define MATCH_VMAC_V      0xc600205b
+#define MASK_VMAC_V       0xfe00707f
+#define MATCH_VMACC_V     0xd400205b
+#define MASK_VMACC_V      0xfe007fff
+#define MATCH_VREDSUM_V   0xec00205b
+#define MASK_VREDSUM_V    0xfff0707f
+#define MATCH_VREDMAX_V   0xee00205b
+#define MASK_VREDMAX_V    0xfff0707f
+#define MATCH_VREDMIN_V   0xf000205b
+#define MASK_VREDMIN_V    0xfff0707f
+#define MATCH_VARGMAX_V   0xf200205b
+#define MASK_VARGMAX_V    0xfff0707f
+#define MATCH_VLD_M_V     0xc800605b
+#define MASK_VLD_M_V      0xfff0707f
+#define MATCH_VST_M_V     0xca00605b
+#define MASK_VST_M_V      0xfe007fff
+#define MATCH_VMSETL_V    0xc000705b
+#define MASK_VMSETL_V     0xfff0707f
+
+/* Hardware loop: lp.setup rs1, end -- the body up to and including the
+   instruction at end runs rs1 times */
+/* funct3=011, opcode=0x5B, I-type with rd=0, imm[11:0] = (end - pc) / 2 */
+#define MATCH_LP_SETUP    0x0000305b
+#define MASK_LP_SETUP     0x00007fff
+
 #endif /* RISCV_ENCODING_H */
 #ifdef DECLARE_INSN
 DECLARE_INSN(slli_rv32, MATCH_SLLI_RV32, MASK_SLLI_RV32)
@@ -490,6 +490,11 @@ print_insn_args (const char *oparg, insn_t l, bfd_vma pc, disassemble_info *info
 	  (*info->print_address_func) (info->target, info);
 	  break;
 
+	case 'h':
+	  info->target = (RV_X (l, 20, 12) << 1) + pc;
+	  (*info->print_address_func) (info->target, info);
+	  break;
+
 	case 'd':
 	  if ((l & MASK_AUIPC) == MATCH_AUIPC)
 	    pd->hi_addr[rd] = pc + EXTRACT_UTYPE_IMM (l);
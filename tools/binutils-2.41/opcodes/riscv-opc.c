@@ -362,6 +362,111 @@ const struct riscv_opcode riscv_opcodes[] =
 {"vmac.w",    0, INSN_CLASS_I, "d,s,t", MATCH_VMAC_W, MASK_VMAC_W, match_opcode, 0},
 {"vld",       0, INSN_CLASS_I, "d,s",   MATCH_VLD,    MASK_VLD,    match_opcode, 0},
 {"vst",       0, INSN_CLASS_I, "d,s,t", MATCH_VST,    MASK_VST,    match_opcode, 0},
+{"vld.pi",    0, INSN_CLASS_I, "d,s",   MATCH_VLD_PI, MASK_VLD_PI, match_opcode, 0},
+{"vst.pi",    0, INSN_CLASS_I, "t,s",   MATCH_VST_PI, MASK_VST_PI, match_opcode, 0},
+{"vld.pr",    0, INSN_CLASS_I, "d,s,t", MATCH_VLD_PR, MASK_VLD_PR, match_opcode, 0},
+{"vlds.b",    0, INSN_CLASS_I, "d,s,t", MATCH_VLDS_B, MASK_VLDS_B, match_opcode, 0},
+{"vlds.h",    0, INSN_CLASS_I, "d,s,t", MATCH_VLDS_H, MASK_VLDS_H, match_opcode, 0},
+{"vlds.w",    0, INSN_CLASS_I, "d,s,t", MATCH_VLDS_W, MASK_VLDS_W, match_opcode, 0},
+{"vldx.b",    0, INSN_CLASS_I, "d,s,t", MATCH_VLDX_B, MASK_VLDX_B, match_opcode, 0},
+{"vldx.h",    0, INSN_CLASS_I, "d,s,t", MATCH_VLDX_H, MASK_VLDX_H, match_opcode, 0},
+{"vldx.w",    0, INSN_CLASS_I, "d,s,t", MATCH_VLDX_W, MASK_VLDX_W, match_opcode, 0},
+{"vmacc.b",   0, INSN_CLASS_I, "s,t",   MATCH_VMACC_B, MASK_VMACC_B, match_opcode, 0},
+{"vmacc.h",   0, INSN_CLASS_I, "s,t",   MATCH_VMACC_H, MASK_VMACC_H, match_opcode, 0},
+{"vmacc.w",   0, INSN_CLASS_I, "s,t",   MATCH_VMACC_W, MASK_VMACC_W, match_opcode, 0},
+{"vredacc",   0, INSN_CLASS_I, "d",     MATCH_VREDACC, MASK_VREDACC, match_opcode, 0},
+{"vmov.s2v.b", 0, INSN_CLASS_I, "d,s,<", MATCH_VMOV_S2V_B, MASK_VMOV_S2V_B, match_opcode, 0},
+{"vmov.s2v.h", 0, INSN_CLASS_I, "d,s,<", MATCH_VMOV_S2V_H, MASK_VMOV_S2V_H, match_opcode, 0},
+{"vmov.s2v.w", 0, INSN_CLASS_I, "d,s,<", MATCH_VMOV_S2V_W, MASK_VMOV_S2V_W, match_opcode, 0},
+{"vmov.v2s.b", 0, INSN_CLASS_I, "d,s,<", MATCH_VMOV_V2S_B, MASK_VMOV_V2S_B, match_opcode, 0},
+{"vmov.v2s.h", 0, INSN_CLASS_I, "d,s,<", MATCH_VMOV_V2S_H, MASK_VMOV_V2S_H, match_opcode, 0},
+{"vmov.v2s.w", 0, INSN_CLASS_I, "d,s,<", MATCH_VMOV_V2S_W, MASK_VMOV_V2S_W, match_opcode, 0},
+{"vadd.vx.b", 0, INSN_CLASS_I, "d,s,t", MATCH_VADD_VX_B, MASK_VADD_VX_B, match_opcode, 0},
+{"vadd.vx.h", 0, INSN_CLASS_I, "d,s,t", MATCH_VADD_VX_H, MASK_VADD_VX_H, match_opcode, 0},
+{"vadd.vx.w", 0, INSN_CLASS_I, "d,s,t", MATCH_VADD_VX_W, MASK_VADD_VX_W, match_opcode, 0},
+{"vsub.vx.b", 0, INSN_CLASS_I, "d,s,t", MATCH_VSUB_VX_B, MASK_VSUB_VX_B, match_opcode, 0},
+{"vsub.vx.h", 0, INSN_CLASS_I, "d,s,t", MATCH_VSUB_VX_H, MASK_VSUB_VX_H, match_opcode, 0},
+{"vsub.vx.w", 0, INSN_CLASS_I, "d,s,t", MATCH_VSUB_VX_W, MASK_VSUB_VX_W, match_opcode, 0},
+{"vmul.vx.b", 0, INSN_CLASS_I, "d,s,t", MATCH_VMUL_VX_B, MASK_VMUL_VX_B, match_opcode, 0},
+{"vmul.vx.h", 0, INSN_CLASS_I, "d,s,t", MATCH_VMUL_VX_H, MASK_VMUL_VX_H, match_opcode, 0},
+{"vmul.vx.w", 0, INSN_CLASS_I, "d,s,t", MATCH_VMUL_VX_W, MASK_VMUL_VX_W, match_opcode, 0},
+{"vmac.vx.b", 0, INSN_CLASS_I, "d,s,t", MATCH_VMAC_VX_B, MASK_VMAC_VX_B, match_opcode, 0},
+{"vmac.vx.h", 0, INSN_CLASS_I, "d,s,t", MATCH_VMAC_VX_H, MASK_VMAC_VX_H, match_opcode, 0},
+{"vmac.vx.w", 0, INSN_CLASS_I, "d,s,t", MATCH_VMAC_VX_W, MASK_VMAC_VX_W, match_opcode, 0},
+{"vnclip.b",  0, INSN_CLASS_I, "d,s,t", MATCH_VNCLIP_B, MASK_VNCLIP_B, match_opcode, 0},
+{"vnclip.h",  0, INSN_CLASS_I, "d,s,t", MATCH_VNCLIP_H, MASK_VNCLIP_H, match_opcode, 0},
+{"vnclip.relu.b", 0, INSN_CLASS_I, "d,s,t", MATCH_VNCLIP_RELU_B, MASK_VNCLIP_RELU_B, match_opcode, 0},
+{"vnclip.relu.h", 0, INSN_CLASS_I, "d,s,t", MATCH_VNCLIP_RELU_H, MASK_VNCLIP_RELU_H, match_opcode, 0},
+{"vnclip.acc.b", 0, INSN_CLASS_I, "d,t", MATCH_VNCLIP_ACC_B, MASK_VNCLIP_ACC_B, match_opcode, 0},
+{"vnclip.acc.relu.b", 0, INSN_CLASS_I, "d,t", MATCH_VNCLIP_ACC_RELU_B, MASK_VNCLIP_ACC_RELU_B, match_opcode, 0},
+{"vredsum.b", 0, INSN_CLASS_I, "d,s",   MATCH_VREDSUM_B, MASK_VREDSUM_B, match_opcode, 0},
+{"vredsum.h", 0, INSN_CLASS_I, "d,s",   MATCH_VREDSUM_H, MASK_VREDSUM_H, match_opcode, 0},
+{"vredsum.w", 0, INSN_CLASS_I, "d,s",   MATCH_VREDSUM_W, MASK_VREDSUM_W, match_opcode, 0},
+{"vredmax.b", 0, INSN_CLASS_I, "d,s",   MATCH_VREDMAX_B, MASK_VREDMAX_B, match_opcode, 0},
+{"vredmax.h", 0, INSN_CLASS_I, "d,s",   MATCH_VREDMAX_H, MASK_VREDMAX_H, match_opcode, 0},
+{"vredmax.w", 0, INSN_CLASS_I, "d,s",   MATCH_VREDMAX_W, MASK_VREDMAX_W, match_opcode, 0},
+{"vredmin.b", 0, INSN_CLASS_I, "d,s",   MATCH_VREDMIN_B, MASK_VREDMIN_B, match_opcode, 0},
+{"vredmin.h", 0, INSN_CLASS_I, "d,s",   MATCH_VREDMIN_H, MASK_VREDMIN_H, match_opcode, 0},
+{"vredmin.w", 0, INSN_CLASS_I, "d,s",   MATCH_VREDMIN_W, MASK_VREDMIN_W, match_opcode, 0},
+{"vargmax.b", 0, INSN_CLASS_I, "d,s",   MATCH_VARGMAX_B, MASK_VARGMAX_B, match_opcode, 0},
+{"vargmax.h", 0, INSN_CLASS_I, "d,s",   MATCH_VARGMAX_H, MASK_VARGMAX_H, match_opcode, 0},
+{"vargmax.w", 0, INSN_CLASS_I, "d,s",   MATCH_VARGMAX_W, MASK_VARGMAX_W, match_opcode, 0},
+
+/* Masked forms (vmask CSR) and VMSETL, the mask of the next strip */
+{"vadd.m.b",   0, INSN_CLASS_I, "d,s,t", MATCH_VADD_M_B, MASK_VADD_M_B, match_opcode, 0},
+{"vadd.m.h",   0, INSN_CLASS_I, "d,s,t", MATCH_VADD_M_H, MASK_VADD_M_H, match_opcode, 0},
+{"vadd.m.w",   0, INSN_CLASS_I, "d,s,t", MATCH_VADD_M_W, MASK_VADD_M_W, match_opcode, 0},
+{"vsub.m.b",   0, INSN_CLASS_I, "d,s,t", MATCH_VSUB_M_B, MASK_VSUB_M_B, match_opcode, 0},
+{"vsub.m.h",   0, INSN_CLASS_I, "d,s,t", MATCH_VSUB_M_H, MASK_VSUB_M_H, match_opcode, 0},
+{"vsub.m.w",   0, INSN_CLASS_I, "d,s,t", MATCH_VSUB_M_W, MASK_VSUB_M_W, match_opcode, 0},
+{"vmul.m.b",   0, INSN_CLASS_I, "d,s,t", MATCH_VMUL_M_B, MASK_VMUL_M_B, match_opcode, 0},
+{"vmul.m.h",   0, INSN_CLASS_I, "d,s,t", MATCH_VMUL_M_H, MASK_VMUL_M_H, match_opcode, 0},
+{"vmul.m.w",   0, INSN_CLASS_I, "d,s,t", MATCH_VMUL_M_W, MASK_VMUL_M_W, match_opcode, 0},
+{"vmac.m.b",   0, INSN_CLASS_I, "d,s,t", MATCH_VMAC_M_B, MASK_VMAC_M_B, match_opcode, 0},
+{"vmac.m.h",   0, INSN_CLASS_I, "d,s,t", MATCH_VMAC_M_H, MASK_VMAC_M_H, match_opcode, 0},
+{"vmac.m.w",   0, INSN_CLASS_I, "d,s,t", MATCH_VMAC_M_W, MASK_VMAC_M_W, match_opcode, 0},
+{"vld.m.b",    0, INSN_CLASS_I, "d,s",   MATCH_VLD_M_B, MASK_VLD_M_B, match_opcode, 0},
+{"vld.m.h",    0, INSN_CLASS_I, "d,s",   MATCH_VLD_M_H, MASK_VLD_M_H, match_opcode, 0},
+{"vld.m.w",    0, INSN_CLASS_I, "d,s",   MATCH_VLD_M_W, MASK_VLD_M_W, match_opcode, 0},
+{"vst.m.b",    0, INSN_CLASS_I, "t,s",   MATCH_VST_M_B, MASK_VST_M_B, match_opcode, 0},
+{"vst.m.h",    0, INSN_CLASS_I, "t,s",   MATCH_VST_M_H, MASK_VST_M_H, match_opcode, 0},
+{"vst.m.w",    0, INSN_CLASS_I, "t,s",   MATCH_VST_M_W, MASK_VST_M_W, match_opcode, 0},
+{"vmacc.m.b",  0, INSN_CLASS_I, "s,t",   MATCH_VMACC_M_B, MASK_VMACC_M_B, match_opcode, 0},
+{"vmacc.m.h",  0, INSN_CLASS_I, "s,t",   MATCH_VMACC_M_H, MASK_VMACC_M_H, match_opcode, 0},
+{"vmacc.m.w",  0, INSN_CLASS_I, "s,t",   MATCH_VMACC_M_W, MASK_VMACC_M_W, match_opcode, 0},
+{"vredsum.m.b", 0, INSN_CLASS_I, "d,s",   MATCH_VREDSUM_M_B, MASK_VREDSUM_M_B, match_opcode, 0},
+{"vredsum.m.h", 0, INSN_CLASS_I, "d,s",   MATCH_VREDSUM_M_H, MASK_VREDSUM_M_H, match_opcode, 0},
+{"vredsum.m.w", 0, INSN_CLASS_I, "d,s",   MATCH_VREDSUM_M_W, MASK_VREDSUM_M_W, match_opcode, 0},
+{"vredmax.m.b", 0, INSN_CLASS_I, "d,s",   MATCH_VREDMAX_M_B, MASK_VREDMAX_M_B, match_opcode, 0},
+{"vredmax.m.h", 0, INSN_CLASS_I, "d,s",   MATCH_VREDMAX_M_H, MASK_VREDMAX_M_H, match_opcode, 0},
+{"vredmax.m.w", 0, INSN_CLASS_I, "d,s",   MATCH_VREDMAX_M_W, MASK_VREDMAX_M_W, match_opcode, 0},
+{"vredmin.m.b", 0, INSN_CLASS_I, "d,s",   MATCH_VREDMIN_M_B, MASK_VREDMIN_M_B, match_opcode, 0},
+{"vredmin.m.h", 0, INSN_CLASS_I, "d,s",   MATCH_VREDMIN_M_H, MASK_VREDMIN_M_H, match_opcode, 0},
+{"vredmin.m.w", 0, INSN_CLASS_I, "d,s",   MATCH_VREDMIN_M_W, MASK_VREDMIN_M_W, match_opcode, 0},
+{"vargmax.m.b", 0, INSN_CLASS_I, "d,s",   MATCH_VARGMAX_M_B, MASK_VARGMAX_M_B, match_opcode, 0},
+{"vargmax.m.h", 0, INSN_CLASS_I, "d,s",   MATCH_VARGMAX_M_H, MASK_VARGMAX_M_H, match_opcode, 0},
+{"vargmax.m.w", 0, INSN_CLASS_I, "d,s",   MATCH_VARGMAX_M_W, MASK_VARGMAX_M_W, match_opcode, 0},
+{"vmsetl.b",   0, INSN_CLASS_I, "d,s",   MATCH_VMSETL_B, MASK_VMSETL_B, match_opcode, 0},
+{"vmsetl.h",   0, INSN_CLASS_I, "d,s",   MATCH_VMSETL_H, MASK_VMSETL_H, match_opcode, 0},
+{"vmsetl.w",   0, INSN_CLASS_I, "d,s",   MATCH_VMSETL_W, MASK_VMSETL_W, match_opcode, 0},
+
+/* VSETL, the SEW and length of the next strip, and the forms at the SEW in vtype */
+{"vsetl",      0, INSN_CLASS_I, "d,s,t", MATCH_VSETL, MASK_VSETL, match_opcode, 0},
+{"vadd.v",     0, INSN_CLASS_I, "d,s,t", MATCH_VADD_V, MASK_VADD_V, match_opcode, 0},
+{"vsub.v",     0, INSN_CLASS_I, "d,s,t", MATCH_VSUB_V, MASK_VSUB_V, match_opcode, 0},
+{"vmul.v",     0, INSN_CLASS_I, "d,s,t", MATCH_VMUL_V, MASK_VMUL_V, match_opcode, 0},
+{"vmac.v",     0, INSN_CLASS_I, "d,s,t", MATCH_VMAC_V, MASK_VMAC_V, match_opcode, 0},
+{"vmacc.v",    0, INSN_CLASS_I, "s,t",   MATCH_VMACC_V, MASK_VMACC_V, match_opcode, 0},
+{"vredsum.v",  0, INSN_CLASS_I, "d,s",   MATCH_VREDSUM_V, MASK_VREDSUM_V, match_opcode, 0},
+{"vredmax.v",  0, INSN_CLASS_I, "d,s",   MATCH_VREDMAX_V, MASK_VREDMAX_V, match_opcode, 0},
+{"vredmin.v",  0, INSN_CLASS_I, "d,s",   MATCH_VREDMIN_V, MASK_VREDMIN_V, match_opcode, 0},
+{"vargmax.v",  0, INSN_CLASS_I, "d,s",   MATCH_VARGMAX_V, MASK_VARGMAX_V, match_opcode, 0},
+{"vld.m.v",    0, INSN_CLASS_I, "d,s",   MATCH_VLD_M_V, MASK_VLD_M_V, match_opcode, 0},
+{"vst.m.v",    0, INSN_CLASS_I, "t,s",   MATCH_VST_M_V, MASK_VST_M_V, match_opcode, 0},
+{"vmsetl.v",   0, INSN_CLASS_I, "d,s",   MATCH_VMSETL_V, MASK_VMSETL_V, match_opcode, 0},
+
+/* Hardware loop: count in rs1, the last body instruction as a halfword offset */
+{"lp.setup",  0, INSN_CLASS_I, "s,h",   MATCH_LP_SETUP, MASK_LP_SETUP, match_opcode, 0},
 
 /* Basic RVI instructions and aliases.  */
 {"unimp",       0, INSN_CLASS_C, "",          0, 0xffffU, match_opcode, INSN_ALIAS },
@@ -0,0 +1,448 @@
+// Offline replay of a dmem transaction trace (sim/mem_trace.h)
+//
+// Runs the requests recorded by top.cc (MEM_TRACE=1) through a configurable
+// memory system model instead of the RTL, so cache/DRAM/prefetcher ideas can be
+// compared on our kernels in seconds.
+//
+//   memreplay [options] firmware32_mnist_sew_mem_trace.bin
+//
+//   -c SIZE,LINE,WAYS   cache in front of memory (bytes, 0 = no cache)  [0]
+//   -h CYCLES           cache hit latency                               [1]
+//   -m CYCLES           flat memory latency (used when -d is not given) [1]
+//   -d CAS,RCD,RP,BANKS,ROW
+//                       DRAM with one open row per bank instead of -m
+//   -p none|next|stride prefetcher feeding the cache                    [none]
+//   -n DEGREE           lines fetched per prefetch trigger              [2]
+//   -s                  also send scalar/vector accesses to the TCM through
+//                       the hierarchy (default: TCM port is a fixed 1 cycle)
+//
+// Each model answers with a latency; the sum over all requests is reported as
+// memory cycles, next to the cycle span of the original run.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../sim/mem_trace.h"
+
+// ---------------------------------------------------------------------------
+// Backing memory models
+// ---------------------------------------------------------------------------
+
+class Memory {
+public:
+  virtual ~Memory() {}
+  // latency of a line-sized access starting at addr
+  virtual uint32_t access(uint32_t addr, bool write) = 0;
+  virtual void report(FILE* out) const = 0;
+};
+
+class FlatMemory : public Memory {
+public:
+  explicit FlatMemory(uint32_t latency) : latency_(latency) {}
+  uint32_t access(uint32_t, bool) override {
+    accesses_++;
+    return latency_;
+  }
+  void report(FILE* out) const override {
+    fprintf(out, "memory:   flat, %u cycles, %llu accesses\n", latency_,
+            (unsigned long long)accesses_);
+  }
+private:
+  uint32_t latency_;
+  uint64_t accesses_ = 0;
+};
+
+// Open-page DRAM: row hit = CAS, closed bank = RCD+CAS, conflict = RP+RCD+CAS
+class Dram : public Memory {
+public:
+  Dram(uint32_t cas, uint32_t rcd, uint32_t rp, uint32_t banks, uint32_t row_bytes)
+      : cas_(cas), rcd_(rcd), rp_(rp), banks_(banks), row_bytes_(row_bytes),
+        open_row_(banks, UINT32_MAX) {}
+  uint32_t access(uint32_t addr, bool) override {
+    uint32_t row = addr / row_bytes_;
+    uint32_t bank = row % banks_;
+    uint32_t& open = open_row_[bank];
+    if (open == row) {
+      row_hits_++;
+      return cas_;
+    }
+    uint32_t lat = (open == UINT32_MAX) ? rcd_ + cas_ : rp_ + rcd_ + cas_;
+    if (open == UINT32_MAX) {
+      row_empty_++;
+    } else {
+      row_conflicts_++;
+    }
+    open = row;
+    return lat;
+  }
+  void report(FILE* out) const override {
+    uint64_t total = row_hits_ + row_empty_ + row_conflicts_;
+    fprintf(out, "memory:   DRAM CAS=%u RCD=%u RP=%u, %u banks, %u B rows\n",
+            cas_, rcd_, rp_, banks_, row_bytes_);
+    fprintf(out, "          %llu accesses, row hit %.1f%%, empty %.1f%%, conflict %.1f%%\n",
+            (unsigned long long)total,
+            total ? 100.0 * row_hits_ / total : 0.0,
+            total ? 100.0 * row_empty_ / total : 0.0,
+            total ? 100.0 * row_conflicts_ / total : 0.0);
+  }
+private:
+  uint32_t cas_, rcd_, rp_, banks_, row_bytes_;
+  std::vector<uint32_t> open_row_;
+  uint64_t row_hits_ = 0, row_empty_ = 0, row_conflicts_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Prefetchers (produce line addresses for the cache to fill)
+// ---------------------------------------------------------------------------
+
+class Prefetcher {
+public:
+  virtual ~Prefetcher() {}
+  // called on every demand access, appends candidate line addresses
+  virtual void train(const MemTraceRecord& rec, uint32_t line_addr, bool hit,
+                     std::vector<uint32_t>& out) = 0;
+  virtual const char* name() const = 0;
+};
+
+class NextLinePrefetcher : public Prefetcher {
+public:
+  NextLinePrefetcher(uint32_t line, uint32_t degree) : line_(line), degree_(degree) {}
+  void train(const MemTraceRecord&, uint32_t line_addr, bool hit,
+             std::vector<uint32_t>& out) override {
+    if (hit) return;
+    for (uint32_t i = 1; i <= degree_; i++) out.push_back(line_addr + i * line_);
+  }
+  const char* name() const override { return "next-line"; }
+private:
+  uint32_t line_, degree_;
+};
+
+// Without PCs in the trace, streams are separated by source (scalar, vector,
+// DMA) and, for the vector unit, by the two alternating VLD streams of the
+// MNIST loop (tracked as a small table of last addresses).
+class StridePrefetcher : public Prefetcher {
+public:
+  StridePrefetcher(uint32_t line, uint32_t degree) : line_(line), degree_(degree) {}
+  void train(const MemTraceRecord& rec, uint32_t line_addr, bool,
+             std::vector<uint32_t>& out) override {
+    if (rec.flags & MEM_TRACE_WRITE) return;
+    // closest entry of the same source wins
+    int src = (rec.flags & MEM_TRACE_DMA) ? 2 : (rec.flags & MEM_TRACE_VECTOR) ? 1 : 0;
+    Entry* best = nullptr;
+    uint32_t best_dist = UINT32_MAX;
+    for (Entry& e : table_) {
+      if (!e.valid || e.src != src) continue;
+      uint32_t d = (line_addr > e.last) ? line_addr - e.last : e.last - line_addr;
+      if (d < best_dist) {
+        best_dist = d;
+        best = &e;
+      }
+    }
+    if (!best || best_dist > kMaxStride) {
+      Entry& e = table_[victim_++ % kEntries];
+      e = Entry{true, src, line_addr, 0, 0};
+      return;
+    }
+    if (line_addr == best->last) return;  // same line, nothing learned
+    int32_t stride = (int32_t)(line_addr - best->last);
+    best->conf = (stride == best->stride) ? best->conf + 1 : 0;
+    best->stride = stride;
+    best->last = line_addr;
+    if (best->conf >= 1) {
+      for (uint32_t i = 1; i <= degree_; i++) out.push_back(line_addr + i * stride);
+    }
+  }
+  const char* name() const override { return "stride"; }
+private:
+  static const int kEntries = 8;
+  static const uint32_t kMaxStride = 4096;
+  struct Entry {
+    bool valid;
+    int src;
+    uint32_t last;
+    int32_t stride;
+    int conf;
+  };
+  Entry table_[kEntries] = {};
+  uint32_t victim_ = 0;
+  uint32_t line_, degree_;
+};
+
+// ---------------------------------------------------------------------------
+// Set-associative write-back, write-allocate cache with LRU
+// ---------------------------------------------------------------------------
+
+class Cache {
+public:
+  Cache(uint32_t size, uint32_t line, uint32_t ways, uint32_t hit_latency,
+        Memory* next, Prefetcher* pf)
+      : line_(line), ways_(ways), sets_(size / line / ways), hit_latency_(hit_latency),
+        next_(next), pf_(pf), lines_((size_t)sets_ * ways) {}
+
+  uint32_t access(const MemTraceRecord& rec) {
+    bool write = rec.flags & MEM_TRACE_WRITE;
+    uint32_t line_addr = rec.addr & ~(line_ - 1);
+    uint32_t lat = hit_latency_;
+    Line* l = lookup(line_addr);
+    bool hit = (l != nullptr);
+    if (hit) {
+      hits_++;
+      if (l->prefetched) {
+        pf_useful_++;
+        l->prefetched = false;
+      }
+    } else {
+      misses_++;
+      lat += fill(line_addr, false, &l);
+    }
+    l->lru = ++tick_;
+    if (write) l->dirty = true;
+
+    if (pf_) {
+      pf_candidates_.clear();
+      pf_->train(rec, line_addr, hit, pf_candidates_);
+      for (uint32_t a : pf_candidates_) {
+        if (lookup(a)) continue;
+        pf_issued_++;
+        Line* p;
+        fill(a, true, &p);  // off the critical path
+      }
+    }
+    return lat;
+  }
+
+  void report(FILE* out) const {
+    uint64_t total = hits_ + misses_;
+    fprintf(out, "cache:    %u B, %u B lines, %u ways, hit latency %u\n",
+            sets_ * ways_ * line_, line_, ways_, hit_latency_);
+    fprintf(out, "          %llu accesses, hit rate %.2f%%, %llu writebacks\n",
+            (unsigned long long)total, total ? 100.0 * hits_ / total : 0.0,
+            (unsigned long long)writebacks_);
+    if (pf_) {
+      fprintf(out, "prefetch: %s, %llu issued, %llu useful (%.1f%%)\n", pf_->name(),
+              (unsigned long long)pf_issued_, (unsigned long long)pf_useful_,
+              pf_issued_ ? 100.0 * pf_useful_ / pf_issued_ : 0.0);
+    }
+  }
+
+private:
+  struct Line {
+    bool valid = false;
+    bool dirty = false;
+    bool prefetched = false;
+    uint32_t tag = 0;
+    uint64_t lru = 0;
+  };
+
+  Line* lookup(uint32_t line_addr) {
+    uint32_t set = (line_addr / line_) % sets_;
+    Line* base = &lines_[(size_t)set * ways_];
+    for (uint32_t w = 0; w < ways_; w++) {
+      if (base[w].valid && base[w].tag == line_addr) return &base[w];
+    }
+    return nullptr;
+  }
+
+  // returns the memory latency of the fill (plus writeback of the victim)
+  uint32_t fill(uint32_t line_addr, bool prefetch, Line** out) {
+    uint32_t set = (line_addr / line_) % sets_;
+    Line* base = &lines_[(size_t)set * ways_];
+    Line* victim = &base[0];
+    for (uint32_t w = 0; w < ways_; w++) {
+      if (!base[w].valid) {
+        victim = &base[w];
+        break;
+      }
+      if (base[w].lru < victim->lru) victim = &base[w];
+    }
+    uint32_t lat = 0;
+    if (victim->valid && victim->dirty) {
+      writebacks_++;
+      lat += next_->access(victim->tag, true);
+    }
+    lat += next_->access(line_addr, false);
+    victim->valid = true;
+    victim->dirty = false;
+    victim->prefetched = prefetch;
+    victim->tag = line_addr;
+    victim->lru = tick_;
+    *out = victim;
+    return lat;
+  }
+
+  uint32_t line_, ways_, sets_, hit_latency_;
+  Memory* next_;
+  Prefetcher* pf_;
+  std::vector<Line> lines_;
+  std::vector<uint32_t> pf_candidates_;
+  uint64_t tick_ = 0;
+  uint64_t hits_ = 0, misses_ = 0, writebacks_ = 0;
+  uint64_t pf_issued_ = 0, pf_useful_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+struct Stats {
+  uint64_t requests = 0, reads = 0, writes = 0;
+  uint64_t scalar = 0, vector = 0, dma = 0, tcm = 0;
+  uint64_t mem_cycles = 0;
+  uint64_t first_cycle = 0, last_cycle = 0;
+};
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s [-c SIZE,LINE,WAYS] [-h HIT] [-m LAT] [-d CAS,RCD,RP,BANKS,ROW]\n"
+          "          [-p none|next|stride] [-n DEGREE] [-s] trace.bin\n", argv0);
+}
+
+int main(int argc, char** argv) {
+  uint32_t cache_size = 0, cache_line = 32, cache_ways = 4, hit_latency = 1;
+  uint32_t mem_latency = 1;
+  bool use_dram = false;
+  uint32_t cas = 14, rcd = 14, rp = 14, banks = 8, row_bytes = 2048;
+  std::string pf_kind = "none";
+  uint32_t pf_degree = 2;
+  bool tcm_through_hierarchy = false;
+  const char* path = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    bool has_val = (i + 1 < argc);
+    if (!strcmp(a, "-c") && has_val) {
+      if (sscanf(argv[++i], "%u,%u,%u", &cache_size, &cache_line, &cache_ways) < 1) {
+        usage(argv[0]);
+        return 1;
+      }
+    } else if (!strcmp(a, "-h") && has_val) {
+      hit_latency = (uint32_t)atoi(argv[++i]);
+    } else if (!strcmp(a, "-m") && has_val) {
+      mem_latency = (uint32_t)atoi(argv[++i]);
+    } else if (!strcmp(a, "-d") && has_val) {
+      use_dram = true;
+      if (sscanf(argv[++i], "%u,%u,%u,%u,%u", &cas, &rcd, &rp, &banks, &row_bytes) < 3) {
+        usage(argv[0]);
+        return 1;
+      }
+    } else if (!strcmp(a, "-p") && has_val) {
+      pf_kind = argv[++i];
+    } else if (!strcmp(a, "-n") && has_val) {
+      pf_degree = (uint32_t)atoi(argv[++i]);
+    } else if (!strcmp(a, "-s")) {
+      tcm_through_hierarchy = true;
+    } else if (a[0] != '-' && !path) {
+      path = a;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (!path) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (cache_size && (cache_line == 0 || cache_ways == 0 || (cache_line & (cache_line - 1)) ||
+                     cache_size % (cache_line * cache_ways))) {
+    fprintf(stderr, "Invalid cache geometry %u,%u,%u\n", cache_size, cache_line, cache_ways);
+    return 1;
+  }
+  if (use_dram && (banks == 0 || row_bytes == 0)) {
+    fprintf(stderr, "Invalid DRAM geometry\n");
+    return 1;
+  }
+
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "Failed to open trace file: %s\n", path);
+    return 1;
+  }
+  MemTraceHeader hdr;
+  if (fread(&hdr, sizeof(hdr), 1, f) != 1 || hdr.magic != MEM_TRACE_MAGIC ||
+      hdr.version != MEM_TRACE_VERSION || hdr.record_size != sizeof(MemTraceRecord)) {
+    fprintf(stderr, "%s: not a version %u memory trace\n", path, MEM_TRACE_VERSION);
+    fclose(f);
+    return 1;
+  }
+
+  // build the hierarchy
+  std::unique_ptr<Memory> mem;
+  if (use_dram) {
+    mem.reset(new Dram(cas, rcd, rp, banks, row_bytes));
+  } else {
+    mem.reset(new FlatMemory(mem_latency));
+  }
+  uint32_t pf_line = cache_size ? cache_line : 8;
+  std::unique_ptr<Prefetcher> pf;
+  if (pf_kind == "next") {
+    pf.reset(new NextLinePrefetcher(pf_line, pf_degree));
+  } else if (pf_kind == "stride") {
+    pf.reset(new StridePrefetcher(pf_line, pf_degree));
+  } else if (pf_kind != "none") {
+    fprintf(stderr, "Unknown prefetcher: %s\n", pf_kind.c_str());
+    fclose(f);
+    return 1;
+  }
+  if (pf && !cache_size) {
+    fprintf(stderr, "A prefetcher needs a cache (-c)\n");
+    fclose(f);
+    return 1;
+  }
+  std::unique_ptr<Cache> cache;
+  if (cache_size) {
+    cache.reset(new Cache(cache_size, cache_line, cache_ways, hit_latency, mem.get(), pf.get()));
+  }
+
+  // replay
+  Stats st;
+  std::vector<MemTraceRecord> buf(1 << 16);
+  auto t0 = std::chrono::steady_clock::now();
+  size_t n;
+  while ((n = fread(buf.data(), sizeof(MemTraceRecord), buf.size(), f)) > 0) {
+    for (size_t i = 0; i < n; i++) {
+      const MemTraceRecord& rec = buf[i];
+      if (st.requests == 0) st.first_cycle = rec.cycle;
+      st.last_cycle = rec.cycle;
+      st.requests++;
+      if (rec.flags & MEM_TRACE_WRITE) st.writes++; else st.reads++;
+      if (rec.flags & MEM_TRACE_TCM) st.tcm++;
+      else if (rec.flags & MEM_TRACE_DMA) st.dma++;
+      else if (rec.flags & MEM_TRACE_VECTOR) st.vector++;
+      else st.scalar++;
+
+      // MMIO (UART, DMA registers) never reaches the memory system
+      if ((rec.addr >> 28) == 0x1) {
+        st.mem_cycles += 1;
+        continue;
+      }
+      if ((rec.flags & MEM_TRACE_TCM) && !tcm_through_hierarchy) {
+        st.mem_cycles += 1;
+        continue;
+      }
+      st.mem_cycles += cache ? cache->access(rec) : mem->access(rec.addr, rec.flags & MEM_TRACE_WRITE);
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  fclose(f);
+
+  double secs = std::chrono::duration<double>(t1 - t0).count();
+  printf("trace:    %s\n", path);
+  printf("requests: %llu (%llu reads, %llu writes)\n", (unsigned long long)st.requests,
+         (unsigned long long)st.reads, (unsigned long long)st.writes);
+  printf("sources:  %llu scalar, %llu vector, %llu DMA, %llu TCM port\n",
+         (unsigned long long)st.scalar, (unsigned long long)st.vector,
+         (unsigned long long)st.dma, (unsigned long long)st.tcm);
+  printf("span:     %llu cycles in the RTL run\n",
+         (unsigned long long)(st.requests ? st.last_cycle - st.first_cycle + 1 : 0));
+  if (cache) cache->report(stdout);
+  mem->report(stdout);
+  printf("result:   %llu memory cycles, %.2f per request\n", (unsigned long long)st.mem_cycles,
+         st.requests ? (double)st.mem_cycles / st.requests : 0.0);
+  printf("replay:   %.3f s, %.1f M requests/s\n", secs,
+         secs > 0 ? st.requests / secs / 1e6 : 0.0);
+  return 0;
+}
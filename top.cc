@@ -23,6 +23,7 @@
 #include <pthread.h>
 #include "Vtop.h"
 #include "Vtop___024root.h"
+#include "sim/mem_trace.h"
 
 // PTY support (optional, only needed for use_local_pty = 0)
 #ifdef ENABLE_PTY
@@ -246,6 +247,12 @@ int main(int argc, char** argv) {
   snprintf(trace_path, sizeof(trace_path), "%s_trace.txt", test_name);
   snprintf(instruction_trace_path, sizeof(instruction_trace_path), "%s_instruction_trace.txt", test_name);
 
+  // Binary dmem transaction trace for tools/memreplay (MEM_TRACE=1)
+  const char* mem_trace_env = getenv("MEM_TRACE");
+  bool mem_trace_on = mem_trace_env && strcmp(mem_trace_env, "0") != 0;
+  char mem_trace_path[256];
+  snprintf(mem_trace_path, sizeof(mem_trace_path), "%s_mem_trace.bin", test_name);
+
   // Initialize imem with ebreak instructions first
   init();
 
@@ -294,6 +301,20 @@ int main(int argc, char** argv) {
   }
   fprintf(trace_file, "# Cycle req_addr   req_wdata  req_wmask req_write req_valid resp_valid resp_rdata\n");
 
+  FILE* mem_trace_file = nullptr;
+  uint64_t mem_trace_count = 0;
+  if (mem_trace_on) {
+    mem_trace_file = fopen(mem_trace_path, "wb");
+    if (!mem_trace_file) {
+      fprintf(stderr, "Failed to open memory trace file: %s\n", mem_trace_path);
+      return 1;
+    }
+    static char mem_trace_buf[1 << 20];
+    setvbuf(mem_trace_file, mem_trace_buf, _IOFBF, sizeof(mem_trace_buf));
+    MemTraceHeader hdr = {MEM_TRACE_MAGIC, MEM_TRACE_VERSION, sizeof(MemTraceRecord), 0};
+    fwrite(&hdr, sizeof(hdr), 1, mem_trace_file);
+  }
+
   UARTBitDriver uart_driver;
 
   dut->clk = 0;
@@ -337,6 +358,7 @@ int main(int argc, char** argv) {
 
   int time_counter = 3;
   int cycle = 0;
+  uint64_t retired = 0;
   while (!Verilated::gotFinish() && !interrupted && !ebreak_hit) {
     // Tick UART driver
     uart_driver.tick();
@@ -390,6 +412,43 @@ int main(int argc, char** argv) {
 
     dut->clk = 0;
     dut->eval();
+
+    // Instruction leaving WB at the coming rising edge
+    if (dut->rootp->top__DOT__cpu_retire) {
+      retired++;
+    }
+
+    // Requests accepted at the coming rising edge
+    if (mem_trace_file) {
+      auto* r = dut->rootp;
+      MemTraceRecord rec = {};
+      rec.cycle = (uint64_t)cycle;
+      if (r->top__DOT__dmem_req_valid && r->top__DOT__dmem_req_ready) {
+        uint8_t wmask = r->top__DOT__dmem_req_wmask;
+        rec.addr = r->top__DOT__dmem_req_addr;
+        rec.flags = (r->top__DOT__dmem_req_write ? MEM_TRACE_WRITE : 0) |
+                    (r->top__DOT__dmem_req_vector ? MEM_TRACE_VECTOR : 0);
+        rec.size = r->top__DOT__dmem_req_write ? (uint8_t)__builtin_popcount(wmask) : 4;
+        fwrite(&rec, sizeof(rec), 1, mem_trace_file);
+        mem_trace_count++;
+      }
+      if (r->top__DOT__dma_grant) {
+        rec.addr = r->top__DOT__dma_m_addr;
+        rec.flags = MEM_TRACE_DMA | (r->top__DOT__dma_m_write ? MEM_TRACE_WRITE : 0);
+        rec.size = 4;
+        fwrite(&rec, sizeof(rec), 1, mem_trace_file);
+        mem_trace_count++;
+      }
+      if (r->top__DOT__vtcm_valid) {
+        rec.addr = r->top__DOT__vtcm_addr;
+        rec.flags = MEM_TRACE_TCM | MEM_TRACE_VECTOR | (r->top__DOT__vtcm_write ? MEM_TRACE_WRITE : 0);
+        // one VLEN-bit beat: QData at VLEN=64, VlWide<VLEN/32> above
+        rec.size = (uint8_t)sizeof(r->top__DOT__vtcm_wdata);
+        fwrite(&rec, sizeof(rec), 1, mem_trace_file);
+        mem_trace_count++;
+      }
+    }
+
     dut->clk = 1;
     dut->eval();
 #if VM_TRACE
@@ -437,6 +496,10 @@ int main(int argc, char** argv) {
   // Print simulation statistics
   printf("\n=== Simulation Statistics ===\n");
   printf("Total cycles: %d\n", cycle);
+  printf("Instructions retired: %llu\n", (unsigned long long)retired);
+  if (retired > 0) {
+    printf("CPI: %.3f\n", (double)cycle / (double)retired);
+  }
   printf("==============================\n");
 
 #if VM_TRACE
@@ -456,6 +519,11 @@ int main(int argc, char** argv) {
 
   fclose(trace_file);
   printf("Trace written to %s\n", trace_path);
+  if (mem_trace_file) {
+    fclose(mem_trace_file);
+    printf("Memory trace written to %s (%llu requests)\n", mem_trace_path,
+           (unsigned long long)mem_trace_count);
+  }
 
   // Only close PTY if it was opened
 #ifdef ENABLE_PTY
@@ -1,4 +1,16 @@
-module top (
+module top #(
+  parameter DMEM_LATENCY = 1,  // SRAM data port latency, raise it to study the memory system
+  parameter VPREFETCH_EN = 1,
+  parameter WBUF_EN = 1,
+  parameter IPREFETCH_EN = 1,  // instruction prefetch buffer (FSM core only)
+  parameter VDECOUPLE_EN = 1,  // vector issue queue, scalar code runs ahead (FSM core only)
+  parameter BPRED_EN = 1,      // branch predictor (pipelined core only)
+  parameter ALU_ADDER = 0,     // adder_32 ARCH: 0 ripple, 1 CLA, 2 Kogge-Stone, 3 behavioral
+  parameter PC_ADDER = 0,
+  parameter VALU_MULS = 4,     // VALU lane multipliers: 4, 8 or 16
+  parameter VLEN = 64,         // vector register width: 64, 128 or 256
+  parameter PIPELINE = 0       // 0 = multi-cycle FSM core (ucrv32), 1 = five-stage pipeline (ucrv32_pipe)
+) (
   input clk,
   input resetn,
 
@@ -42,6 +54,44 @@ module top (
   wire [31:0] imem_rdata;
 
   wire cpu_break;
+  wire cpu_retire;        // one instruction retired this cycle (CPI in top.cc)
+  wire dmem_req_vector;   // current dmem request comes from the vector unit
+
+  wire [31:0] vtcm_addr;
+  wire [VLEN-1:0] vtcm_wdata;
+  wire        vtcm_write;
+  wire        vtcm_valid;
+  wire [VLEN-1:0] vtcm_rdata;
+
+  // vector scratchpad window, 64 KB at 0x2000_0000
+  wire dmem_req_is_tcm = (dmem_req_addr[31:16] == 16'h2000);
+  // DMA registers at 0x1000_1000
+  wire dmem_req_is_dma = (dmem_req_addr[31:12] == 20'h10001);
+  // CLINT (mtime/mtimecmp/msip) at 0x0200_0000
+  wire dmem_req_is_clint = (dmem_req_addr[31:16] == 16'h0200);
+
+  wire [63:0] clint_mtime;
+  wire        clint_timer_irq;
+  wire        clint_soft_irq;
+
+  // DMA master port
+  wire [31:0] dma_m_addr;
+  wire [31:0] dma_m_wdata;
+  wire        dma_m_write;
+  wire        dma_m_valid;
+  wire        dma_m_resp_valid;
+  wire [31:0] dma_m_resp_rdata;
+
+  // the DMA gets the SRAM/TCM data ports in cycles the core leaves idle
+  wire dma_grant = dma_m_valid && !dmem_req_valid;
+  wire dma_m_is_tcm = (dma_m_addr[31:16] == 16'h2000);
+
+  wire [31:0] mem_addr  = dma_grant ? dma_m_addr : dmem_req_addr;
+  wire [31:0] mem_wdata = dma_grant ? dma_m_wdata : dmem_req_wdata;
+  wire [3:0]  mem_wmask = dma_grant ? 4'b1111 : dmem_req_wmask;
+  wire        mem_write = dma_grant ? dma_m_write : dmem_req_write;
+  wire        mem_sram_valid = dma_grant ? !dma_m_is_tcm : (dmem_req_valid && !dmem_req_is_tcm && !dmem_req_is_dma && !dmem_req_is_clint);
+  wire        mem_tcm_valid  = dma_grant ? dma_m_is_tcm : (dmem_req_valid && dmem_req_is_tcm);
 
   always @ (posedge clk) begin
     if (!resetn) begin
@@ -51,45 +101,196 @@ module top (
     end
   end
 
-  ucrv32 cpu(
-    .clk(clk),
-    .resetn(resetn),
-    .imem_addr(imem_addr),
-    .imem_rdata(imem_rdata),
+  generate
+    if (PIPELINE != 0) begin : g_pipe
+      ucrv32_pipe #(
+        .VPREFETCH_EN(VPREFETCH_EN),
+        .BPRED_EN(BPRED_EN),
+        .ALU_ADDER(ALU_ADDER),
+        .PC_ADDER(PC_ADDER),
+        .VALU_MULS(VALU_MULS),
+        .VLEN(VLEN)
+      ) cpu(
+        .clk(clk),
+        .resetn(resetn),
+        .imem_addr(imem_addr),
+        .imem_rdata(imem_rdata),
 
-    .dmem_req_addr(dmem_req_addr),
-    .dmem_req_wdata(dmem_req_wdata),
-    .dmem_req_wmask(dmem_req_wmask),
-    .dmem_req_write(dmem_req_write),
-    .dmem_req_valid(dmem_req_valid),
-    .dmem_req_ready(dmem_req_ready),
+        .dmem_req_addr(dmem_req_addr),
+        .dmem_req_wdata(dmem_req_wdata),
+        .dmem_req_wmask(dmem_req_wmask),
+        .dmem_req_write(dmem_req_write),
+        .dmem_req_valid(dmem_req_valid),
+        .dmem_req_ready(dmem_req_ready),
 
-    .dmem_resp_valid(dmem_resp_valid),
-    .dmem_resp_ready(dmem_resp_ready),
-    .dmem_resp_rdata(dmem_resp_rdata),
-    .ebreak_hit(cpu_break),
+        .dmem_resp_valid(dmem_resp_valid),
+        .dmem_resp_ready(dmem_resp_ready),
+        .dmem_resp_rdata(dmem_resp_rdata),
+        .dmem_req_vector(dmem_req_vector),
+        .ebreak_hit(cpu_break),
+        .retire(cpu_retire),
 
-    .trace_pc(trace_pc),
-    .trace_insn(trace_insn)
-  );
+        .ext_write_valid(dma_grant && dma_m_write),
+        .ext_write_addr(dma_m_addr),
+
+        .mtime(clint_mtime),
+        .timer_irq(clint_timer_irq),
+        .soft_irq(clint_soft_irq),
+
+        .vtcm_addr(vtcm_addr),
+        .vtcm_wdata(vtcm_wdata),
+        .vtcm_write(vtcm_write),
+        .vtcm_valid(vtcm_valid),
+        .vtcm_rdata(vtcm_rdata),
+
+        .trace_pc(trace_pc),
+        .trace_insn(trace_insn)
+      );
+    end else begin : g_fsm
+      ucrv32 #(
+        .VPREFETCH_EN(VPREFETCH_EN),
+        .WBUF_EN(WBUF_EN),
+        .IPREFETCH_EN(IPREFETCH_EN),
+        .VDECOUPLE_EN(VDECOUPLE_EN),
+        .ALU_ADDER(ALU_ADDER),
+        .PC_ADDER(PC_ADDER),
+        .VALU_MULS(VALU_MULS),
+        .VLEN(VLEN)
+      ) cpu(
+        .clk(clk),
+        .resetn(resetn),
+        .imem_addr(imem_addr),
+        .imem_rdata(imem_rdata),
+
+        .dmem_req_addr(dmem_req_addr),
+        .dmem_req_wdata(dmem_req_wdata),
+        .dmem_req_wmask(dmem_req_wmask),
+        .dmem_req_write(dmem_req_write),
+        .dmem_req_valid(dmem_req_valid),
+        .dmem_req_ready(dmem_req_ready),
+
+        .dmem_resp_valid(dmem_resp_valid),
+        .dmem_resp_ready(dmem_resp_ready),
+        .dmem_resp_rdata(dmem_resp_rdata),
+        .dmem_req_vector(dmem_req_vector),
+        .ebreak_hit(cpu_break),
+        .retire(cpu_retire),
+
+        .ext_write_valid(dma_grant && dma_m_write),
+        .ext_write_addr(dma_m_addr),
+
+        .mtime(clint_mtime),
+        .timer_irq(clint_timer_irq),
+        .soft_irq(clint_soft_irq),
+
+        .vtcm_addr(vtcm_addr),
+        .vtcm_wdata(vtcm_wdata),
+        .vtcm_write(vtcm_write),
+        .vtcm_valid(vtcm_valid),
+        .vtcm_rdata(vtcm_rdata),
+
+        .trace_pc(trace_pc),
+        .trace_insn(trace_insn)
+      );
+    end
+  endgenerate
 
   wire [31:0] sram_dmem_rdata;
   wire sram_dmem_resp_valid;
 
-  sram sram0 (
+  sram #(
+    .DMEM_LATENCY(DMEM_LATENCY)
+  ) sram0 (
     .clk(clk),
     .resetn(resetn),
     .imem_addr(imem_addr),
     .imem_rdata(imem_rdata),
-    .dmem_addr(dmem_req_addr),
-    .dmem_wdata(dmem_req_wdata),
-    .dmem_wmask(dmem_req_wmask),
-    .dmem_write(dmem_req_write),
-    .dmem_valid(dmem_req_valid),
+    .dmem_addr(mem_addr),
+    .dmem_wdata(mem_wdata),
+    .dmem_wmask(mem_wmask),
+    .dmem_write(mem_write),
+    .dmem_valid(mem_sram_valid),
     .dmem_rdata(sram_dmem_rdata),
     .dmem_resp_valid(sram_dmem_resp_valid)
   );
 
+  wire [31:0] tcm_dmem_rdata;
+  wire tcm_dmem_resp_valid;
+
+  tcm #(.VLEN(VLEN)) tcm0 (
+    .clk(clk),
+    .a_addr(mem_addr),
+    .a_wdata(mem_wdata),
+    .a_wmask(mem_wmask),
+    .a_write(mem_write),
+    .a_valid(mem_tcm_valid),
+    .a_rdata(tcm_dmem_rdata),
+    .a_resp_valid(tcm_dmem_resp_valid),
+    .v_addr(vtcm_addr),
+    .v_wdata(vtcm_wdata),
+    .v_write(vtcm_write),
+    .v_valid(vtcm_valid),
+    .v_rdata(vtcm_rdata)
+  );
+
+  // DMA read responses come back on the same SRAM/TCM ports, keep them away
+  // from the core (SRAM reads are tracked through the DMEM_LATENCY pipeline)
+  reg [DMEM_LATENCY-1:0] dma_sram_rd_pipe;
+  reg dma_tcm_rd;
+  integer s;
+  always @ (posedge clk) begin
+    if (!resetn) begin
+      dma_sram_rd_pipe <= {DMEM_LATENCY{1'b0}};
+      dma_tcm_rd <= 1'b0;
+    end else begin
+      dma_sram_rd_pipe[0] <= dma_grant && !dma_m_write && !dma_m_is_tcm;
+      for (s = 1; s < DMEM_LATENCY; s = s + 1) begin
+        dma_sram_rd_pipe[s] <= dma_sram_rd_pipe[s-1];
+      end
+      dma_tcm_rd <= dma_grant && !dma_m_write && dma_m_is_tcm;
+    end
+  end
+
+  assign dma_m_resp_valid = dma_sram_rd_pipe[DMEM_LATENCY-1] || dma_tcm_rd;
+  assign dma_m_resp_rdata = dma_tcm_rd ? tcm_dmem_rdata : sram_dmem_rdata;
+
+  wire [31:0] dma_reg_rdata;
+  wire dma_reg_resp_valid;
+
+  dma dma0 (
+    .clk(clk),
+    .resetn(resetn),
+    .reg_addr(dmem_req_addr[4:0]),
+    .reg_wdata(dmem_req_wdata),
+    .reg_write(dmem_req_write),
+    .reg_valid(dmem_req_valid && dmem_req_is_dma),
+    .reg_rdata(dma_reg_rdata),
+    .reg_resp_valid(dma_reg_resp_valid),
+    .m_addr(dma_m_addr),
+    .m_wdata(dma_m_wdata),
+    .m_write(dma_m_write),
+    .m_valid(dma_m_valid),
+    .m_ready(dma_grant),
+    .m_resp_valid(dma_m_resp_valid),
+    .m_resp_rdata(dma_m_resp_rdata)
+  );
+
+  wire [31:0] clint_reg_rdata;
+  wire clint_reg_resp_valid;
+
+  clint clint0 (
+    .clk(clk),
+    .resetn(resetn),
+    .reg_addr(dmem_req_addr[15:0]),
+    .reg_wdata(dmem_req_wdata),
+    .reg_write(dmem_req_write),
+    .reg_valid(dmem_req_valid && dmem_req_is_clint),
+    .reg_rdata(clint_reg_rdata),
+    .reg_resp_valid(clint_reg_resp_valid),
+    .mtime(clint_mtime),
+    .timer_irq(clint_timer_irq),
+    .soft_irq(clint_soft_irq)
+  );
 
   reg [31:0] dmem_raddr_reg;
   always @ (posedge clk) begin
@@ -107,8 +308,15 @@ module top (
   assign dmem_resp_rdata = (dmem_raddr_reg[31:12] == 20'h10000 && !sim_use_par_txrx) ? uart_resp_rdata : 
                            (dmem_raddr_reg[31:12] == 20'h10000 && sim_use_par_txrx) ? (
                             (dmem_raddr_reg[11:0] == 12'h008) ? 32'd0 : {23'd0, par_rx_valid_latch, par_rx_latch})
+                             : (dmem_raddr_reg[31:12] == 20'h10001) ? dma_reg_rdata
+                             : (dmem_raddr_reg[31:16] == 16'h0200) ? clint_reg_rdata
+                             : (dmem_raddr_reg[31:16] == 16'h2000) ? tcm_dmem_rdata
                              : sram_dmem_rdata;
-  assign dmem_resp_valid = (dmem_raddr_reg[31:12] == 20'h10000 && !sim_use_par_txrx) ? uart_resp_valid : sram_dmem_resp_valid;
+  assign dmem_resp_valid = (dmem_raddr_reg[31:12] == 20'h10000 && !sim_use_par_txrx) ? uart_resp_valid :
+                           (dmem_raddr_reg[31:12] == 20'h10001) ? dma_reg_resp_valid :
+                           (dmem_raddr_reg[31:16] == 16'h0200) ? clint_reg_resp_valid :
+                           (dmem_raddr_reg[31:16] == 16'h2000) ? (tcm_dmem_resp_valid && !dma_tcm_rd) :
+                           (sram_dmem_resp_valid && !dma_sram_rd_pipe[DMEM_LATENCY-1]);
   assign uart_resp_ready = dmem_resp_ready;
   assign dmem_req_ready = (dmem_req_addr[31:12] == 20'h10000 && !sim_use_par_txrx) ? uart_req_ready : 
                           (dmem_req_addr[31:12] == 20'h10000 && sim_use_par_txrx) ? 1'b1 : 1'b1;
@@ -21,7 +21,16 @@ module register_file (
 endmodule
 
 
-module ucrv32 (
+module ucrv32 #(
+  parameter VPREFETCH_EN = 1, // stride prefetcher in front of vlsu (0 = pass-through)
+  parameter WBUF_EN = 1,      // stores retire into the write buffer (0 = wait in STATE_MEM)
+  parameter IPREFETCH_EN = 1, // instruction prefetch buffer, skips STATE_FETCH (0 = fetch after WB)
+  parameter ALU_ADDER = 0,    // adder_32 ARCH for the ALU: 0 ripple, 1 CLA, 2 Kogge-Stone, 3 behavioral
+  parameter PC_ADDER = 0,     // adder_32 ARCH for the PC+4 / branch target adders
+  parameter VDECOUPLE_EN = 1, // vector ops retire into the issue queue (0 = wait for the vector units)
+  parameter VALU_MULS = 4,    // VALU lane multipliers: 4, 8 or 16
+  parameter VLEN = 64         // vector register width: 64, 128 or 256
+) (
   // reset and clock
   input clk, resetn,
 
@@ -40,8 +49,26 @@ module ucrv32 (
   input              dmem_resp_valid,
   output wire        dmem_resp_ready,
   input       [31:0] dmem_resp_rdata,
+  output wire        dmem_req_vector, // request issued by the vector unit
 
   output wire ebreak_hit,
+  output wire retire, // one instruction leaves WB this cycle
+
+  // writes by other bus masters (DMA), keep the prefetch buffer coherent
+  input              ext_write_valid,
+  input       [31:0] ext_write_addr,
+
+  // CLINT
+  input       [63:0] mtime,
+  input              timer_irq,
+  input              soft_irq,
+
+  // vector scratchpad (TCM) port, VLEN bits, read data on the next cycle
+  output wire [31:0] vtcm_addr,
+  output wire [VLEN-1:0] vtcm_wdata,
+  output wire        vtcm_write,
+  output wire        vtcm_valid,
+  input       [VLEN-1:0] vtcm_rdata,
 
   // trace outputs
   output [31:0] trace_pc,
@@ -62,44 +89,13 @@ module ucrv32 (
   reg [31:0] pc_reg;
   reg [31:0] pc_saved;  // PC of current instruction (saved during fetch)
   reg [31:0] insn_reg;
+  reg        is_rvc_reg;  // insn_reg was expanded from a 16-bit instruction
   reg [31:0] rdata1_reg;
   reg [31:0] rdata2_reg;
   reg [31:0] imm_reg;
   reg [31:0] alu_out_reg;
   reg [31:0] mem_data_reg;
 
-  reg [31:0] mtvec;
-  reg [31:0] mepc;
-  reg [31:0] mcause;
-  reg [31:0] mstatus;
-
-  // CSR 주소는 12비트
-  wire [11:0] csr_addr;
-  assign csr_addr = imm_reg[11:0];
-
-  always @ (posedge clk) begin
-    if(!resetn) begin
-      mtvec <= 32'd0;
-      mepc <= 32'd0;
-      mcause <= 32'd0;
-      mstatus <= 32'd0;
-    end
-    else begin
-      if(cpu_state == STATE_WB) begin
-        case(csr_addr)
-          12'h035: mtvec <= rdata1_reg;
-          12'h341: mepc <= rdata1_reg;
-          12'h342: mcause <= rdata1_reg;
-          12'h300: mstatus <= rdata1_reg;
-          default: mstatus <= mstatus;
-        endcase
-      end
-    end
-  end
-  
-
-
-
   // Control signals stored
   reg [4:0]  rd_reg;
   reg [3:0]  alu_ctrl_reg;
@@ -120,6 +116,22 @@ module ucrv32 (
   // 7.3 VMAC control signals
   reg        is_vmac_reg;
   reg [1:0]  vmac_ctrl_reg;
+  reg        is_muldiv_reg;
+  reg [2:0]  muldiv_ctrl_reg;
+  reg        is_csr_reg;
+  reg [2:0]  csr_op_reg;
+  reg        is_ecall_reg;
+  reg        is_mret_reg;
+  reg        trap_refetch; // imem still has the old address for one cycle after an interrupt
+  reg        is_lpsetup_reg;
+  reg        is_vset_reg; // VMSETL
+  reg        is_vsetl_reg; // VSETL
+
+  // hardware loop (lp.setup): the instruction at lp_end is followed by
+  // lp_start while lp_count > 1, lp_count counts down when it retires
+  reg [31:0] lp_start;
+  reg [31:0] lp_end;
+  reg [31:0] lp_count;
 
   // 7.6 Performance counters (from Lab 5)
   reg [31:0] cycle_counter;
@@ -130,20 +142,22 @@ module ucrv32 (
   // 7.6 Performance counter control signals
   reg        is_rdwrctr_reg;
   reg        rdwrctr_wen_reg;
-  reg [1:0]  rdwrctr_ctr_id_reg;
+  reg [2:0]  rdwrctr_ctr_id_reg;
 
   // new vector extension control registers
   reg        is_vec_op_reg;
-  reg [2:0]  vec_op_reg;
+  reg [3:0]  vec_op_reg;
   reg [1:0]  vec_sew_reg;
   reg        is_vec_load_reg;
   reg        is_vec_store_reg;
-  reg        is_vec_vmac_reg;  // VMAC.B: result goes to scalar register
+  reg        is_vec_vmac_reg;  // VMAC/VREDACC/VMOV_V2S/reductions: result goes to scalar register
+  reg        vec_vx_reg; // .vx: vs2 is rs2 broadcast
+  reg        vec_base_write_reg; // post-increment VLD/VST: new base to rs1 in WB
+  reg [1:0]  vec_ld_mode_reg; // VLD unit/strided/indexed
+  reg        vec_masked_reg; // active elements from vmask
   reg        vec_reg_write_reg;
   reg [4:0] vd_reg; // vector destination register
-  reg vec_busy;
-  reg vec_valid_in_reg; // start signal for vector units
-  reg vlsu_start_reg; // start signal for vector load/store unit
+  reg vec_busy; // VDECOUPLE_EN=0: pushed, waiting for the back-end to finish
 
   // Decoder and control outputs
   wire [4:0]  dec_rd;
@@ -173,16 +187,39 @@ module ucrv32 (
   // 7.6 Performance counter decoder outputs
   wire        dec_is_rdwrctr;
   wire        dec_rdwrctr_wen;
-  wire [1:0]  dec_rdwrctr_ctr_id;
+  wire [2:0]  dec_rdwrctr_ctr_id;
 
   // new vector decoder outputs
   wire        dec_is_vec_op;
-  wire [2:0]  dec_vec_op;
+  wire [3:0]  dec_vec_op;
   wire [1:0]  dec_vec_sew;
   wire        dec_is_vec_load;
   wire        dec_is_vec_store;
   wire        dec_vec_reg_write;
   wire        dec_is_vec_vmac;
+  wire        dec_vec_vx;
+  wire        dec_vec_base_write;
+  wire [1:0]  dec_vec_ld_mode;
+  wire        dec_vec_masked;
+  wire        dec_is_vset;
+  wire        dec_is_vsetl;
+  wire        dec_is_muldiv;
+  wire [2:0]  dec_muldiv_ctrl;
+  wire        dec_is_csr;
+  wire [2:0]  dec_csr_op;
+  wire        dec_is_ecall;
+  wire        dec_is_mret;
+  wire        dec_is_lpsetup;
+
+  // Zicsr / Zihpm counters, traps, vector mask and vl/vtype
+  wire [31:0] csr_rdata;
+  wire [31:0] vset_grant;
+  wire [VLEN/8-1:0] vmask_bytes;
+  wire [1:0]  vtype_sew;
+  wire [VLEN/8-1:0] vl_bytes;
+  wire        irq_pending;
+  wire [31:0] trap_vector;
+  wire [31:0] mepc;
 
   // 7.3 VMAC handshake + result wires
   reg        vmac_valid_in_reg;
@@ -190,7 +227,13 @@ module ucrv32 (
   wire [31:0] vmac_result_wire;
   reg vmac_busy; // CPU-side busy flag while vmac running, computing flag role
 
-  decoder_control decoder_control_inst(
+  // M extension handshake, same as vmac
+  reg        muldiv_valid_in_reg;
+  wire       muldiv_valid_out;
+  wire [31:0] muldiv_result_wire;
+  reg muldiv_busy;
+
+  decoder_control #(.VLEN(VLEN)) decoder_control_inst(
     .insn(insn_reg),
     .rd(dec_rd),
     .rs1(dec_rs1),
@@ -226,7 +269,21 @@ module ucrv32 (
     .is_vec_load(dec_is_vec_load),
     .is_vec_store(dec_is_vec_store),
     .vec_reg_write(dec_vec_reg_write),
-    .is_vec_vmac(dec_is_vec_vmac)
+    .is_vec_vmac(dec_is_vec_vmac),
+    .vec_vx(dec_vec_vx),
+    .vec_base_write(dec_vec_base_write),
+    .vec_ld_mode(dec_vec_ld_mode),
+    .vec_masked(dec_vec_masked),
+    .is_vset(dec_is_vset),
+    .is_vsetl(dec_is_vsetl),
+    // M extension
+    .is_muldiv(dec_is_muldiv),
+    .muldiv_ctrl(dec_muldiv_ctrl),
+    .is_csr(dec_is_csr),
+    .csr_op(dec_csr_op),
+    .is_ecall(dec_is_ecall),
+    .is_mret(dec_is_mret),
+    .is_lpsetup(dec_is_lpsetup)
   );
 
   // 7.3 VMAC instance
@@ -241,56 +298,186 @@ module ucrv32 (
     .result(vmac_result_wire)
   );
 
-  // new vector register file instance
-  wire [63:0] vrf_rdata1, vrf_rdata2;
-  wire [63:0] vrf_wdata;
+  // M extension: MUL* (2-cycle pipeline), DIV*/REM* (radix-4, early out)
+  muldiv muldiv_inst (
+    .clk(clk),
+    .rst_n(resetn),
+    .ctrl(muldiv_ctrl_reg),
+    .a(rdata1_reg),
+    .b(rdata2_reg),
+    .valid_in(muldiv_valid_in_reg),
+    .valid_out(muldiv_valid_out),
+    .result(muldiv_result_wire)
+  );
+
+  //=============================================================================
+  // Vector back-end
+  //=============================================================================
+  // EXEC pushes vector instructions into the issue queue and they retire. The
+  // back-end issues them in order to two units, VALU and the memory side
+  // (vlsu, TCM or write buffer), which run at the same time as each other and
+  // as the scalar FSM. vsb marks vector registers with a write in flight, xsb
+  // the scalar rd of a queued VMAC.B: the head waits on vsb (RAW/WAW), DECODE
+  // waits on xsb, scalar loads/stores wait for queued vector memory ops.
+  localparam VQ_WIDTH = 124 + VLEN / 8; // queue entry, fields below
+  wire        vq_push;
+  wire        vq_pop;
+  wire        vq_can_push;
+  wire        vq_head_valid;
+  wire [VQ_WIDTH-1:0] vq_head;
+
+  // VMOV_S2V reads the old vd through the vs1 port, its rs1 is the scalar
+  wire vq_push_s2v = (vec_op_reg == 4'b0110);
+
+  // entry: byte enables of the active elements, pc, rs1 value, rs2 value (VLDS
+  // stride, .vx/VNCLIP scalar), vs2 (VMOV lane), vs1, vd, sew, op, load mode,
+  // vx, load, store, vmac, vreg write. The mask (vl, and vmask for the masked
+  // forms) is taken at push, so a later VSETL, VMSETL or vmask write does not
+  // reach ops already queued.
+  wire [VLEN/8-1:0] vq_push_bmask = vl_bytes & (vec_masked_reg ? vmask_bytes : {(VLEN/8){1'b1}});
+
+  viq #(.DEPTH(4), .WIDTH(VQ_WIDTH)) viq_inst(
+    .clk(clk),
+    .rst_n(resetn),
+    .push(vq_push),
+    .push_data({vq_push_bmask, pc_saved, rdata1_reg, rdata2_reg, dec_rs2, vq_push_s2v ? vd_reg : dec_rs1, vd_reg, vec_sew_reg,
+                vec_op_reg, vec_ld_mode_reg, vec_vx_reg, is_vec_load_reg, is_vec_store_reg, is_vec_vmac_reg,
+                vec_reg_write_reg}),
+    .can_push(vq_can_push),
+    .head_valid(vq_head_valid),
+    .head_data(vq_head),
+    .pop(vq_pop),
+    .empty()
+  );
+
+  wire [VLEN/8-1:0] vq_h_bmask = vq_head[VQ_WIDTH-1:124];
+  wire [31:0] vq_h_pc    = vq_head[123:92];
+  wire [31:0] vq_h_base  = vq_head[91:60];
+  wire [31:0] vq_h_stride = vq_head[59:28];
+  wire [4:0]  vq_h_vs2   = vq_head[27:23];
+  wire [4:0]  vq_h_vs1   = vq_head[22:18];
+  wire [4:0]  vq_h_vd    = vq_head[17:13];
+  wire [1:0]  vq_h_sew   = vq_head[12:11];
+  wire [3:0]  vq_h_op    = vq_head[10:7];
+  wire [1:0]  vq_h_mode  = vq_head[6:5];
+  wire        vq_h_vx    = vq_head[4];
+  wire        vq_h_load  = vq_head[3];
+  wire        vq_h_store = vq_head[2];
+  wire        vq_h_vmac  = vq_head[1];
+  wire        vq_h_vwrite = vq_head[0];
+  wire        vq_h_full  = &vq_h_bmask; // unmasked, or every element active
+
+  reg [31:0] vsb; // vector register written by an op in flight
+  reg [31:0] xsb; // scalar register written by a queued/running VMAC.B, VMOV_V2S or reduction
+  reg [2:0]  vq_mem_cnt; // VLD/VST in the queue
+
+  // VALU side: the VALU is pipelined, several ops can be in flight. vaq
+  // holds the destination of each one in issue order, the head belongs to
+  // the result at the VALU output.
+  wire       va_issue;
+  wire       va_fin;
+  wire       va_can_push;
+  wire       va_empty;
+  wire [6:0] va_head;
+  wire [4:0] va_vd     = va_head[6:2];
+  wire       va_vwrite = va_head[1];
+  wire       va_vmac   = va_head[0];
+
+  // entry: vd, vreg write, vmac
+  viq #(.DEPTH(4), .WIDTH(7)) vaq_inst(
+    .clk(clk),
+    .rst_n(resetn),
+    .push(va_issue),
+    .push_data({vq_h_vd, vq_h_vwrite, vq_h_vmac}),
+    .can_push(va_can_push),
+    .head_valid(),
+    .head_data(va_head),
+    .pop(va_fin),
+    .empty(va_empty)
+  );
+
+  // memory side
+  reg        vm_busy;
+  reg        vm_start;
+  reg        vm_done_seen; // vlsu finished (or TCM request sent)
+  reg        vm_load;
+  reg        vm_store;
+  reg        vm_tcm;
+  reg [1:0]  vm_mode;   // VLD unit/strided/indexed
+  reg [1:0]  vm_sew;
+  reg [31:0] vm_stride;
+  reg [VLEN/8-1:0] vm_bmask;
+  reg [31:0] vm_addr;
+  reg [31:0] vm_pc;
+  reg [VLEN-1:0] vm_data;
+  reg [4:0]  vm_vd;
+  reg [VLEN-1:0] vm_result;
+
+  // new vector register file instance, read by the queue head
+  wire [VLEN-1:0] vrf_rdata1, vrf_rdata2;
+  wire [VLEN-1:0] vrf_wdata;
+  wire [4:0] vrf_waddr;
   wire vrf_wen;
 
-  vreg_file vreg_file_inst(
+  vreg_file #(.VLEN(VLEN)) vreg_file_inst(
     .clk(clk),
     .wen(vrf_wen),
-    .vs1(dec_rs1),
-    .vs2(dec_rs2),
-    .vd(vd_reg),
+    .vs1(vq_h_vs1),
+    .vs2(vq_h_vs2),
+    .vd(vrf_waddr),
     .wdata(vrf_wdata),
     .rdata1(vrf_rdata1),
     .rdata2(vrf_rdata2)
   );
 
-  // new vector alu
+  // new vector alu, operands straight from the register file at issue
+  wire valu_in_ready;
   wire valu_valid_out;
-  wire [63:0] valu_result;
-  reg [63:0] vs1_data_reg;
-  reg [63:0] vs2_data_reg;
-  
-  valu valu_inst(
+  wire [VLEN-1:0] valu_result;
+
+  valu #(.VLEN(VLEN), .NUM_MULS(VALU_MULS)) valu_inst(
     .clk(clk),
     .rst_n(resetn),
-    .op(vec_op_reg[1:0]), // 00=VADD, 01=VSUB, 10=VMUL
-    .sew(vec_sew_reg),
-    .vs1_data(vs1_data_reg),
-    .vs2_data(vs2_data_reg),
-    .valid_in(vec_valid_in_reg && !is_vec_load_reg && !is_vec_store_reg),
+    .op(vq_h_op), // VADD/VSUB/VMUL/VMAC/VMACC/VREDACC/VMOV/VNCLIP[.ACC]
+    .sew(vq_h_sew),
+    .vs1_data(vrf_rdata1),
+    .vs2_data(vrf_rdata2),
+    .vx(vq_h_vx),
+    .scalar(vq_h_vx ? vq_h_stride : vq_h_base), // .vx/VNCLIP: rs2, VMOV_S2V: rs1
+    .lane(vq_h_vs2),
+    .vmask(vq_h_bmask),
+    .valid_in(va_issue),
+    .in_ready(valu_in_ready),
     .valid_out(valu_valid_out),
+    .out_ready(va_fin),
     .result(valu_result)
   );
 
   // new vector load/store unit
   wire vlsu_done;
-  wire [63:0] vlsu_load_data;
+  wire [VLEN-1:0] vlsu_load_data;
   wire [31:0] vlsu_mem_addr;
   wire [31:0] vlsu_mem_wdata;
   wire [3:0] vlsu_mem_wmask;
   wire vlsu_mem_write;
   wire vlsu_mem_valid;
+  wire vlsu_mem_ready;
+  wire vlsu_mem_resp_valid;
+  wire [31:0] vlsu_mem_resp_rdata;
+  wire vec_mem_active; // vector side owns the data bus
 
-  vlsu vlsu_inst(
+  vlsu #(.VLEN(VLEN)) vlsu_inst(
     .clk(clk),
     .rst_n(resetn),
-    .start(vlsu_start_reg),
-    .is_store(is_vec_store_reg),
-    .base_addr(rdata1_reg),
-    .store_data(vs2_data_reg),
+    .start(vm_start && !vm_tcm),
+    .is_store(vm_store),
+    .base_addr(vm_addr),
+    .store_data(vm_data),
+    .mode(vm_mode),
+    .sew(vm_sew),
+    .stride(vm_stride),
+    .offsets(vm_data), // VLDX: vs2 read at issue, like VST data
+    .bmask(vm_bmask),
     .done(vlsu_done),
     .load_data(vlsu_load_data),
     .mem_addr(vlsu_mem_addr),
@@ -298,26 +485,63 @@ module ucrv32 (
     .mem_wmask(vlsu_mem_wmask),
     .mem_write(vlsu_mem_write),
     .mem_valid(vlsu_mem_valid),
+    .mem_ready(vlsu_mem_ready),
+    .mem_resp_valid(vlsu_mem_resp_valid),
+    .mem_resp_rdata(vlsu_mem_resp_rdata)
+  );
+
+  // new stride prefetcher between vlsu and the data bus
+  wire [31:0] vpf_mem_addr;
+  wire [31:0] vpf_mem_wdata;
+  wire [3:0] vpf_mem_wmask;
+  wire vpf_mem_write;
+  wire vpf_mem_valid;
+  wire vpf_idle;
+  wire [31:0] vpf_useful_count;
+  wire [31:0] vpf_useless_count;
+
+  vprefetch #(.VLEN(VLEN)) vprefetch_inst(
+    .clk(clk),
+    .rst_n(resetn),
+    .enable(VPREFETCH_EN != 0 && vec_mem_active),
+    .train_valid(VPREFETCH_EN != 0 && vm_start && vm_load && !vm_tcm && vm_mode == 2'b00),
+    .train_pc(vm_pc),
+    .train_addr(vm_addr),
+    .vlsu_addr(vlsu_mem_addr),
+    .vlsu_wdata(vlsu_mem_wdata),
+    .vlsu_wmask(vlsu_mem_wmask),
+    .vlsu_write(vlsu_mem_write),
+    .vlsu_valid(vlsu_mem_valid),
+    .vlsu_ready(vlsu_mem_ready),
+    .vlsu_resp_valid(vlsu_mem_resp_valid),
+    .vlsu_resp_rdata(vlsu_mem_resp_rdata),
+    .mem_addr(vpf_mem_addr),
+    .mem_wdata(vpf_mem_wdata),
+    .mem_wmask(vpf_mem_wmask),
+    .mem_write(vpf_mem_write),
+    .mem_valid(vpf_mem_valid),
     .mem_ready(dmem_req_ready),
     .mem_resp_valid(dmem_resp_valid),
-    .mem_resp_rdata(dmem_resp_rdata)
+    .mem_resp_rdata(dmem_resp_rdata),
+    .snoop_write((dmem_req_valid && dmem_req_write && dmem_req_ready) || ext_write_valid),
+    .snoop_addr(ext_write_valid ? ext_write_addr : dmem_req_addr),
+    .idle(vpf_idle),
+    .useful_count(vpf_useful_count),
+    .useless_count(vpf_useless_count)
   );
 
-  // vector result storage
-  reg [63:0] vec_result_reg;
-
-
   wire [31:0] rf_rdata1, rf_rdata2;
   wire [31:0] wb_data;
   wire        wb_enable;
+  wire        vx_wen; // VMAC.B result, takes the write port when WB does not use it
 
   register_file regfile(
     .clk(clk),
-    .wen(wb_enable),
+    .wen(wb_enable || vx_wen),
     .rs1(dec_rs1),
     .rs2(dec_rs2),
-    .waddr(rd_reg),
-    .wdata(wb_data),
+    .waddr(wb_enable ? rd_reg : va_vd),
+    .wdata(wb_enable ? wb_data : valu_result[31:0]),
     .rdata1(rf_rdata1),
     .rdata2(rf_rdata2)
   );
@@ -330,7 +554,7 @@ module ucrv32 (
   assign alu_op1 = is_auipc_reg ? pc_saved : rf_rdata1;
   assign alu_op2 = alu_src2_sel_reg ? imm_reg : rf_rdata2;
 
-  alu alu_inst(
+  alu #(.ADDER(ALU_ADDER)) alu_inst(
     .op1(alu_op1),
     .op2(alu_op2),
     .alu_ctrl(alu_ctrl_reg),
@@ -345,22 +569,215 @@ module ucrv32 (
   reg [31:0] dmem_req_wdata_reg;
   reg [3:0]  dmem_req_wmask_reg;
 
-  // memory interface, mux between scalar and vector access
-  wire vec_mem_active = (is_vec_load_reg || is_vec_store_reg) && vec_busy;
+  // new vector scratchpad: VLD/VST inside the TCM window (0x2000_0000, 64 KB)
+  // use the private VLEN-bit port instead of vlsu and the shared bus; strided
+  // and indexed VLDs take vlsu, the TCM is on the bus too. The port has no
+  // byte enables: a VST with inactive elements goes through vlsu.
+  wire vq_h_tcm = (vq_h_base[31:16] == 16'h2000) && (vq_h_mode == 2'b00) && (vq_h_load || vq_h_full);
+  assign vtcm_valid = vm_start && vm_tcm;
+  assign vtcm_addr = vm_addr;
+  assign vtcm_wdata = vm_data;
+  assign vtcm_write = vm_store;
+
+  // new write buffer
+  // scalar stores and VSTs to SRAM retire into it, it drains when the bus is free
+  wire mem_in_sram = (alu_out[31:24] == 8'h00);
+  wire vst_in_sram = (vq_h_base[31:24] == 8'h00);
+
+  // store data/byte enables aligned to the word
+  wire [31:0] st_wdata = (mem_mask_reg == 32'h000000FF) ? {4{rdata2_reg[7:0]}} :
+                         (mem_mask_reg == 32'h0000FFFF) ? {2{rdata2_reg[15:0]}} :
+                         rdata2_reg;
+  wire [3:0] mem_bmask = (mem_mask_reg == 32'h000000FF) ? ((alu_out[1:0] == 2'b00) ? 4'b0001 :
+                                                           (alu_out[1:0] == 2'b01) ? 4'b0010 :
+                                                           (alu_out[1:0] == 2'b10) ? 4'b0100 : 4'b1000) :
+                         (mem_mask_reg == 32'h0000FFFF) ? (alu_out[1] ? 4'b1100 : 4'b0011) :
+                         4'b1111;
+
+  wire wbuf_can_push, wbuf_can_push_vec, wbuf_empty, wbuf_line_match;
+  wire [31:0] wbuf_fwd_data;
+  wire [3:0] wbuf_fwd_mask;
+  wire wbuf_drain_valid;
+  wire [31:0] wbuf_drain_addr, wbuf_drain_wdata;
+  wire [3:0] wbuf_drain_wmask;
+
+  // scalar loads/stores wait until queued VLD/VSTs have left the back-end
+  wire vmem_pending = vm_busy || (vq_mem_cnt != 3'd0);
+
+  wire scalar_mem_exec = (cpu_state == STATE_EXEC) && !is_rdwrctr_reg && !is_vec_op_reg && !is_vmac_reg && !is_muldiv_reg && !is_csr_reg;
+  wire st_buffered = (WBUF_EN != 0) && mem_write_reg && mem_in_sram;
+  wire vst_buffered = (WBUF_EN != 0) && vq_h_store && vst_in_sram && vq_h_full;
+  // load fully covered by buffered bytes
+  wire ld_forward = (WBUF_EN != 0) && mem_read_reg && mem_in_sram &&
+                    ((wbuf_fwd_mask & mem_bmask) == mem_bmask);
+  // partial overlap with a buffered store, or MMIO access behind buffered stores
+  wire mem_wait_wbuf = (WBUF_EN != 0) && (mem_read_reg || mem_write_reg) &&
+                       (mem_in_sram ? ((wbuf_fwd_mask & mem_bmask) != 4'b0000) : !wbuf_empty);
+
+  wire wbuf_push_st = scalar_mem_exec && !vmem_pending && st_buffered && wbuf_can_push;
+  wire wbuf_push_vst;
+
+  // drains only when neither the vector side nor a scalar request uses the bus
+  wire wbuf_drain_grant = !vec_mem_active && !dmem_req_valid_reg && wbuf_drain_valid;
+
+  // room for a whole VST
+  localparam WBUF_DEPTH = (VLEN / 32 > 4) ? VLEN / 32 : 4;
+
+  wbuf #(.DEPTH(WBUF_DEPTH), .VLEN(VLEN)) wbuf_inst(
+    .clk(clk),
+    .rst_n(resetn),
+    .push(wbuf_push_st),
+    .push_addr(alu_out),
+    .push_wdata(st_wdata),
+    .push_wmask(mem_bmask),
+    .push_vec(wbuf_push_vst),
+    .push_vec_addr(vq_h_base),
+    .push_vec_wdata(vrf_rdata2),
+    .can_push(wbuf_can_push),
+    .can_push_vec(wbuf_can_push_vec),
+    .lookup_addr(alu_out),
+    .fwd_data(wbuf_fwd_data),
+    .fwd_mask(wbuf_fwd_mask),
+    .line_addr(vq_h_base),
+    .line_match(wbuf_line_match),
+    .drain_valid(wbuf_drain_valid),
+    .drain_addr(wbuf_drain_addr),
+    .drain_wdata(wbuf_drain_wdata),
+    .drain_wmask(wbuf_drain_wmask),
+    .drain_ready(wbuf_drain_grant && dmem_req_ready),
+    .empty(wbuf_empty)
+  );
 
-  assign dmem_req_valid = vec_mem_active ? vlsu_mem_valid : dmem_req_valid_reg;
-  assign dmem_req_write = vec_mem_active ? vlsu_mem_write : dmem_req_write_reg;
-  assign dmem_req_addr  = vec_mem_active ? vlsu_mem_addr : dmem_req_addr_reg;
-  assign dmem_req_wdata = vec_mem_active ? vlsu_mem_wdata : dmem_req_wdata_reg;
-  assign dmem_req_wmask = vec_mem_active ? vlsu_mem_wmask : dmem_req_wmask_reg;
-  assign dmem_resp_ready = 1'b1;
+  // memory interface, mux between scalar, write buffer and vector access
+  // (vector requests come through the prefetcher)
+  assign vec_mem_active = vm_busy && !vm_tcm;
 
-  // new vector register file write logic
-  assign vrf_wen = (cpu_state == STATE_WB) && vec_reg_write_reg;
-  assign vrf_wdata = vec_result_reg;
+  assign dmem_req_valid = vec_mem_active ? vpf_mem_valid : (dmem_req_valid_reg || wbuf_drain_grant);
+  assign dmem_req_write = vec_mem_active ? vpf_mem_write : wbuf_drain_grant ? 1'b1 : dmem_req_write_reg;
+  assign dmem_req_addr  = vec_mem_active ? vpf_mem_addr : wbuf_drain_grant ? wbuf_drain_addr : dmem_req_addr_reg;
+  assign dmem_req_wdata = vec_mem_active ? vpf_mem_wdata : wbuf_drain_grant ? wbuf_drain_wdata : dmem_req_wdata_reg;
+  assign dmem_req_wmask = vec_mem_active ? vpf_mem_wmask : wbuf_drain_grant ? wbuf_drain_wmask : dmem_req_wmask_reg;
+  assign dmem_resp_ready = 1'b1;
+  assign dmem_req_vector = vec_mem_active;
+
+  // issue: the head goes to its unit once the unit is free and no older op
+  // still writes one of its registers (operands are read at issue, so no WAR)
+  wire vq_h_mem = vq_h_load || vq_h_store;
+  wire vq_h_waw = vq_h_vwrite && vsb[vq_h_vd];
+  // the vs2 field of a .vx op, VNCLIP, a VMOV, a reduction or VREDACC is not
+  // a vector register, neither is the vs1 field of VREDACC or VNCLIP.ACC
+  wire vq_h_vs2_vec = !vq_h_vx && (vq_h_op[3:1] != 3'b011) && (vq_h_op[3:2] != 2'b11) &&
+                      (vq_h_op != 4'b0101);
+  wire vq_h_vs1_vec = (vq_h_op != 4'b0101) && (vq_h_op[3:1] != 3'b100);
+  // VLD over a buffered store, or VST to MMIO behind buffered stores: wait
+  // for the write buffer to drain first; a strided/indexed VLD can touch any
+  // line, so it waits for an empty buffer
+  wire vq_mem_order = vq_h_tcm ? 1'b1 :
+                      (vq_h_load && vq_h_mode != 2'b00) ? wbuf_empty :
+                      vq_h_load ? !wbuf_line_match :
+                      vst_buffered ? wbuf_can_push_vec : wbuf_empty;
+  wire vx_issue_alu = vq_head_valid && !vq_h_mem && valu_in_ready && va_can_push &&
+                      !(vq_h_vs1_vec && vsb[vq_h_vs1]) && !(vq_h_vs2_vec && vsb[vq_h_vs2]) && !vq_h_waw;
+  wire vx_issue_mem = vq_head_valid && vq_h_mem && !vm_busy &&
+                      !((vq_h_store || vq_h_mode == 2'b10) && vsb[vq_h_vs2]) && !vq_h_waw && vq_mem_order;
+  wire vx_pop = vx_issue_alu || vx_issue_mem;
+  assign vq_pop = vx_pop;
+  // a VST into the write buffer is done at issue, all words in one cycle
+  assign wbuf_push_vst = vx_issue_mem && vst_buffered;
+
+  assign va_issue = vx_issue_alu;
+
+  wire vx_idle = !vq_head_valid && va_empty && !vm_busy;
+
+  // completion: the bus goes back to the scalar side only once no prefetch
+  // responses are in flight; TCM read data arrives the cycle after the request
+  wire vm_ready = vm_busy && vm_done_seen && (vm_tcm || vpf_idle);
+  wire vm_wb = vm_ready && vm_load;
+  // a VALU result that cannot be written yet stalls the VALU pipeline
+  wire va_wb = valu_valid_out && va_vwrite && !vm_wb;
+  assign vx_wen = valu_valid_out && va_vmac && !wb_enable;
+  assign va_fin = valu_valid_out && (!va_vwrite || !vm_wb) && (!va_vmac || vx_wen);
+
+  // a masked VLD writes 0 into its inactive elements
+  wire [VLEN-1:0] vm_keep;
+  genvar vb;
+  generate
+    for (vb = 0; vb < VLEN / 8; vb = vb + 1) begin: gen_vm_keep
+      assign vm_keep[vb*8 +: 8] = {8{vm_bmask[vb]}};
+    end
+  endgenerate
+
+  // new vector register file write logic, memory side first
+  assign vrf_wen = vm_wb || va_wb;
+  assign vrf_waddr = vm_wb ? vm_vd : va_vd;
+  assign vrf_wdata = vm_wb ? ((vm_tcm ? vtcm_rdata : vm_result) & vm_keep) : valu_result;
+
+  assign vq_push = (cpu_state == STATE_EXEC) && is_vec_op_reg && vq_can_push &&
+                   (VDECOUPLE_EN != 0 || (!vec_busy && vx_idle));
+
+  wire [31:0] vsb_set = (vx_pop && vq_h_vwrite && vq_h_vd != 5'd0) ? (32'd1 << vq_h_vd) : 32'd0;
+  wire [31:0] vsb_clr = (vm_wb ? (32'd1 << vm_vd) : 32'd0) |
+                        ((va_fin && va_vwrite) ? (32'd1 << va_vd) : 32'd0);
+  wire [31:0] xsb_set = (vq_push && is_vec_vmac_reg && rd_reg != 5'd0) ? (32'd1 << rd_reg) : 32'd0;
+  wire [31:0] xsb_clr = vx_wen ? (32'd1 << va_vd) : 32'd0;
+
+  // DECODE waits while a source or the destination is the rd of a VMAC.B
+  // still in the back-end
+  wire [6:0] dec_opcode = insn_reg[6:0];
+  wire dec_uses_rs1 = !dec_is_jal && (!dec_is_vec_op || dec_is_vec_load || dec_is_vec_store ||
+                                       dec_vec_op == 4'b0110) && // VMOV_S2V source
+                      !(dec_is_csr && dec_csr_op[2]);
+  wire dec_uses_rs2 = (dec_opcode == 7'b0110011) || (dec_opcode == 7'b0100011) ||
+                      (dec_opcode == 7'b1100011) || dec_is_vmac ||
+                      (dec_vec_base_write && !dec_alu_src2_sel) || // VLD.PR increment
+                      (dec_vec_ld_mode == 2'b01) ||                // VLDS stride
+                      dec_vec_vx ||                                // .vx scalar
+                      dec_is_vsetl;                               // VSETL vtype
+  wire xsb_stall = (dec_uses_rs1 && xsb[dec_rs1]) || (dec_uses_rs2 && xsb[dec_rs2]) ||
+                   (dec_reg_write && xsb[dec_rd]);
 
-  // Instruction memory interface
-  assign imem_addr = pc_reg;
+  always @(posedge clk) begin
+    if (!resetn) begin
+      vsb <= 32'd0;
+      xsb <= 32'd0;
+      vq_mem_cnt <= 3'd0;
+      vm_busy <= 1'b0;
+      vm_start <= 1'b0;
+      vm_done_seen <= 1'b0;
+    end else begin
+      vm_start <= 1'b0;
+      vsb <= (vsb & ~vsb_clr) | vsb_set;
+      xsb <= (xsb & ~xsb_clr) | xsb_set;
+      vq_mem_cnt <= vq_mem_cnt + {2'd0, vq_push && (is_vec_load_reg || is_vec_store_reg)}
+                               - {2'd0, vx_pop && vq_h_mem};
+
+      if (vx_issue_mem && !vst_buffered) begin
+        vm_busy <= 1'b1;
+        vm_start <= 1'b1;
+        vm_load <= vq_h_load;
+        vm_store <= vq_h_store;
+        vm_tcm <= vq_h_tcm;
+        vm_mode <= vq_h_mode;
+        vm_sew <= vq_h_sew;
+        vm_stride <= vq_h_stride;
+        vm_bmask <= vq_h_bmask;
+        vm_addr <= vq_h_base;
+        vm_pc <= vq_h_pc;
+        vm_data <= vrf_rdata2;
+        vm_vd <= vq_h_vd;
+      end
+      if ((vm_start && vm_tcm) || vlsu_done) begin
+        vm_done_seen <= 1'b1;
+      end
+      if (vlsu_done) begin
+        vm_result <= vlsu_load_data;
+      end
+      if (vm_ready) begin
+        vm_busy <= 1'b0;
+        vm_done_seen <= 1'b0;
+      end
+    end
+  end
 
   // Branch/Jump logic
   wire branch_condition;
@@ -392,17 +809,18 @@ module ucrv32 (
      mem_mask_reg == 32'h0000FFFF ? {16'h0, mem_half} :
      mem_data_reg);
 
+  // sequential PC, +2 after a compressed instruction
   wire [31:0] pc_plus_4;
-  ripple_carry_adder_32 pc_plus_4_adder (
+  adder_32 #(.ARCH(PC_ADDER)) pc_plus_4_adder (
     .a(pc_saved),
-    .b(32'd4),
+    .b(is_rvc_reg ? 32'd2 : 32'd4),
     .cin(1'b0),
     .sum(pc_plus_4),
     .cout()
   );
 
   wire [31:0] pc_plus_imm;
-  ripple_carry_adder_32 branch_target_adder (
+  adder_32 #(.ARCH(PC_ADDER)) branch_target_adder (
     .a(pc_saved),
     .b(imm_reg),
     .cin(1'b0),
@@ -410,15 +828,111 @@ module ucrv32 (
     .cout()
   );
 
+  // sequential next PC, back to the loop start at the end of a hardware loop body
+  wire lp_wrap = (pc_saved == lp_end) && (lp_count > 32'd1);
+  wire [31:0] pc_next = lp_wrap ? lp_start : pc_plus_4;
+
   assign wb_data = (is_jal_reg || is_jalr_reg) ? pc_plus_4 :
                    wb_from_mem_reg ? mem_data_extended :
                    is_vmac_reg ? alu_out_reg :  // VMAC result stored in alu_out_reg
+                   is_muldiv_reg ? alu_out_reg :  // MUL/DIV result
                    is_rdwrctr_reg ? alu_out_reg :  // RDWRCTR result
-                   is_vec_vmac_reg ? alu_out_reg :  // VMAC.B (wide vec) result
+                   is_csr_reg ? alu_out_reg :  // CSR old value
                    alu_out_reg;
 
-  assign wb_enable = (cpu_state == STATE_WB) && reg_write_reg;
+  // VMAC.B writes rd later, from the vector back-end (vx_wen); a post-increment
+  // VLD/VST writes its new base here, the queue entry already has the old one
+  assign wb_enable = (cpu_state == STATE_WB) && reg_write_reg && (!is_vec_op_reg || vec_base_write_reg);
   assign ebreak_hit = ebreak_hit_reg && (cpu_state == STATE_WB);
+  assign retire = (cpu_state == STATE_WB);
+
+  // CSR access in EXEC, the old value goes to rd through alu_out_reg.
+  // Interrupts are taken in DECODE, before the instruction does anything;
+  // ECALL/MRET redirect from EXEC like a jump.
+  wire irq_take = (cpu_state == STATE_DECODE) && irq_pending;
+  wire ecall_take = (cpu_state == STATE_EXEC) && is_ecall_reg;
+
+  csr_file #(.VLEN(VLEN)) csr_inst(
+    .clk(clk),
+    .resetn(resetn),
+    .addr(imm_reg[11:0]),
+    .op(csr_op_reg[1:0]),
+    .src(csr_op_reg[2] ? {27'd0, insn_reg[19:15]} : rdata1_reg),
+    .src_zero(insn_reg[19:15] == 5'd0),
+    .valid((cpu_state == STATE_EXEC) && is_csr_reg),
+    .rdata(csr_rdata),
+    .vset((cpu_state == STATE_EXEC) && is_vset_reg),
+    .vsetl((cpu_state == STATE_EXEC) && is_vsetl_reg),
+    .vset_len(rdata1_reg),
+    .vsetl_sew(rdata2_reg[1:0]),
+    .vset_grant(vset_grant),
+    .vsew(vec_sew_reg),
+    .vmask_bytes(vmask_bytes),
+    .vtype_sew(vtype_sew),
+    .vl_bytes(vl_bytes),
+    .ev_retire(retire),
+    .ev_vec_retire((cpu_state == STATE_WB) && is_vec_op_reg),
+    .ev_vlsu_busy(vec_mem_active),
+    .ev_mem_stall(cpu_state == STATE_MEM),
+    .ev_branch_taken((cpu_state == STATE_EXEC) && take_branch),
+    .mtime(mtime),
+    .timer_irq(timer_irq),
+    .soft_irq(soft_irq),
+    .irq_pending(irq_pending),
+    .trap_take(irq_take || ecall_take),
+    .trap_ecall(ecall_take),
+    .trap_pc(pc_saved),
+    .trap_vector(trap_vector),
+    .mret((cpu_state == STATE_EXEC) && is_mret_reg),
+    .mepc_out(mepc)
+  );
+
+  //=============================================================================
+  // Instruction fetch
+  //=============================================================================
+  // The prefetch buffer fetches ahead while the instruction executes. In WB (or
+  // FETCH) the head is taken if it is the next PC, otherwise the buffer restarts
+  // there. Taken branches/jumps and hardware loop wraps restart it from EXEC,
+  // so the target is already arriving when the instruction reaches WB.
+  wire ipf_head_valid;
+  wire [31:0] ipf_head_pc;
+  wire [31:0] ipf_head_insn;
+  wire [31:0] ipf_imem_addr;
+
+  wire ipf_next = (cpu_state == STATE_WB) || (cpu_state == STATE_FETCH);
+  wire ipf_hit = (IPREFETCH_EN != 0) && ipf_head_valid && (ipf_head_pc == pc_reg);
+  wire exec_redirect = (cpu_state == STATE_EXEC) && (is_jal_reg || is_jalr_reg || take_branch ||
+                                                    is_ecall_reg || is_mret_reg || lp_wrap);
+  wire [31:0] exec_target = is_ecall_reg ? trap_vector :
+                            is_mret_reg ? mepc :
+                            is_jalr_reg ? {alu_out[31:1], 1'b0} :
+                            (is_jal_reg || take_branch) ? pc_plus_imm : lp_start;
+
+  iprefetch iprefetch_inst(
+    .clk(clk),
+    .rst_n(resetn),
+    .enable(IPREFETCH_EN != 0),
+    .imem_addr(ipf_imem_addr),
+    .imem_rdata(imem_rdata),
+    .flush(exec_redirect || (ipf_next && !ipf_hit)),
+    .flush_pc(exec_redirect ? exec_target : pc_reg),
+    .head_valid(ipf_head_valid),
+    .head_pc(ipf_head_pc),
+    .head_insn(ipf_head_insn),
+    .pop(ipf_next && ipf_hit)
+  );
+
+  assign imem_addr = (IPREFETCH_EN != 0) ? ipf_imem_addr : pc_reg;
+
+  // RVC: the fetched window is expanded to its 32-bit equivalent on the way into
+  // insn_reg, so the decoder and everything after it only see RV32 encodings
+  wire [31:0] fetch_insn;
+  wire fetch_is_rvc;
+  rvc_expand rvc_expand_inst(
+    .insn_in((IPREFETCH_EN != 0) ? ipf_head_insn : imem_rdata),
+    .insn_out(fetch_insn),
+    .is_rvc(fetch_is_rvc)
+  );
 
   //=============================================================================
   // Trace outputs
@@ -448,6 +962,21 @@ module ucrv32 (
       vmac_valid_in_reg <= 1'b0;
       is_vmac_reg <= 1'b0;
       vmac_ctrl_reg <= 2'b00;
+      muldiv_busy <= 1'b0;
+      muldiv_valid_in_reg <= 1'b0;
+      is_muldiv_reg <= 1'b0;
+      muldiv_ctrl_reg <= 3'b000;
+      is_csr_reg <= 1'b0;
+      csr_op_reg <= 3'b000;
+      is_ecall_reg <= 1'b0;
+      is_mret_reg <= 1'b0;
+      trap_refetch <= 1'b0;
+      is_lpsetup_reg <= 1'b0;
+      is_vset_reg <= 1'b0;
+      is_vsetl_reg <= 1'b0;
+      lp_start <= 32'd0;
+      lp_end <= 32'd0;
+      lp_count <= 32'd0;
       
       // 7.6 Performance counter reset
       cycle_counter <= 32'd0;
@@ -456,78 +985,116 @@ module ucrv32 (
       store_counter <= 32'd0;
       is_rdwrctr_reg <= 1'b0;
       rdwrctr_wen_reg <= 1'b0;
-      rdwrctr_ctr_id_reg <= 2'b00;
+      rdwrctr_ctr_id_reg <= 3'b000;
 
       // new vector reset
       is_vec_op_reg <= 1'b0;
-      vec_op_reg <= 3'b000;
+      vec_op_reg <= 4'b0000;
       vec_sew_reg <= 2'b00;
       is_vec_load_reg <= 1'b0;
       is_vec_store_reg <= 1'b0;
       is_vec_vmac_reg <= 1'b0;
+      vec_vx_reg <= 1'b0;
+      vec_base_write_reg <= 1'b0;
+      vec_ld_mode_reg <= 2'b00;
+      vec_masked_reg <= 1'b0;
       vec_reg_write_reg <= 1'b0;
       vd_reg <= 5'd0;
       vec_busy <= 1'b0;
-      vec_valid_in_reg <= 1'b0;
-      vlsu_start_reg <= 1'b0;
-      vs1_data_reg <= 64'd0;
-      vs2_data_reg <= 64'd0;
-      vec_result_reg <= 64'd0;
     end else begin
       // 7.6 Performance counters: always increment cycle counter
       cycle_counter <= cycle_counter + 32'd1;
       case (cpu_state)
         STATE_FETCH: begin
-          insn_reg <= imem_rdata;
-          pc_saved <= pc_reg;  // Save PC for this instruction
-          trace_pc_reg <= pc_reg;
-          trace_insn_reg <= imem_rdata;
-          cpu_state <= STATE_DECODE;
+          if (IPREFETCH_EN == 0 && trap_refetch) begin
+            // imem_addr moved to the trap vector this cycle
+            trap_refetch <= 1'b0;
+            cpu_state <= STATE_FETCH;
+          end else if (IPREFETCH_EN == 0) begin
+            insn_reg <= fetch_insn;
+            is_rvc_reg <= fetch_is_rvc;
+            pc_saved <= pc_reg;  // Save PC for this instruction
+            trace_pc_reg <= pc_reg;
+            trace_insn_reg <= fetch_insn;
+            cpu_state <= STATE_DECODE;
+          end else if (ipf_hit) begin
+            insn_reg <= fetch_insn;
+            is_rvc_reg <= fetch_is_rvc;
+            pc_saved <= pc_reg;
+            trace_pc_reg <= pc_reg;
+            trace_insn_reg <= fetch_insn;
+            cpu_state <= STATE_DECODE;
+          end else begin
+            // prefetch buffer restarted at pc_reg, word arrives next cycle
+            cpu_state <= STATE_FETCH;
+          end
         end
 
         STATE_DECODE: begin
-          // Decode instruction and read registers
-          rd_reg <= dec_rd;
-          rdata1_reg <= rf_rdata1;
-          rdata2_reg <= rf_rdata2;
-          imm_reg <= dec_imm;
-          alu_ctrl_reg <= dec_alu_ctrl;
-          alu_src2_sel_reg <= dec_alu_src2_sel;
-          mem_write_reg <= dec_mem_write;
-          mem_read_reg <= dec_mem_read;
-          wb_from_mem_reg <= dec_wb_from_mem;
-          mem_mask_reg <= dec_mem_mask;
-          mem_sign_extend_reg <= dec_mem_sign_extend;
-          is_branch_reg <= dec_is_branch;
-          branch_if_set_reg <= dec_branch_if_set;
-          is_branch_compare_reg <= dec_is_branch_compare;
-          is_jal_reg <= dec_is_jal;
-          is_jalr_reg <= dec_is_jalr;
-          is_auipc_reg <= dec_is_auipc;
-          reg_write_reg <= dec_reg_write;
-          ebreak_hit_reg <= dec_ebreak_hit;
-          // 7.3 VMAC control signals
-          is_vmac_reg <= dec_is_vmac;
-          vmac_ctrl_reg <= dec_vmac_ctrl;
-
-          // 7.6 Performance counter control signals
-          is_rdwrctr_reg <= dec_is_rdwrctr;
-          rdwrctr_wen_reg <= dec_rdwrctr_wen;
-          rdwrctr_ctr_id_reg <= dec_rdwrctr_ctr_id;
-
-          // new vector control signals
-          is_vec_op_reg <= dec_is_vec_op;
-          vec_op_reg <= dec_vec_op;
-          vec_sew_reg <= dec_vec_sew;
-          is_vec_load_reg <= dec_is_vec_load;
-          is_vec_store_reg <= dec_is_vec_store;
-          is_vec_vmac_reg <= dec_is_vec_vmac;
-          vec_reg_write_reg <= dec_vec_reg_write;
-          vd_reg <= dec_rd;
-          vs1_data_reg <= vrf_rdata1; // read vector operands
-          vs2_data_reg <= vrf_rdata2;
-
-          cpu_state <= STATE_EXEC;
+          if (irq_take) begin
+            // interrupt: the instruction in insn_reg is not executed, mepc = its PC
+            pc_reg <= trap_vector;
+            trap_refetch <= 1'b1;
+            cpu_state <= STATE_FETCH;
+          end else if (xsb_stall) begin
+            // operand still being computed by a VMAC.B in the vector back-end
+            cpu_state <= STATE_DECODE;
+          end else begin
+            // Decode instruction and read registers
+            // a post-increment VLD/VST writes its base register, rd is the vector register
+            rd_reg <= dec_vec_base_write ? dec_rs1 : dec_rd;
+            rdata1_reg <= rf_rdata1;
+            rdata2_reg <= rf_rdata2;
+            imm_reg <= dec_imm;
+            alu_ctrl_reg <= dec_alu_ctrl;
+            alu_src2_sel_reg <= dec_alu_src2_sel;
+            mem_write_reg <= dec_mem_write;
+            mem_read_reg <= dec_mem_read;
+            wb_from_mem_reg <= dec_wb_from_mem;
+            mem_mask_reg <= dec_mem_mask;
+            mem_sign_extend_reg <= dec_mem_sign_extend;
+            is_branch_reg <= dec_is_branch;
+            branch_if_set_reg <= dec_branch_if_set;
+            is_branch_compare_reg <= dec_is_branch_compare;
+            is_jal_reg <= dec_is_jal;
+            is_jalr_reg <= dec_is_jalr;
+            is_auipc_reg <= dec_is_auipc;
+            reg_write_reg <= dec_reg_write || dec_vec_base_write;
+            ebreak_hit_reg <= dec_ebreak_hit;
+            // 7.3 VMAC control signals
+            is_vmac_reg <= dec_is_vmac;
+            vmac_ctrl_reg <= dec_vmac_ctrl;
+            is_muldiv_reg <= dec_is_muldiv;
+            muldiv_ctrl_reg <= dec_muldiv_ctrl;
+            is_csr_reg <= dec_is_csr;
+            csr_op_reg <= dec_csr_op;
+            is_ecall_reg <= dec_is_ecall;
+            is_mret_reg <= dec_is_mret;
+            is_lpsetup_reg <= dec_is_lpsetup;
+            is_vset_reg <= dec_is_vset;
+            is_vsetl_reg <= dec_is_vsetl;
+
+            // 7.6 Performance counter control signals
+            is_rdwrctr_reg <= dec_is_rdwrctr;
+            rdwrctr_wen_reg <= dec_rdwrctr_wen;
+            rdwrctr_ctr_id_reg <= dec_rdwrctr_ctr_id;
+
+            // new vector control signals
+            is_vec_op_reg <= dec_is_vec_op;
+            vec_op_reg <= dec_vec_op;
+            vec_sew_reg <= (dec_vec_sew == 2'b11) ? vtype_sew : dec_vec_sew; // 11: SEW of the last VSETL
+            is_vec_load_reg <= dec_is_vec_load;
+            is_vec_store_reg <= dec_is_vec_store;
+            is_vec_vmac_reg <= dec_is_vec_vmac;
+            vec_vx_reg <= dec_vec_vx;
+            vec_base_write_reg <= dec_vec_base_write;
+            vec_ld_mode_reg <= dec_vec_ld_mode;
+            vec_masked_reg <= dec_vec_masked;
+            vec_reg_write_reg <= dec_vec_reg_write;
+            vd_reg <= dec_rd;
+
+            cpu_state <= STATE_EXEC;
+          end
         end
 
         STATE_EXEC: begin
@@ -538,68 +1105,74 @@ module ucrv32 (
             if (rdwrctr_wen_reg) begin
               // Write rs1 to selected counter
               case (rdwrctr_ctr_id_reg)
-                2'b00: cycle_counter <= rdata1_reg;
-                2'b01: insn_counter <= rdata1_reg;
-                2'b10: load_counter <= rdata1_reg;
-                2'b11: store_counter <= rdata1_reg;
+                3'b000: cycle_counter <= rdata1_reg;
+                3'b001: insn_counter <= rdata1_reg;
+                3'b010: load_counter <= rdata1_reg;
+                3'b011: store_counter <= rdata1_reg;
+                default: ; // prefetch counters are read-only
               endcase
             end else begin
               // Read selected counter to rd
               case (rdwrctr_ctr_id_reg)
-                2'b00: alu_out_reg <= cycle_counter;
-                2'b01: alu_out_reg <= insn_counter;
-                2'b10: alu_out_reg <= load_counter;
-                2'b11: alu_out_reg <= store_counter;
+                3'b000: alu_out_reg <= cycle_counter;
+                3'b001: alu_out_reg <= insn_counter;
+                3'b010: alu_out_reg <= load_counter;
+                3'b011: alu_out_reg <= store_counter;
+                3'b100: alu_out_reg <= vpf_useful_count;
+                3'b101: alu_out_reg <= vpf_useless_count;
                 default: alu_out_reg <= 32'h0;
               endcase
             end
-            pc_reg <= pc_plus_4;
+            pc_reg <= pc_next;
             cpu_state <= STATE_WB;
 
-          // new vector operation
-          end else if (is_vec_op_reg) begin
-            if (!vec_busy) begin
-              // start vector operation
-              vec_busy <= 1'b1;
-              if (is_vec_load_reg || is_vec_store_reg) begin
-                vlsu_start_reg <= 1'b1;
-              end else begin
-                vec_valid_in_reg <= 1'b1;
-              end
-            end else begin
-              vlsu_start_reg <= 1'b0;
-              vec_valid_in_reg <= 1'b0;
-            end
+          // Zicsr: read-modify-write in one cycle
+          end else if (is_csr_reg) begin
+            alu_out_reg <= csr_rdata;
+            pc_reg <= pc_next;
+            cpu_state <= STATE_WB;
+
+          // VMSETL/VSETL: vmask or vl/vtype of the next strip, its length to rd
+          end else if (is_vset_reg || is_vsetl_reg) begin
+            alu_out_reg <= vset_grant;
+            pc_reg <= pc_next;
+            cpu_state <= STATE_WB;
 
-            // check for completion
-            if (is_vec_load_reg || is_vec_store_reg) begin
-              if (vlsu_done) begin
-                if (is_vec_load_reg) begin
-                  vec_result_reg <= vlsu_load_data;
-                end
-                pc_reg <= pc_plus_4;
-                vec_busy <= 1'b0;
-                vlsu_start_reg <= 1'b0;
+          // hardware loop setup, imm[11:0] = halfwords to the last body instruction
+          end else if (is_lpsetup_reg) begin
+            lp_start <= pc_plus_4;
+            lp_end <= pc_saved + {19'd0, imm_reg[11:0], 1'b0};
+            lp_count <= rdata1_reg;
+            pc_reg <= pc_next;
+            cpu_state <= STATE_WB;
+
+          // ECALL to the trap vector, MRET back to mepc
+          end else if (is_ecall_reg || is_mret_reg) begin
+            pc_reg <= exec_target;
+            cpu_state <= STATE_WB;
+
+          // new vector operation: into the issue queue, the back-end runs it
+          end else if (is_vec_op_reg) begin
+            alu_out_reg <= alu_out; // rs1 + increment for the post-increment forms
+            if (VDECOUPLE_EN != 0) begin
+              if (vq_can_push) begin
+                pc_reg <= pc_next;
                 cpu_state <= STATE_WB;
               end else begin
                 cpu_state <= STATE_EXEC;
               end
-            end else begin
-              // VALU operation (VADD, VSUB, VMUL, VMAC)
-              if (valu_valid_out) begin
-                if (is_vec_vmac_reg) begin
-                  // VMAC.B: result is 32-bit scalar in lower bits
-                  alu_out_reg <= valu_result[31:0];
-                end else begin
-                  vec_result_reg <= valu_result;
-                end
-                pc_reg <= pc_plus_4;
-                vec_busy <= 1'b0;
-                vec_valid_in_reg <= 1'b0;
-                cpu_state <= STATE_WB;
-              end else begin
-                cpu_state <= STATE_EXEC;
+            end else if (!vec_busy) begin
+              // serialized: push into an idle back-end and wait for it
+              if (vx_idle) begin
+                vec_busy <= 1'b1;
               end
+              cpu_state <= STATE_EXEC;
+            end else if (vx_idle) begin
+              vec_busy <= 1'b0;
+              pc_reg <= pc_next;
+              cpu_state <= STATE_WB;
+            end else begin
+              cpu_state <= STATE_EXEC;
             end
           end
           
@@ -613,7 +1186,7 @@ module ucrv32 (
             end
             if (vmac_valid_out) begin // vmac done
               alu_out_reg <= vmac_result_wire; // get result
-              pc_reg <= pc_plus_4; // next pc
+              pc_reg <= pc_next; // next pc
               vmac_busy <= 1'b0; // clear busy flag
               vmac_valid_in_reg <= 1'b0; // clear valid_in
               cpu_state <= STATE_WB; // go to WB
@@ -622,6 +1195,24 @@ module ucrv32 (
               cpu_state <= STATE_EXEC;
             end
 
+          // M extension
+          end else if (is_muldiv_reg) begin
+            if (!muldiv_busy) begin
+              muldiv_valid_in_reg <= 1'b1;
+              muldiv_busy <= 1'b1;
+            end else begin
+              muldiv_valid_in_reg <= 1'b0;
+            end
+            if (muldiv_valid_out) begin
+              alu_out_reg <= muldiv_result_wire;
+              pc_reg <= pc_next;
+              muldiv_busy <= 1'b0;
+              muldiv_valid_in_reg <= 1'b0;
+              cpu_state <= STATE_WB;
+            end else begin
+              cpu_state <= STATE_EXEC;
+            end
+
           end else begin
             // Execute ALU operation and determine branches
             alu_out_reg <= alu_out;
@@ -634,33 +1225,43 @@ module ucrv32 (
               pc_reg <= pc_plus_imm;
             end else if (!mem_read_reg && !mem_write_reg) begin
               // No memory operation, go directly to WB
-              pc_reg <= pc_plus_4;
+              pc_reg <= pc_next;
             end
 
             // Set up memory request if needed
-            if (mem_read_reg || mem_write_reg) begin
+            if (ebreak_hit_reg && (!wbuf_empty || !vx_idle)) begin
+              // let queued vector ops and buffered stores reach memory before
+              // the simulation stops
+              cpu_state <= STATE_EXEC;
+            end else if ((mem_read_reg || mem_write_reg) && vmem_pending) begin
+              // memory order with older VLD/VSTs still in the back-end
+              cpu_state <= STATE_EXEC;
+            end else if (st_buffered) begin
+              // store retires into the write buffer, no STATE_MEM
+              if (wbuf_can_push) begin
+                pc_reg <= pc_next;
+                store_counter <= store_counter + 32'd1;
+                cpu_state <= STATE_WB;
+              end else begin
+                cpu_state <= STATE_EXEC;
+              end
+            end else if (ld_forward) begin
+              // load-after-store: bytes come straight from the write buffer
+              mem_data_reg <= wbuf_fwd_data;
+              pc_reg <= pc_next;
+              load_counter <= load_counter + 32'd1;
+              cpu_state <= STATE_WB;
+            end else if (mem_wait_wbuf) begin
+              cpu_state <= STATE_EXEC;
+            end else if (mem_read_reg || mem_write_reg) begin
               dmem_req_valid_reg <= 1'b1;
               dmem_req_write_reg <= mem_write_reg;
               dmem_req_addr_reg <= alu_out;
 
               // Prepare write data with proper alignment
               if (mem_write_reg) begin
-
-                if (mem_mask_reg == 32'h000000FF) begin
-                  // Byte store
-                  dmem_req_wdata_reg <= {4{rdata2_reg[7:0]}};
-                  dmem_req_wmask_reg <= (alu_out[1:0] == 2'b00) ? 4'b0001 :
-                                        (alu_out[1:0] == 2'b01) ? 4'b0010 :
-                                        (alu_out[1:0] == 2'b10) ? 4'b0100 : 4'b1000;
-                end else if (mem_mask_reg == 32'h0000FFFF) begin
-                  // Halfword store
-                  dmem_req_wdata_reg <= {2{rdata2_reg[15:0]}};
-                  dmem_req_wmask_reg <= alu_out[1] ? 4'b1100 : 4'b0011;
-                end else begin
-                  // Word store
-                  dmem_req_wdata_reg <= rdata2_reg;
-                  dmem_req_wmask_reg <= 4'b1111;
-                end
+                dmem_req_wdata_reg <= st_wdata;
+                dmem_req_wmask_reg <= mem_bmask;
               end
               cpu_state <= STATE_MEM;
             end else begin
@@ -675,7 +1276,7 @@ module ucrv32 (
             dmem_req_valid_reg <= 1'b0;
             if (!mem_read_reg) begin
               // Store completes when request is accepted
-              pc_reg <= pc_plus_4;
+              pc_reg <= pc_next;
               cpu_state <= STATE_WB;
               // 7.6 Performance counter: increment store counter
               store_counter <= store_counter + 32'd1;
@@ -685,7 +1286,7 @@ module ucrv32 (
             // Waiting for load response
             if (dmem_resp_valid) begin
               mem_data_reg <= dmem_resp_rdata;
-              pc_reg <= pc_plus_4;
+              pc_reg <= pc_next;
               cpu_state <= STATE_WB;
               // 7.6 Performance counter: increment load counter
               load_counter <= load_counter + 32'd1;
@@ -700,8 +1301,20 @@ module ucrv32 (
             $display("[RDWRCTR_WB] rd=x%0d, wb_data=%d, alu_out=%d", rd_reg, wb_data, alu_out_reg);
           end
           reg_write_reg <= 1'b0;
-          vec_reg_write_reg <= 1'b0;
-          cpu_state <= STATE_FETCH;
+          if (pc_saved == lp_end && lp_count != 32'd0) begin
+            lp_count <= lp_count - 32'd1;
+          end
+          if (ipf_hit) begin
+            // next instruction already prefetched, skip STATE_FETCH
+            insn_reg <= fetch_insn;
+            is_rvc_reg <= fetch_is_rvc;
+            pc_saved <= pc_reg;
+            trace_pc_reg <= pc_reg;
+            trace_insn_reg <= fetch_insn;
+            cpu_state <= STATE_DECODE;
+          end else begin
+            cpu_state <= STATE_FETCH;
+          end
           // 7.6 Performance counter: increment instruction counter
           insn_counter <= insn_counter + 32'd1;
         end
@@ -713,6 +1326,7 @@ module ucrv32 (
     end
   end
 
+`ifndef SYNTHESIS
   // File handle for instruction trace
   integer trace_file;
 
@@ -722,7 +1336,7 @@ module ucrv32 (
 
   always @ (posedge clk) begin
     if (resetn && cpu_state == STATE_WB) begin
-      if(reg_write_reg) begin
+      if(wb_enable) begin
         $fwrite(trace_file, "WB: PC=%08x INSN=%08x x%0d <= %08x\n",
                 trace_pc_reg, trace_insn_reg, rd_reg, wb_data);
         $fflush(trace_file);
@@ -733,6 +1347,7 @@ module ucrv32 (
       end
     end
   end
+`endif
 
 
 endmodule
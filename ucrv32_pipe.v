@@ -0,0 +1,963 @@
+// Five-stage pipelined variant of ucrv32 (IF/ID/EX/MEM/WB)
+// Same ports and ISA as the FSM core, selected in top.v with PIPELINE=1.
+//
+// IF : imem_addr is the next fetch address, the SRAM returns the word one
+//      cycle later, so the instruction is decoded in ID from imem_rdata;
+//      the next PC comes from the branch predictor (BTB, bimodal counters, RAS)
+// ID : decode, register file read (with WB bypass), load-use interlock
+// EX : ALU, branch/jump resolution (1 bubble on a misprediction),
+//      scalar load/store request, CSR read-modify-write,
+//      multi-cycle units (vmac, muldiv, valu, vlsu, TCM)
+//      hold EX and everything behind it until they finish
+// MEM: waits for the load response
+// WB : scalar/vector register write, retire
+//
+// Forwarding: EX takes operands from MEM and WB; a load result is only known
+// in WB, so an instruction that needs it right behind the load waits one cycle.
+// Stores are issued from EX, so they never stall MEM. The write buffer is not
+// used by this core.
+//
+// Post-increment VLD/VST: the new base (ALU result) goes to rs1 through the
+// scalar write port in the same WB as the vector register write, so the vector
+// destination is carried separately (e_vd/m_vd/w_vd).
+//
+// Traps: ECALL and MRET redirect from EX like a mispredicted jump. A pending
+// interrupt replaces the instruction in ID with a NOP marker; when the marker
+// leaves EX everything older has left EX too, so the trap is precise.
+//
+// RVC: the 32-bit window at the PC (halfword aligned, see sram.v) is expanded
+// in ID; the sequential PC in IF and EX advances by 2 after a compressed one.
+//
+// Hardware loops: lp.setup writes lp_start/lp_end/lp_count in EX. IF predicts
+// lp_start after lp_end while lp_count > 1, EX checks it against the count
+// (which only moves in EX) like a branch prediction.
+
+module ucrv32_pipe #(
+  parameter VPREFETCH_EN = 1, // stride prefetcher in front of vlsu (0 = pass-through)
+  parameter BPRED_EN = 1,     // BTB/bimodal/RAS prediction in IF (0 = always not-taken)
+  parameter ALU_ADDER = 0,    // adder_32 ARCH for the ALU: 0 ripple, 1 CLA, 2 Kogge-Stone, 3 behavioral
+  parameter PC_ADDER = 0,     // adder_32 ARCH for the PC+4 / branch target adders
+  parameter VALU_MULS = 4,    // VALU lane multipliers: 4, 8 or 16
+  parameter VLEN = 64         // vector register width: 64, 128 or 256
+) (
+  // reset and clock
+  input clk, resetn,
+
+  // imem interface
+  output [31:0] imem_addr,
+  input [31:0] imem_rdata,
+
+  // dmem interface
+  output wire [31:0] dmem_req_addr,
+  output wire [31:0] dmem_req_wdata,
+  output wire [3:0]  dmem_req_wmask,
+  output wire        dmem_req_write,
+  output wire        dmem_req_valid,
+  input  wire        dmem_req_ready,
+
+  input              dmem_resp_valid,
+  output wire        dmem_resp_ready,
+  input       [31:0] dmem_resp_rdata,
+  output wire        dmem_req_vector, // request issued by the vector unit
+
+  output wire ebreak_hit,
+  output wire retire, // one instruction leaves WB this cycle
+
+  // writes by other bus masters (DMA), keep the prefetch buffer coherent
+  input              ext_write_valid,
+  input       [31:0] ext_write_addr,
+
+  // CLINT
+  input       [63:0] mtime,
+  input              timer_irq,
+  input              soft_irq,
+
+  // vector scratchpad (TCM) port, VLEN bits, read data on the next cycle
+  output wire [31:0] vtcm_addr,
+  output wire [VLEN-1:0] vtcm_wdata,
+  output wire        vtcm_write,
+  output wire        vtcm_valid,
+  input       [VLEN-1:0] vtcm_rdata,
+
+  // trace outputs
+  output [31:0] trace_pc,
+  output [31:0] trace_insn
+);
+
+  //=============================================================================
+  // Pipeline registers
+  //=============================================================================
+
+  // IF
+  reg [31:0] f_pc;    // address presented last cycle, its word is in imem_rdata
+  reg        d_valid; // imem_rdata holds a valid instruction
+
+  // ID -> EX
+  reg        e_valid;
+  reg [31:0] e_pc;
+  reg [31:0] e_insn;
+  reg        e_is_rvc;
+  reg [4:0]  e_rd, e_rs1, e_rs2;
+  reg [4:0]  e_vd; // vector destination, e_rd is rs1 for a post-increment VLD/VST
+  reg [4:0]  e_vs1; // vector source 1, vd for VMOV_S2V (whose rs1 is the scalar)
+  reg [31:0] e_rs1_val, e_rs2_val;
+  reg [31:0] e_imm;
+  reg [3:0]  e_alu_ctrl;
+  reg        e_alu_src2_sel;
+  reg        e_mem_write, e_mem_read;
+  reg [31:0] e_mem_mask;
+  reg        e_mem_sign_extend;
+  reg        e_is_branch, e_branch_if_set, e_is_branch_compare;
+  reg        e_is_jal, e_is_jalr, e_is_auipc;
+  reg        e_reg_write;
+  reg        e_ebreak;
+  reg        e_is_vmac;
+  reg [1:0]  e_vmac_ctrl;
+  reg        e_is_muldiv;
+  reg [2:0]  e_muldiv_ctrl;
+  reg        e_is_csr;
+  reg [2:0]  e_csr_op;
+  reg        e_is_ecall, e_is_mret;
+  reg        e_is_irq;  // interrupt marker: a NOP standing in for the instruction at e_pc
+  reg        e_is_lpsetup;
+  reg        e_is_vset; // VMSETL
+  reg        e_is_vsetl; // VSETL
+  reg        e_is_rdwrctr, e_rdwrctr_wen;
+  reg [2:0]  e_rdwrctr_ctr_id;
+  reg        e_is_vec_op, e_is_vec_load, e_is_vec_store, e_is_vec_vmac, e_vec_reg_write;
+  reg [3:0]  e_vec_op; // VALU op
+  reg        e_vec_vx; // .vx: vs2 is rs2 broadcast
+  reg [1:0]  e_vec_ld_mode; // VLD unit/strided/indexed
+  reg [1:0]  e_vec_sew; // SEW field, 11 = vtype (e_vsew)
+  reg        e_vec_masked; // active elements from vmask
+  reg [VLEN-1:0] e_vs1_val, e_vs2_val;
+  reg        e_pred_taken;  // IF fetched e_pred_target after this instruction
+  reg [31:0] e_pred_target;
+  reg        e_started; // multi-cycle unit started for the instruction in EX
+  reg        e_done;    // unit finished while EX was held by MEM (valid_out is a pulse)
+
+  // EX -> MEM
+  reg        m_valid;
+  reg [31:0] m_pc, m_insn;
+  reg [4:0]  m_rd;
+  reg        m_reg_write;
+  reg [31:0] m_result;
+  reg        m_mem_read;
+  reg [1:0]  m_addr_lo;
+  reg [31:0] m_mem_mask;
+  reg        m_mem_sign_extend;
+  reg        m_vec_reg_write;
+  reg [4:0]  m_vd;
+  reg [VLEN-1:0] m_vresult;
+  reg        m_ebreak;
+
+  // MEM -> WB
+  reg        w_valid;
+  reg [31:0] w_pc, w_insn;
+  reg [4:0]  w_rd;
+  reg        w_reg_write;
+  reg [31:0] w_result;
+  reg        w_vec_reg_write;
+  reg [4:0]  w_vd;
+  reg [VLEN-1:0] w_vresult;
+  reg        w_ebreak;
+
+  // 7.6 Performance counters (from Lab 5)
+  reg [31:0] cycle_counter;
+  reg [31:0] insn_counter;
+  reg [31:0] load_counter;
+  reg [31:0] store_counter;
+
+  //=============================================================================
+  // ID: decode and register read
+  //=============================================================================
+
+  // a pending interrupt turns the instruction in ID into a NOP marker; EX then
+  // traps with mepc = its PC, so it runs after the handler returns
+  wire irq_pending;
+  wire d_irq = d_valid && irq_pending;
+  wire [31:0] d_insn_exp;
+  wire d_is_rvc;
+  rvc_expand rvc_expand_inst(
+    .insn_in(imem_rdata),
+    .insn_out(d_insn_exp),
+    .is_rvc(d_is_rvc)
+  );
+  wire [31:0] d_insn = d_irq ? 32'h00000013 : d_insn_exp;
+
+  wire [4:0]  dec_rd;
+  wire [4:0]  dec_rs1;
+  wire [4:0]  dec_rs2;
+  wire [31:0] dec_imm;
+  wire [3:0]  dec_alu_ctrl;
+  wire        dec_alu_src2_sel;
+  wire        dec_mem_write;
+  wire        dec_mem_read;
+  wire [31:0] dec_mem_mask;
+  wire        dec_mem_sign_extend;
+  wire        dec_is_branch;
+  wire        dec_branch_if_set;
+  wire        dec_is_branch_compare;
+  wire        dec_is_jal;
+  wire        dec_is_jalr;
+  wire        dec_is_auipc;
+  wire        dec_reg_write;
+  wire        dec_ebreak_hit;
+  wire        dec_is_vmac;
+  wire [1:0]  dec_vmac_ctrl;
+  wire        dec_is_rdwrctr;
+  wire        dec_rdwrctr_wen;
+  wire [2:0]  dec_rdwrctr_ctr_id;
+  wire        dec_is_vec_op;
+  wire [3:0]  dec_vec_op;
+  wire [1:0]  dec_vec_sew;
+  wire        dec_is_vec_load;
+  wire        dec_is_vec_store;
+  wire        dec_vec_reg_write;
+  wire        dec_is_vec_vmac;
+  wire        dec_vec_vx;
+  wire        dec_vec_base_write;
+  wire [1:0]  dec_vec_ld_mode;
+  wire        dec_vec_masked;
+  wire        dec_is_vset;
+  wire        dec_is_vsetl;
+  wire        dec_is_muldiv;
+  wire [2:0]  dec_muldiv_ctrl;
+  wire        dec_is_csr;
+  wire [2:0]  dec_csr_op;
+  wire        dec_is_ecall;
+  wire        dec_is_mret;
+  wire        dec_is_lpsetup;
+
+  decoder_control #(.VLEN(VLEN)) decoder_control_inst(
+    .insn(d_insn),
+    .rd(dec_rd),
+    .rs1(dec_rs1),
+    .rs2(dec_rs2),
+    .imm(dec_imm),
+    .alu_ctrl(dec_alu_ctrl),
+    .alu_src2_sel(dec_alu_src2_sel),
+    .mem_write(dec_mem_write),
+    .mem_read(dec_mem_read),
+    .wb_from_mem(),
+    .mem_mask(dec_mem_mask),
+    .mem_sign_extend(dec_mem_sign_extend),
+    .is_branch(dec_is_branch),
+    .branch_if_set(dec_branch_if_set),
+    .is_branch_compare(dec_is_branch_compare),
+    .is_jal(dec_is_jal),
+    .is_jalr(dec_is_jalr),
+    .is_auipc(dec_is_auipc),
+    .is_lui(),
+    .reg_write(dec_reg_write),
+    .ebreak_hit(dec_ebreak_hit),
+    .is_vmac(dec_is_vmac),
+    .vmac_ctrl(dec_vmac_ctrl),
+    .is_rdwrctr(dec_is_rdwrctr),
+    .rdwrctr_wen(dec_rdwrctr_wen),
+    .rdwrctr_ctr_id(dec_rdwrctr_ctr_id),
+    .is_vec_op(dec_is_vec_op),
+    .vec_op(dec_vec_op),
+    .vec_sew(dec_vec_sew),
+    .is_vec_load(dec_is_vec_load),
+    .is_vec_store(dec_is_vec_store),
+    .vec_reg_write(dec_vec_reg_write),
+    .is_vec_vmac(dec_is_vec_vmac),
+    .vec_vx(dec_vec_vx),
+    .vec_base_write(dec_vec_base_write),
+    .vec_ld_mode(dec_vec_ld_mode),
+    .vec_masked(dec_vec_masked),
+    .is_vset(dec_is_vset),
+    .is_vsetl(dec_is_vsetl),
+    .is_muldiv(dec_is_muldiv),
+    .muldiv_ctrl(dec_muldiv_ctrl),
+    .is_csr(dec_is_csr),
+    .csr_op(dec_csr_op),
+    .is_ecall(dec_is_ecall),
+    .is_mret(dec_is_mret),
+    .is_lpsetup(dec_is_lpsetup)
+  );
+
+  wire [31:0] rf_rdata1, rf_rdata2;
+  register_file regfile(
+    .clk(clk),
+    .wen(w_valid && w_reg_write),
+    .rs1(dec_rs1),
+    .rs2(dec_rs2),
+    .waddr(w_rd),
+    .wdata(w_result),
+    .rdata1(rf_rdata1),
+    .rdata2(rf_rdata2)
+  );
+
+  // VMOV_S2V inserts into vd: the old vd is read through the vs1 port
+  wire d_is_s2v = (dec_vec_op == 4'b0110);
+  wire [4:0] d_vs1 = d_is_s2v ? dec_rd : dec_rs1;
+
+  wire [VLEN-1:0] vrf_rdata1, vrf_rdata2;
+  vreg_file #(.VLEN(VLEN)) vreg_file_inst(
+    .clk(clk),
+    .wen(w_valid && w_vec_reg_write),
+    .vs1(d_vs1),
+    .vs2(dec_rs2),
+    .vd(w_vd),
+    .wdata(w_vresult),
+    .rdata1(vrf_rdata1),
+    .rdata2(vrf_rdata2)
+  );
+
+  // WB writes in the same cycle ID reads: bypass
+  wire w_fwd_rs1 = w_valid && w_reg_write && (w_rd != 5'd0) && (w_rd == dec_rs1);
+  wire w_fwd_rs2 = w_valid && w_reg_write && (w_rd != 5'd0) && (w_rd == dec_rs2);
+  wire w_vfwd_vs1 = w_valid && w_vec_reg_write && (w_vd != 5'd0) && (w_vd == d_vs1);
+  wire w_vfwd_vs2 = w_valid && w_vec_reg_write && (w_vd != 5'd0) && (w_vd == dec_rs2);
+
+  wire [31:0] d_rs1_val = w_fwd_rs1 ? w_result : rf_rdata1;
+  wire [31:0] d_rs2_val = w_fwd_rs2 ? w_result : rf_rdata2;
+  wire [VLEN-1:0] d_vs1_val = w_vfwd_vs1 ? w_vresult : vrf_rdata1;
+  wire [VLEN-1:0] d_vs2_val = w_vfwd_vs2 ? w_vresult : vrf_rdata2;
+
+  // which scalar sources the instruction really reads (avoids false interlocks)
+  wire [6:0] d_opcode = d_insn[6:0];
+  wire d_uses_rs1 = !dec_is_jal && (!dec_is_vec_op || dec_is_vec_load || dec_is_vec_store || d_is_s2v);
+  wire d_uses_rs2 = (d_opcode == 7'b0110011) || (d_opcode == 7'b0100011) ||
+                    (d_opcode == 7'b1100011) || dec_is_vmac ||
+                    (dec_vec_base_write && !dec_alu_src2_sel) || // VLD.PR increment
+                    (dec_vec_ld_mode == 2'b01) ||                // VLDS stride
+                    dec_vec_vx ||                                // .vx scalar
+                    dec_is_vsetl;                               // VSETL vtype
+
+  // load-use interlock: the load result is known in WB, the consumer waits one cycle
+  wire load_use = d_valid && e_valid && e_mem_read && (e_rd != 5'd0) &&
+                  ((d_uses_rs1 && e_rd == dec_rs1) || (d_uses_rs2 && e_rd == dec_rs2));
+
+  //=============================================================================
+  // EX: forwarding, ALU, branches, multi-cycle units
+  //=============================================================================
+
+  // forwarding from MEM (not for loads, see load_use) and WB
+  wire m_fwd_ok = m_valid && m_reg_write && !m_mem_read && (m_rd != 5'd0);
+  wire w_fwd_ok = w_valid && w_reg_write && (w_rd != 5'd0);
+  wire [31:0] ex_rs1 = (m_fwd_ok && m_rd == e_rs1) ? m_result :
+                       (w_fwd_ok && w_rd == e_rs1) ? w_result : e_rs1_val;
+  wire [31:0] ex_rs2 = (m_fwd_ok && m_rd == e_rs2) ? m_result :
+                       (w_fwd_ok && w_rd == e_rs2) ? w_result : e_rs2_val;
+
+  wire m_vfwd_ok = m_valid && m_vec_reg_write && (m_vd != 5'd0);
+  wire w_vfwd_ok = w_valid && w_vec_reg_write && (w_vd != 5'd0);
+  wire [VLEN-1:0] ex_vs1 = (m_vfwd_ok && m_vd == e_vs1) ? m_vresult :
+                       (w_vfwd_ok && w_vd == e_vs1) ? w_vresult : e_vs1_val;
+  wire [VLEN-1:0] ex_vs2 = (m_vfwd_ok && m_vd == e_rs2) ? m_vresult :
+                       (w_vfwd_ok && w_vd == e_rs2) ? w_vresult : e_vs2_val;
+
+  // ALU
+  wire [31:0] alu_op1 = e_is_auipc ? e_pc : ex_rs1;
+  wire [31:0] alu_op2 = e_alu_src2_sel ? e_imm : ex_rs2;
+  wire [31:0] alu_out;
+  wire        alu_zero;
+
+  alu #(.ADDER(ALU_ADDER)) alu_inst(
+    .op1(alu_op1),
+    .op2(alu_op2),
+    .alu_ctrl(e_alu_ctrl),
+    .alu_out(alu_out),
+    .zero(alu_zero)
+  );
+
+  // sequential PC / link address, +2 after a compressed instruction
+  wire [31:0] e_pc_plus_4;
+  adder_32 #(.ARCH(PC_ADDER)) pc_plus_4_adder (
+    .a(e_pc),
+    .b(e_is_rvc ? 32'd2 : 32'd4),
+    .cin(1'b0),
+    .sum(e_pc_plus_4),
+    .cout()
+  );
+
+  wire [31:0] e_pc_plus_imm;
+  adder_32 #(.ARCH(PC_ADDER)) branch_target_adder (
+    .a(e_pc),
+    .b(e_imm),
+    .cin(1'b0),
+    .sum(e_pc_plus_imm),
+    .cout()
+  );
+
+  wire branch_condition = e_is_branch_compare ? (alu_out[0] ^ e_branch_if_set) :
+                                                (alu_zero ^ e_branch_if_set);
+  wire take_branch = e_is_branch && branch_condition;
+
+  // 7.3 VMAC
+  wire        vmac_valid_out;
+  wire [31:0] vmac_result_wire;
+
+  vmac vmac_inst (
+    .clk(clk),
+    .rst_n(resetn),
+    .ctrl(e_vmac_ctrl),
+    .a(ex_rs1),
+    .b(ex_rs2),
+    .valid_in(e_valid && e_is_vmac && !e_started),
+    .valid_out(vmac_valid_out),
+    .result(vmac_result_wire)
+  );
+
+  // M extension
+  wire        muldiv_valid_out;
+  wire [31:0] muldiv_result_wire;
+
+  muldiv muldiv_inst (
+    .clk(clk),
+    .rst_n(resetn),
+    .ctrl(e_muldiv_ctrl),
+    .a(ex_rs1),
+    .b(ex_rs2),
+    .valid_in(e_valid && e_is_muldiv && !e_started),
+    .valid_out(muldiv_valid_out),
+    .result(muldiv_result_wire)
+  );
+
+  // vector mask and vl (csr_file): byte enables of the active elements at
+  // e_vsew, the bytes inside vl for an unmasked op. Read in EX, so the op right
+  // after a VSETL/VMSETL already sees the new values.
+  wire [31:0] vset_grant;
+  wire [VLEN/8-1:0] vmask_bytes;
+  wire [1:0]  vtype_sew;
+  wire [VLEN/8-1:0] vl_bytes;
+  wire [1:0]  e_vsew = (e_vec_sew == 2'b11) ? vtype_sew : e_vec_sew;
+  wire [VLEN/8-1:0] e_vbmask = vl_bytes & (e_vec_masked ? vmask_bytes : {(VLEN/8){1'b1}});
+  wire [VLEN-1:0] e_vkeep;
+  genvar vb;
+  generate
+    for (vb = 0; vb < VLEN / 8; vb = vb + 1) begin: gen_e_vkeep
+      assign e_vkeep[vb*8 +: 8] = {8{e_vbmask[vb]}};
+    end
+  endgenerate
+
+  // vector ALU
+  wire e_is_vmem = e_is_vec_load || e_is_vec_store;
+  wire e_is_valu = e_is_vec_op && !e_is_vmem;
+  wire valu_valid_out;
+  wire [VLEN-1:0] valu_result;
+
+  // EX holds until valu_valid_out, so one op is in flight at a time here
+  valu #(.VLEN(VLEN), .NUM_MULS(VALU_MULS)) valu_inst(
+    .clk(clk),
+    .rst_n(resetn),
+    .op(e_vec_op),
+    .sew(e_vsew),
+    .vs1_data(ex_vs1),
+    .vs2_data(ex_vs2),
+    .vx(e_vec_vx),
+    .scalar(e_vec_vx ? ex_rs2 : ex_rs1), // .vx/VNCLIP: rs2, VMOV_S2V: rs1
+    .lane(e_rs2),
+    .vmask(e_vbmask),
+    .valid_in(e_valid && e_is_valu && !e_started),
+    .in_ready(),
+    .valid_out(valu_valid_out),
+    .out_ready(1'b1),
+    .result(valu_result)
+  );
+
+  // vector scratchpad: VLD/VST inside the TCM window use the private port,
+  // strided/indexed VLDs and VSTs with inactive elements (the port has no
+  // byte enables) go through vlsu and the bus
+  wire e_vtcm = e_is_vmem && (ex_rs1[31:16] == 16'h2000) && (e_vec_ld_mode == 2'b00) &&
+                (e_is_vec_load || &e_vbmask);
+  assign vtcm_valid = e_valid && e_vtcm && !e_started;
+  assign vtcm_addr = ex_rs1;
+  assign vtcm_wdata = ex_vs2;
+  assign vtcm_write = e_is_vec_store;
+
+  // vlsu needs the data bus: start only when no scalar load waits in MEM
+  wire e_vlsu = e_is_vmem && !e_vtcm;
+  wire m_bus_busy = m_valid && m_mem_read;
+  wire vlsu_start = e_valid && e_vlsu && !e_started && !m_bus_busy;
+
+  wire vlsu_done;
+  wire [VLEN-1:0] vlsu_load_data;
+  wire [31:0] vlsu_mem_addr;
+  wire [31:0] vlsu_mem_wdata;
+  wire [3:0] vlsu_mem_wmask;
+  wire vlsu_mem_write;
+  wire vlsu_mem_valid;
+  wire vlsu_mem_ready;
+  wire vlsu_mem_resp_valid;
+  wire [31:0] vlsu_mem_resp_rdata;
+  wire vec_mem_active = e_valid && e_vlsu && e_started;
+
+  vlsu #(.VLEN(VLEN)) vlsu_inst(
+    .clk(clk),
+    .rst_n(resetn),
+    .start(vlsu_start),
+    .is_store(e_is_vec_store),
+    .base_addr(ex_rs1),
+    .store_data(ex_vs2),
+    .mode(e_vec_ld_mode),
+    .sew(e_vsew),
+    .stride(ex_rs2),
+    .offsets(ex_vs2),
+    .bmask(e_vbmask),
+    .done(vlsu_done),
+    .load_data(vlsu_load_data),
+    .mem_addr(vlsu_mem_addr),
+    .mem_wdata(vlsu_mem_wdata),
+    .mem_wmask(vlsu_mem_wmask),
+    .mem_write(vlsu_mem_write),
+    .mem_valid(vlsu_mem_valid),
+    .mem_ready(vlsu_mem_ready),
+    .mem_resp_valid(vlsu_mem_resp_valid),
+    .mem_resp_rdata(vlsu_mem_resp_rdata)
+  );
+
+  wire [31:0] vpf_mem_addr;
+  wire [31:0] vpf_mem_wdata;
+  wire [3:0] vpf_mem_wmask;
+  wire vpf_mem_write;
+  wire vpf_mem_valid;
+  wire vpf_idle;
+  wire [31:0] vpf_useful_count;
+  wire [31:0] vpf_useless_count;
+
+  vprefetch #(.VLEN(VLEN)) vprefetch_inst(
+    .clk(clk),
+    .rst_n(resetn),
+    .enable(VPREFETCH_EN != 0 && vec_mem_active),
+    .train_valid(VPREFETCH_EN != 0 && vlsu_start && e_is_vec_load && e_vec_ld_mode == 2'b00),
+    .train_pc(e_pc),
+    .train_addr(ex_rs1),
+    .vlsu_addr(vlsu_mem_addr),
+    .vlsu_wdata(vlsu_mem_wdata),
+    .vlsu_wmask(vlsu_mem_wmask),
+    .vlsu_write(vlsu_mem_write),
+    .vlsu_valid(vlsu_mem_valid),
+    .vlsu_ready(vlsu_mem_ready),
+    .vlsu_resp_valid(vlsu_mem_resp_valid),
+    .vlsu_resp_rdata(vlsu_mem_resp_rdata),
+    .mem_addr(vpf_mem_addr),
+    .mem_wdata(vpf_mem_wdata),
+    .mem_wmask(vpf_mem_wmask),
+    .mem_write(vpf_mem_write),
+    .mem_valid(vpf_mem_valid),
+    .mem_ready(dmem_req_ready),
+    .mem_resp_valid(dmem_resp_valid),
+    .mem_resp_rdata(dmem_resp_rdata),
+    .snoop_write((dmem_req_valid && dmem_req_write && dmem_req_ready) || ext_write_valid),
+    .snoop_addr(ext_write_valid ? ext_write_addr : dmem_req_addr),
+    .idle(vpf_idle),
+    .useful_count(vpf_useful_count),
+    .useless_count(vpf_useless_count)
+  );
+
+  // multi-cycle unit completion, the result registers hold until the next op
+  wire unit_fin = e_started && (e_is_vmac ? vmac_valid_out :
+                                e_is_muldiv ? muldiv_valid_out :
+                                e_is_valu ? valu_valid_out :
+                                e_vtcm    ? 1'b1 :
+                                vlsu_done);
+  wire unit_done = e_done || unit_fin;
+  wire ex_unit_done = (e_vtcm && e_is_vec_store) ? 1'b1 :
+                      e_vlsu ? (unit_done && vpf_idle) : // prefetches drain first
+                      (e_is_vmac || e_is_muldiv || e_is_vmem || e_is_valu) ? unit_done :
+                      1'b1;
+
+  // scalar memory access, issued from EX so the SRAM answers in MEM
+  wire e_scalar_mem = e_valid && (e_mem_read || e_mem_write);
+  wire [31:0] st_wdata = (e_mem_mask == 32'h000000FF) ? {4{ex_rs2[7:0]}} :
+                         (e_mem_mask == 32'h0000FFFF) ? {2{ex_rs2[15:0]}} :
+                         ex_rs2;
+  wire [3:0] st_wmask = (e_mem_mask == 32'h000000FF) ? ((alu_out[1:0] == 2'b00) ? 4'b0001 :
+                                                        (alu_out[1:0] == 2'b01) ? 4'b0010 :
+                                                        (alu_out[1:0] == 2'b10) ? 4'b0100 : 4'b1000) :
+                        (e_mem_mask == 32'h0000FFFF) ? (alu_out[1] ? 4'b1100 : 4'b0011) :
+                        4'b1111;
+
+  //=============================================================================
+  // Stall / flush control
+  //=============================================================================
+
+  wire mem_stall = m_valid && m_mem_read && !dmem_resp_valid;
+  wire ex_busy = e_valid && ((!ex_unit_done) || (e_scalar_mem && !dmem_req_ready));
+  wire ex_advance = !mem_stall && !ex_busy;
+  wire id_advance = ex_advance && !load_use;
+
+  // hardware loop registers (lp.setup), updated when instructions leave EX
+  reg [31:0] lp_start;
+  reg [31:0] lp_end;
+  reg [31:0] lp_count;
+  wire e_lp_end = (e_pc == lp_end) && (lp_count != 32'd0) && !e_is_irq;
+
+  // resolve against the prediction made in IF
+  wire ex_taken = e_is_jal || e_is_jalr || take_branch;
+  wire [31:0] ex_target = e_is_jalr ? {alu_out[31:1], 1'b0} : e_pc_plus_imm;
+  wire e_lp_wrap = e_lp_end && (lp_count > 32'd1) && !ex_taken;
+  wire ex_next_taken = ex_taken || e_lp_wrap;
+  wire [31:0] ex_next_target = ex_taken ? ex_target : lp_start;
+  wire ex_mispredict = (ex_next_taken != e_pred_taken) || (ex_next_taken && ex_next_target != e_pred_target);
+  // traps and MRET always redirect; an interrupt marker whose interrupt was
+  // disabled in the meantime refetches its instruction instead
+  wire [31:0] trap_vector;
+  wire [31:0] mepc;
+  wire e_irq_take = e_is_irq && irq_pending;
+  wire ex_sys_redirect = e_is_irq || e_is_ecall || e_is_mret;
+  wire redirect = e_valid && ex_advance && (ex_mispredict || ex_sys_redirect);
+  wire [31:0] redirect_pc = (e_irq_take || e_is_ecall) ? trap_vector :
+                            e_is_irq ? e_pc :
+                            e_is_mret ? mepc :
+                            ex_next_taken ? ex_next_target : e_pc_plus_4;
+
+  // branch predictor, looked up with the PC of the instruction in ID
+  wire bp_hit_taken;
+  wire [31:0] bp_target;
+  wire [31:0] bp_predict_count;
+  wire [31:0] bp_mispredict_count;
+  wire bp_taken = (BPRED_EN != 0) && bp_hit_taken;
+
+  bpred bpred_inst(
+    .clk(clk),
+    .rst_n(resetn),
+    .lookup_pc(f_pc),
+    .pred_taken(bp_hit_taken),
+    .pred_target(bp_target),
+    .update_valid(e_valid && ex_advance && !e_is_irq),
+    .update_pc(e_pc),
+    .update_is_branch(e_is_branch),
+    .update_is_jump(e_is_jal || e_is_jalr),
+    .update_is_call((e_is_jal || e_is_jalr) && (e_rd == 5'd1 || e_rd == 5'd5)),
+    .update_is_return(e_is_jalr && e_rd == 5'd0 && (e_rs1 == 5'd1 || e_rs1 == 5'd5)),
+    .update_link(e_pc_plus_4),
+    .update_taken(ex_taken),
+    .update_target(ex_target),
+    .update_mispredict(ex_mispredict && !e_lp_end),
+    .predict_count(bp_predict_count),
+    .mispredict_count(bp_mispredict_count)
+  );
+
+  wire [31:0] f_pc_plus_4;
+  adder_32 #(.ARCH(PC_ADDER)) fetch_pc_adder (
+    .a(f_pc),
+    .b(d_is_rvc ? 32'd2 : 32'd4),
+    .cin(1'b0),
+    .sum(f_pc_plus_4),
+    .cout()
+  );
+
+  // end of a hardware loop body: fetch the loop start next, like a taken branch
+  wire f_lp_hit = (f_pc == lp_end) && (lp_count > 32'd1);
+  wire f_pred_taken = bp_taken || f_lp_hit;
+  wire [31:0] f_pred_target = bp_taken ? bp_target : lp_start;
+
+  wire [31:0] fetch_addr = redirect ? redirect_pc :
+                           (!d_valid || !id_advance) ? f_pc :
+                           f_pred_taken ? f_pred_target :
+                           f_pc_plus_4;
+  assign imem_addr = fetch_addr;
+
+  //=============================================================================
+  // Memory interface, mux between the scalar EX request and vlsu
+  //=============================================================================
+
+  wire scalar_req = e_scalar_mem && !mem_stall;
+
+  assign dmem_req_valid = vec_mem_active ? vpf_mem_valid : scalar_req;
+  assign dmem_req_write = vec_mem_active ? vpf_mem_write : e_mem_write;
+  assign dmem_req_addr  = vec_mem_active ? vpf_mem_addr : alu_out;
+  assign dmem_req_wdata = vec_mem_active ? vpf_mem_wdata : st_wdata;
+  assign dmem_req_wmask = vec_mem_active ? vpf_mem_wmask : st_wmask;
+  assign dmem_resp_ready = 1'b1;
+  assign dmem_req_vector = vec_mem_active;
+
+  //=============================================================================
+  // EX result
+  //=============================================================================
+
+  // CSR access when the instruction leaves EX, the old value goes to rd;
+  // traps are taken there too (see redirect)
+  wire [31:0] csr_rdata;
+  csr_file #(.VLEN(VLEN)) csr_inst(
+    .clk(clk),
+    .resetn(resetn),
+    .addr(e_imm[11:0]),
+    .op(e_csr_op[1:0]),
+    .src(e_csr_op[2] ? {27'd0, e_insn[19:15]} : ex_rs1),
+    .src_zero(e_insn[19:15] == 5'd0),
+    .valid(e_valid && ex_advance && e_is_csr),
+    .rdata(csr_rdata),
+    .vset(e_valid && ex_advance && e_is_vset),
+    .vsetl(e_valid && ex_advance && e_is_vsetl),
+    .vset_len(ex_rs1),
+    .vsetl_sew(ex_rs2[1:0]),
+    .vset_grant(vset_grant),
+    .vsew(e_vsew),
+    .vmask_bytes(vmask_bytes),
+    .vtype_sew(vtype_sew),
+    .vl_bytes(vl_bytes),
+    .ev_retire(w_valid),
+    .ev_vec_retire(e_valid && ex_advance && e_is_vec_op),
+    .ev_vlsu_busy(vec_mem_active),
+    .ev_mem_stall(mem_stall),
+    .ev_branch_taken(e_valid && ex_advance && take_branch),
+    .mtime(mtime),
+    .timer_irq(timer_irq),
+    .soft_irq(soft_irq),
+    .irq_pending(irq_pending),
+    .trap_take(e_valid && ex_advance && (e_irq_take || e_is_ecall)),
+    .trap_ecall(e_is_ecall),
+    .trap_pc(e_pc),
+    .trap_vector(trap_vector),
+    .mret(e_valid && ex_advance && e_is_mret),
+    .mepc_out(mepc)
+  );
+
+  reg [31:0] ex_result;
+  always @(*) begin
+    if (e_is_rdwrctr) begin
+      case (e_rdwrctr_ctr_id)
+        3'b000: ex_result = cycle_counter;
+        3'b001: ex_result = insn_counter;
+        3'b010: ex_result = load_counter;
+        3'b011: ex_result = store_counter;
+        3'b100: ex_result = vpf_useful_count;
+        3'b101: ex_result = vpf_useless_count;
+        3'b110: ex_result = bp_predict_count;
+        3'b111: ex_result = bp_mispredict_count;
+        default: ex_result = 32'h0;
+      endcase
+    end else if (e_is_csr) begin
+      ex_result = csr_rdata;
+    end else if (e_is_vset || e_is_vsetl) begin
+      ex_result = vset_grant;
+    end else if (e_is_vmac) begin
+      ex_result = vmac_result_wire;
+    end else if (e_is_muldiv) begin
+      ex_result = muldiv_result_wire;
+    end else if (e_is_vec_vmac) begin
+      ex_result = valu_result[31:0];
+    end else if (e_is_jal || e_is_jalr) begin
+      ex_result = e_pc_plus_4;
+    end else begin
+      ex_result = alu_out;
+    end
+  end
+
+  // a masked VLD writes 0 into its inactive elements
+  wire [VLEN-1:0] ex_vresult = e_vtcm ? (vtcm_rdata & e_vkeep) :
+                           e_vlsu ? (vlsu_load_data & e_vkeep) :
+                           valu_result;
+
+  //=============================================================================
+  // MEM: load data alignment
+  //=============================================================================
+
+  wire [7:0] mem_byte = (m_addr_lo == 2'b00) ? dmem_resp_rdata[7:0] :
+                        (m_addr_lo == 2'b01) ? dmem_resp_rdata[15:8] :
+                        (m_addr_lo == 2'b10) ? dmem_resp_rdata[23:16] :
+                        dmem_resp_rdata[31:24];
+  wire [15:0] mem_half = (m_addr_lo[1] == 1'b0) ? dmem_resp_rdata[15:0] : dmem_resp_rdata[31:16];
+
+  wire [31:0] mem_data_extended = m_mem_sign_extend ?
+    (m_mem_mask == 32'h000000FF ? {{24{mem_byte[7]}}, mem_byte} :
+     m_mem_mask == 32'h0000FFFF ? {{16{mem_half[15]}}, mem_half} :
+     dmem_resp_rdata) :
+    (m_mem_mask == 32'h000000FF ? {24'h0, mem_byte} :
+     m_mem_mask == 32'h0000FFFF ? {16'h0, mem_half} :
+     dmem_resp_rdata);
+
+  //=============================================================================
+  // WB / outputs
+  //=============================================================================
+
+  assign retire = w_valid;
+  assign ebreak_hit = w_valid && w_ebreak;
+
+  reg [31:0] trace_pc_reg;
+  reg [31:0] trace_insn_reg;
+  assign trace_pc = trace_pc_reg;
+  assign trace_insn = trace_insn_reg;
+
+  //=============================================================================
+  // Pipeline update
+  //=============================================================================
+
+  always @(posedge clk) begin
+    if (!resetn) begin
+      f_pc <= 32'h00000000;
+      d_valid <= 1'b0;
+      e_valid <= 1'b0;
+      e_started <= 1'b0;
+      m_valid <= 1'b0;
+      w_valid <= 1'b0;
+      e_done <= 1'b0;
+      cycle_counter <= 32'd0;
+      insn_counter <= 32'd0;
+      load_counter <= 32'd0;
+      store_counter <= 32'd0;
+      trace_pc_reg <= 32'd0;
+      trace_insn_reg <= 32'd0;
+      lp_start <= 32'd0;
+      lp_end <= 32'd0;
+      lp_count <= 32'd0;
+    end else begin
+      cycle_counter <= cycle_counter + 32'd1;
+
+      // IF
+      f_pc <= fetch_addr;
+      d_valid <= 1'b1;
+
+      // ID -> EX
+      if (redirect) begin
+        // the instruction in ID is on the wrong path
+        e_valid <= 1'b0;
+        e_started <= 1'b0;
+      end else if (id_advance) begin
+        e_valid <= d_valid;
+        e_started <= 1'b0;
+        e_pc <= f_pc;
+        e_pred_taken <= f_pred_taken;
+        e_pred_target <= f_pred_target;
+        e_insn <= d_insn;
+        e_is_rvc <= d_is_rvc;
+        e_rd <= dec_vec_base_write ? dec_rs1 : dec_rd;
+        e_vd <= dec_rd;
+        e_vs1 <= d_vs1;
+        e_rs1 <= dec_rs1;
+        e_rs2 <= dec_rs2;
+        e_rs1_val <= d_rs1_val;
+        e_rs2_val <= d_rs2_val;
+        e_imm <= dec_imm;
+        e_alu_ctrl <= dec_alu_ctrl;
+        e_alu_src2_sel <= dec_alu_src2_sel;
+        e_mem_write <= dec_mem_write;
+        e_mem_read <= dec_mem_read;
+        e_mem_mask <= dec_mem_mask;
+        e_mem_sign_extend <= dec_mem_sign_extend;
+        e_is_branch <= dec_is_branch;
+        e_branch_if_set <= dec_branch_if_set;
+        e_is_branch_compare <= dec_is_branch_compare;
+        e_is_jal <= dec_is_jal;
+        e_is_jalr <= dec_is_jalr;
+        e_is_auipc <= dec_is_auipc;
+        e_reg_write <= dec_reg_write || dec_vec_base_write;
+        e_ebreak <= dec_ebreak_hit;
+        e_is_vmac <= dec_is_vmac;
+        e_vmac_ctrl <= dec_vmac_ctrl;
+        e_is_muldiv <= dec_is_muldiv;
+        e_muldiv_ctrl <= dec_muldiv_ctrl;
+        e_is_csr <= dec_is_csr;
+        e_csr_op <= dec_csr_op;
+        e_is_ecall <= dec_is_ecall;
+        e_is_mret <= dec_is_mret;
+        e_is_irq <= d_irq;
+        e_is_lpsetup <= dec_is_lpsetup;
+        e_is_vset <= dec_is_vset;
+        e_is_vsetl <= dec_is_vsetl;
+        e_is_rdwrctr <= dec_is_rdwrctr;
+        e_rdwrctr_wen <= dec_rdwrctr_wen;
+        e_rdwrctr_ctr_id <= dec_rdwrctr_ctr_id;
+        e_is_vec_op <= dec_is_vec_op;
+        e_vec_op <= dec_vec_op;
+        e_vec_vx <= dec_vec_vx;
+        e_vec_ld_mode <= dec_vec_ld_mode;
+        e_vec_sew <= dec_vec_sew;
+        e_vec_masked <= dec_vec_masked;
+        e_is_vec_load <= dec_is_vec_load;
+        e_is_vec_store <= dec_is_vec_store;
+        e_is_vec_vmac <= dec_is_vec_vmac;
+        e_vec_reg_write <= dec_vec_reg_write;
+        e_vs1_val <= d_vs1_val;
+        e_vs2_val <= d_vs2_val;
+      end else if (ex_advance) begin
+        // load-use bubble
+        e_valid <= 1'b0;
+        e_started <= 1'b0;
+      end else begin
+        // EX holds: keep the forwarded operands, MEM/WB move on underneath
+        e_rs1_val <= ex_rs1;
+        e_rs2_val <= ex_rs2;
+        e_vs1_val <= ex_vs1;
+        e_vs2_val <= ex_vs2;
+        if (vtcm_valid || vlsu_start ||
+            (e_valid && (e_is_vmac || e_is_muldiv || e_is_valu) && !e_started)) begin
+          e_started <= 1'b1;
+        end
+      end
+
+      // completion pulses seen while EX is held
+      if (ex_advance || redirect) begin
+        e_done <= 1'b0;
+      end else if (e_valid && unit_fin) begin
+        e_done <= 1'b1;
+      end
+
+      // EX side effects
+      if (e_valid && ex_advance) begin
+        if (e_is_rdwrctr && e_rdwrctr_wen) begin
+          case (e_rdwrctr_ctr_id)
+            3'b000: cycle_counter <= ex_rs1;
+            3'b001: insn_counter <= ex_rs1;
+            3'b010: load_counter <= ex_rs1;
+            3'b011: store_counter <= ex_rs1;
+            default: ; // prefetch/branch counters are read-only
+          endcase
+        end
+        if (e_is_lpsetup) begin
+          lp_start <= e_pc_plus_4;
+          lp_end <= e_pc + {19'd0, e_imm[11:0], 1'b0}; // imm = halfwords to the last body instruction
+          lp_count <= ex_rs1;
+        end else if (e_lp_end) begin
+          lp_count <= lp_count - 32'd1;
+        end
+      end
+      if (scalar_req && e_mem_write && dmem_req_ready) begin
+        store_counter <= store_counter + 32'd1;
+      end
+
+      // EX -> MEM
+      if (ex_advance) begin
+        m_valid <= e_valid && !e_is_irq; // the marker does not retire
+        m_pc <= e_pc;
+        m_insn <= e_insn;
+        m_rd <= e_rd;
+        m_reg_write <= e_reg_write;
+        m_result <= ex_result;
+        m_mem_read <= e_mem_read;
+        m_addr_lo <= alu_out[1:0];
+        m_mem_mask <= e_mem_mask;
+        m_mem_sign_extend <= e_mem_sign_extend;
+        m_vec_reg_write <= e_vec_reg_write;
+        m_vd <= e_vd;
+        m_vresult <= ex_vresult;
+        m_ebreak <= e_ebreak;
+      end else if (!mem_stall) begin
+        m_valid <= 1'b0;
+      end
+
+      // MEM -> WB
+      if (!mem_stall) begin
+        w_valid <= m_valid;
+        w_pc <= m_pc;
+        w_insn <= m_insn;
+        w_rd <= m_rd;
+        w_reg_write <= m_reg_write;
+        w_result <= m_mem_read ? mem_data_extended : m_result;
+        w_vec_reg_write <= m_vec_reg_write;
+        w_vd <= m_vd;
+        w_vresult <= m_vresult;
+        w_ebreak <= m_ebreak;
+        if (m_valid && m_mem_read) begin
+          load_counter <= load_counter + 32'd1;
+        end
+      end else begin
+        w_valid <= 1'b0;
+      end
+
+      // WB
+      if (w_valid) begin
+        insn_counter <= insn_counter + 32'd1;
+        trace_pc_reg <= w_pc;
+        trace_insn_reg <= w_insn;
+      end
+    end
+  end
+
+endmodule
@@ -1,362 +1,480 @@
-// vector ALU for 64-bit VLEN
-// VADD, VSUB, VMUL are supported
-// SEW: 8-bit(int8, 8 lanes), 16-bit(int16, 4 lanes), 32-bit(int32, 2 lanes)
+// vector ALU, VLEN bits (64, 128 or 256)
+// VADD, VSUB, VMUL, VMAC (sum of products), VMACC/VREDACC are supported
+// VMOV_S2V/V2S insert/extract element `lane`; with `vx` set the vs2 operand is
+// `scalar` broadcast to every lane (the .vx forms)
+// VNCLIP narrows the int32 lanes of vs1: rounding arithmetic shift by
+// scalar[4:0], plus the signed offset scalar[31:16], optional ReLU, saturated
+// to SEW and packed into the low elements of the result. VNCLIP.ACC does the
+// same to the VLEN/8 accumulator lanes, always to int8, so the result is a
+// whole register of packed int8 and the accumulator is cleared
+// VREDSUM/VREDMAX/VREDMIN/VARGMAX reduce the signed elements of vs1 to a
+// 32-bit scalar; VARGMAX is the lowest lane holding the maximum
+// `vmask` enables bytes of active elements (all ones unmasked): inactive
+// elements of both operands read as 0, so their VADD/VSUB/VMUL lanes are 0 and
+// they add nothing to VMAC/VMACC; reductions skip them. VMOV and the VNCLIPs ignore it
+// SEW: 8-bit(int8, VLEN/8 lanes), 16-bit(int16, VLEN/16 lanes),
+//      32-bit(int32, VLEN/32 lanes)
+//
+// VMACC adds each lane's product into its own 32-bit lane of an internal
+// accumulator (VLEN/8 x 32 bits), no reduction; VREDACC returns the sum of the
+// accumulator lanes as a 32-bit scalar and clears it. A dot product is then
+// n VMACCs and one VREDACC instead of n VMACs and n scalar adds.
+//
+// Pipeline, one op accepted per pass:
+//   M : NUM_MULS lane multipliers (and the VADD/VSUB adders); multiplier g
+//       takes element g. An op with more lanes than multipliers stays here
+//       for lanes/NUM_MULS passes, the operands shifted down by NUM_MULS
+//       elements each pass
+//   R : products registered; reduce (VMAC), place into lanes (VMUL) or add
+//       into the accumulator (VMACC), the result register is written after
+//       the last pass
+// `valid_in` is taken when `in_ready` is high, operands are only needed in
+// that cycle. `valid_out` holds with `result` until `out_ready`, which stalls
+// the whole pipeline. Results come out in order, 2 cycles after the last
+// pass enters M.
 
-module valu(
+module valu #(
+    parameter VLEN = 64,
+    parameter NUM_MULS = 4 // lane multipliers: 4, 8 or 16
+)(
     input wire clk,
     input wire rst_n,
-    input wire [1:0] op, // 00=VADD, 01=VSUB, 10=VMUL
+    input wire [3:0] op, // 0000=VADD, 0001=VSUB, 0010=VMUL, 0011=VMAC, 0100=VMACC, 0101=VREDACC,
+                         // 0110=VMOV_S2V, 0111=VMOV_V2S, 1000=VNCLIP.ACC, 1001=VNCLIP.ACC.RELU,
+                         // 1010=VNCLIP, 1011=VNCLIP.RELU,
+                         // 1100=VREDSUM, 1101=VREDMAX, 1110=VREDMIN, 1111=VARGMAX
     input wire [1:0] sew, // 00=8bit, 01=16bit, 10=32bit
-    input wire [63:0] vs1_data, // source operand 1
-    input wire [63:0] vs2_data, // source operand 2
+    input wire [VLEN-1:0] vs1_data, // source operand 1 (old vd for VMOV_S2V)
+    input wire [VLEN-1:0] vs2_data, // source operand 2
+    input wire vx, // vs2 operand is `scalar` in every lane
+    input wire [31:0] scalar, // .vx operand, VMOV_S2V source, VNCLIP shift/offset
+    input wire [4:0] lane, // VMOV_S2V/V2S element index
+    input wire [VLEN/8-1:0] vmask, // byte enables of the active elements
     input wire valid_in, // start operation
+    output wire in_ready, // an op can be taken this cycle
     output reg valid_out, // result ready
-    output reg [63:0] result // output result
+    input wire out_ready, // result taken this cycle
+    output reg [VLEN-1:0] result // output result
 );
 
     // opcodes
-    localparam OP_VADD = 2'b00;
-    localparam OP_VSUB = 2'b01;
-    localparam OP_VMUL = 2'b10;
-    localparam OP_VMAC = 2'b11;  // 8-lane multiply-accumulate (result = sum of products)
-    
+    localparam OP_VADD = 4'b0000;
+    localparam OP_VSUB = 4'b0001;
+    localparam OP_VMUL = 4'b0010;
+    localparam OP_VMAC = 4'b0011;    // multiply-accumulate (result = sum of products)
+    localparam OP_VMACC = 4'b0100;   // acc[lane] += vs1[lane] * vs2[lane]
+    localparam OP_VREDACC = 4'b0101; // result = sum of acc lanes, acc cleared
+    localparam OP_VMOV_S2V = 4'b0110; // result = vs1 with element `lane` = scalar
+    localparam OP_VMOV_V2S = 4'b0111; // result = element `lane` of vs1, sign-extended
+    localparam OP_VNCLIP_ACC = 4'b1000; // accumulator lanes -> int8, accumulator cleared
+    localparam OP_VNCLIP_ACC_RELU = 4'b1001; // same, negative results clamp to 0
+    localparam OP_VNCLIP = 4'b1010;  // int32 lanes -> SEW, packed low
+    localparam OP_VNCLIP_RELU = 4'b1011; // same, negative results clamp to 0
+    localparam OP_VREDSUM = 4'b1100; // result = sum of the elements of vs1
+    localparam OP_VREDMAX = 4'b1101; // result = largest element
+    localparam OP_VREDMIN = 4'b1110; // result = smallest element
+    localparam OP_VARGMAX = 4'b1111; // result = lane of the (first) largest element
+
     // SEW codes
     localparam SEW_8 = 2'b00;
     localparam SEW_16 = 2'b01;
     localparam SEW_32 = 2'b10;
-    
-    // 1. lane extraction based on SEW
 
-    // SEW=8: 8 lanes
-    wire signed [7:0] a8 [0:7];
-    wire signed [7:0] b8 [0:7];
-    genvar i;
+    // lanes per SEW
+    localparam integer LANES_8 = VLEN / 8;
+    localparam integer LANES_16 = VLEN / 16;
+    localparam integer LANES_32 = VLEN / 32;
+
+    // passes per multiply op, and how far the operands move between passes
+    localparam integer PASSES_8 = (LANES_8 + NUM_MULS - 1) / NUM_MULS;
+    localparam integer PASSES_16 = (LANES_16 + NUM_MULS - 1) / NUM_MULS;
+    localparam integer PASSES_32 = (LANES_32 + NUM_MULS - 1) / NUM_MULS;
+    localparam integer SHIFT_8 = NUM_MULS * 8;
+    localparam integer SHIFT_16 = NUM_MULS * 16;
+    localparam integer SHIFT_32 = NUM_MULS * 32;
+
+    genvar g;
+
+    // whole pipeline moves unless a finished result is waiting
+    wire adv = !valid_out || out_ready;
+
+    // 1. M stage: first pass straight from the inputs, later passes from the
+    // hold registers
+
+    reg h_valid; // op with passes left
+    reg [3:0] h_op;
+    reg [1:0] h_sew;
+    reg [VLEN-1:0] h_a;
+    reg [VLEN-1:0] h_b;
+    reg [2:0] h_pass;
+
+    assign in_ready = adv && !h_valid;
+
+    wire m_valid = h_valid || valid_in;
+    wire [3:0] m_op = h_valid ? h_op : op;
+    wire [1:0] m_sew = h_valid ? h_sew : sew;
+    // .vx: scalar replicated at the element width
+    wire [31:0] splat_word = (sew == SEW_8) ? {4{scalar[7:0]}} :
+                             (sew == SEW_16) ? {2{scalar[15:0]}} : scalar;
+    wire [VLEN-1:0] vs2_op = vx ? {(VLEN/32){splat_word}} : vs2_data;
+
+    // masked operands: inactive bytes cleared once, before the first pass
+    wire mask_ops = (op[3:1] != 3'b011) && (op[3:1] != 3'b101); // not VMOV/VNCLIP
+    wire [VLEN-1:0] keep;
     generate
-        for (i = 0; i < 8; i = i + 1) begin: gen_lanes_8
-            // assign a8[i] = vs1_data[i*8 +: 8];
-            // assign b8[i] = vs2_data[i*8 +: 8];
-            assign a8[i] = vs1_data[i*8 +: 8];
-            assign b8[i] = vs2_data[i*8 +:8];
+        for (g = 0; g < VLEN / 8; g = g + 1) begin: gen_keep
+            assign keep[g*8 +: 8] = {8{vmask[g] || !mask_ops}};
         end
     endgenerate
 
-    // SEW=16: 4 lanes
-    wire signed [15:0] a16 [0:3];
-    wire signed [15:0] b16 [0:3];
-    genvar j;
+    wire [VLEN-1:0] m_a = h_valid ? h_a : (vs1_data & keep);
+    wire [VLEN-1:0] m_b = h_valid ? h_b : (vs2_op & keep);
+    wire [2:0] m_pass = h_valid ? h_pass : 3'd0;
+
+    wire m_is_mul = (m_op == OP_VMUL) || (m_op == OP_VMAC) || (m_op == OP_VMACC);
+    wire [31:0] m_passes = !m_is_mul ? 1 :
+                           (m_sew == SEW_8) ? PASSES_8 :
+                           (m_sew == SEW_16) ? PASSES_16 : PASSES_32;
+    wire m_last = ({29'd0, m_pass} == m_passes - 1);
+
+    // operands of the next pass
+    wire [VLEN-1:0] m_a_next = (m_sew == SEW_8) ? m_a >> SHIFT_8 :
+                           (m_sew == SEW_16) ? m_a >> SHIFT_16 : m_a >> SHIFT_32;
+    wire [VLEN-1:0] m_b_next = (m_sew == SEW_8) ? m_b >> SHIFT_8 :
+                           (m_sew == SEW_16) ? m_b >> SHIFT_16 : m_b >> SHIFT_32;
+
+    // lane multipliers: sign-extended operands, the low 32 bits hold the full
+    // int8/int16 product and the truncated int32 product. Multipliers past the
+    // last lane of a SEW see 0.
+    wire [31:0] m_prod [0:NUM_MULS-1];
     generate
-        for (j = 0; j < 4; j = j + 1) begin: gen_lanes_16
-            assign a16[j] = vs1_data[j*16 +: 16];
-            assign b16[j] = vs2_data[j*16 +: 16];
+        for (g = 0; g < NUM_MULS; g = g + 1) begin: gen_mul
+            wire [31:0] a8, b8, a16, b16, a32, b32;
+            if (g < LANES_8) begin: g_e8
+                assign a8 = {{24{m_a[g*8 + 7]}}, m_a[g*8 +: 8]};
+                assign b8 = {{24{m_b[g*8 + 7]}}, m_b[g*8 +: 8]};
+            end else begin: g_z8
+                assign a8 = 32'd0;
+                assign b8 = 32'd0;
+            end
+            if (g < LANES_16) begin: g_e16
+                assign a16 = {{16{m_a[g*16 + 15]}}, m_a[g*16 +: 16]};
+                assign b16 = {{16{m_b[g*16 + 15]}}, m_b[g*16 +: 16]};
+            end else begin: g_z16
+                assign a16 = 32'd0;
+                assign b16 = 32'd0;
+            end
+            if (g < LANES_32) begin: g_e32
+                assign a32 = m_a[g*32 +: 32];
+                assign b32 = m_b[g*32 +: 32];
+            end else begin: g_z32
+                assign a32 = 32'd0;
+                assign b32 = 32'd0;
+            end
+            assign m_prod[g] = (m_sew == SEW_8) ? a8 * b8 :
+                               (m_sew == SEW_16) ? a16 * b16 : a32 * b32;
         end
     endgenerate
 
-    // SEW=32: 2 lanes
-    wire signed [31:0] a32 [0:1];
-    wire signed [31:0] b32 [0:1];
-    genvar k;
+    // VADD/VSUB (op[0] = subtract), single pass
+    wire [VLEN-1:0] m_as8;
+    wire [VLEN-1:0] m_as16;
+    wire [VLEN-1:0] m_as32;
+    genvar i;
     generate
-        for (k = 0; k < 2; k = k + 1) begin: gen_lanes_32
-            assign a32[k] = vs1_data[k*32 +: 32];
-            assign b32[k] = vs2_data[k*32 +: 32];
+        for (i = 0; i < LANES_8; i = i + 1) begin: gen_addsub_8
+            assign m_as8[i*8 +: 8] = m_op[0] ? m_a[i*8 +: 8] - m_b[i*8 +: 8] :
+                                               m_a[i*8 +: 8] + m_b[i*8 +: 8];
+        end
+        for (i = 0; i < LANES_16; i = i + 1) begin: gen_addsub_16
+            assign m_as16[i*16 +: 16] = m_op[0] ? m_a[i*16 +: 16] - m_b[i*16 +: 16] :
+                                                  m_a[i*16 +: 16] + m_b[i*16 +: 16];
+        end
+        for (i = 0; i < LANES_32; i = i + 1) begin: gen_addsub_32
+            assign m_as32[i*32 +: 32] = m_op[0] ? m_a[i*32 +: 32] - m_b[i*32 +: 32] :
+                                                  m_a[i*32 +: 32] + m_b[i*32 +: 32];
         end
     endgenerate
+    wire [VLEN-1:0] m_addsub = (m_sew == SEW_8) ? m_as8 :
+                           (m_sew == SEW_16) ? m_as16 : m_as32;
 
+    // VMOV_S2V/V2S, single pass (never from the hold registers). A lane past
+    // the last element of the SEW leaves vs1 as is / extracts 0.
+    wire [9:0] m_lane_bit = (m_sew == SEW_8) ? {2'b00, lane, 3'b000} :
+                            (m_sew == SEW_16) ? {1'b0, lane, 4'b0000} : {lane, 5'b00000};
+    wire [31:0] m_elem_mask = (m_sew == SEW_8) ? 32'h000000ff :
+                              (m_sew == SEW_16) ? 32'h0000ffff : 32'hffffffff;
+    wire [VLEN-1:0] m_ins_mask = {{(VLEN-32){1'b0}}, m_elem_mask} << m_lane_bit;
+    wire [VLEN-1:0] m_ins = (m_a & ~m_ins_mask) |
+                            ({{(VLEN-32){1'b0}}, scalar & m_elem_mask} << m_lane_bit);
+    wire [VLEN-1:0] m_ext_raw = m_a >> m_lane_bit;
+    wire [31:0] m_ext = (m_sew == SEW_8) ? {{24{m_ext_raw[7]}}, m_ext_raw[7:0]} :
+                        (m_sew == SEW_16) ? {{16{m_ext_raw[15]}}, m_ext_raw[15:0]} : m_ext_raw[31:0];
 
-    // 2. combinational results for VADD/VSUB (single cycle)
-
-    // SEW=8 results
-    wire [7:0] add8 [0:7];
-    wire [7:0] sub8 [0:7];
+    // VNCLIP/VNCLIP.RELU, single pass: 34 bits hold the rounded, offset value
+    // of any int32 before saturation
+    wire [4:0] nc_shift = scalar[4:0];
+    wire signed [33:0] nc_round = (nc_shift == 5'd0) ? 34'sd0 : (34'sd1 <<< (nc_shift - 5'd1));
+    wire signed [33:0] nc_off = {{18{scalar[31]}}, scalar[31:16]};
+    wire signed [33:0] nc_max = (m_sew == SEW_8) ? 34'sd127 :
+                                (m_sew == SEW_16) ? 34'sd32767 : 34'sd2147483647;
+    wire signed [33:0] nc_min = (m_op == OP_VNCLIP_RELU) ? 34'sd0 :
+                                (m_sew == SEW_8) ? -34'sd128 :
+                                (m_sew == SEW_16) ? -34'sd32768 : -34'sd2147483648;
+    wire [LANES_32*8-1:0] m_nc8;
+    wire [LANES_32*16-1:0] m_nc16;
+    wire [VLEN-1:0] m_nc32;
     generate
-        for (i = 0; i < 8; i = i + 1) begin: gen_addsub_8
-            assign add8[i] = a8[i] + b8[i];
-            assign sub8[i] = a8[i] - b8[i];
+        for (i = 0; i < LANES_32; i = i + 1) begin: gen_nclip
+            wire signed [33:0] x = {{2{m_a[i*32 + 31]}}, m_a[i*32 +: 32]};
+            wire signed [33:0] v = ((x + nc_round) >>> nc_shift) + nc_off;
+            wire signed [33:0] y = (v > nc_max) ? nc_max : (v < nc_min) ? nc_min : v;
+            assign m_nc8[i*8 +: 8] = y[7:0];
+            assign m_nc16[i*16 +: 16] = y[15:0];
+            assign m_nc32[i*32 +: 32] = y[31:0];
         end
     endgenerate
+    wire [VLEN-1:0] m_nclip = (m_sew == SEW_8) ? {{(VLEN - LANES_32*8){1'b0}}, m_nc8} :
+                              (m_sew == SEW_16) ? {{(VLEN - LANES_32*16){1'b0}}, m_nc16} : m_nc32;
 
-    // SEW=16 results
-    wire [15:0] add16 [0:3];
-    wire [15:0] sub16 [0:3];
+    // reductions, single pass: elements of vs1 sign-extended to 32 bits,
+    // lanes past the last element of the SEW and inactive elements do not
+    // take part (with none left the result is 0)
+    wire [31:0] red_elem [0:LANES_8-1];
+    wire [LANES_8-1:0] red_in;
     generate
-        for (j = 0; j < 4; j = j + 1) begin: gen_addsub_16
-            assign add16[j] = a16[j] + b16[j];
-            assign sub16[j] = a16[j] - b16[j];
+        for (g = 0; g < LANES_8; g = g + 1) begin: gen_red
+            wire [31:0] e8 = {{24{m_a[g*8 + 7]}}, m_a[g*8 +: 8]};
+            wire [31:0] e16, e32;
+            wire in16, in32; // element g exists at the SEW and is active
+            if (g < LANES_16) begin: g_e16
+                assign e16 = {{16{m_a[g*16 + 15]}}, m_a[g*16 +: 16]};
+                assign in16 = vmask[g*2];
+            end else begin: g_z16
+                assign e16 = 32'd0;
+                assign in16 = 1'b0;
+            end
+            if (g < LANES_32) begin: g_e32
+                assign e32 = m_a[g*32 +: 32];
+                assign in32 = vmask[g*4];
+            end else begin: g_z32
+                assign e32 = 32'd0;
+                assign in32 = 1'b0;
+            end
+            assign red_elem[g] = (m_sew == SEW_8) ? e8 : (m_sew == SEW_16) ? e16 : e32;
+            assign red_in[g] = (m_sew == SEW_8) ? vmask[g] : (m_sew == SEW_16) ? in16 : in32;
         end
     endgenerate
 
-    // SEW=32 results
-    wire [31:0] add32 [0:1];
-    wire [31:0] sub32 [0:1];
-    generate
-        for (k = 0; k < 2; k = k + 1) begin: gen_addsub_32
-            assign add32[k] = a32[k] + b32[k];
-            assign sub32[k] = a32[k] - b32[k];
+    reg [31:0] red_sum;
+    reg signed [31:0] red_max, red_min;
+    reg [31:0] red_arg;
+    reg red_seen; // an element before this one took part
+    integer r;
+    always @(*) begin
+        red_sum = 32'd0;
+        red_max = 32'sd0;
+        red_min = 32'sd0;
+        red_arg = 32'd0;
+        red_seen = 1'b0;
+        for (r = 0; r < LANES_8; r = r + 1) begin
+            if (red_in[r]) begin
+                red_sum = red_sum + red_elem[r];
+                if (!red_seen || $signed(red_elem[r]) > red_max) begin
+                    red_max = red_elem[r];
+                    red_arg = r;
+                end
+                if (!red_seen || $signed(red_elem[r]) < red_min) begin
+                    red_min = red_elem[r];
+                end
+                red_seen = 1'b1;
+            end
         end
-    endgenerate
+    end
+    wire [31:0] m_red = (m_op == OP_VREDSUM) ? red_sum :
+                        (m_op == OP_VREDMAX) ? red_max :
+                        (m_op == OP_VREDMIN) ? red_min : red_arg;
+
+    // result of the single-pass ops
+    wire [VLEN-1:0] m_single = (m_op == OP_VMOV_S2V) ? m_ins :
+                               (m_op == OP_VMOV_V2S) ? {{(VLEN-32){1'b0}}, m_ext} :
+                               (m_op == OP_VNCLIP || m_op == OP_VNCLIP_RELU) ? m_nclip :
+                               (m_op[3:2] == 2'b11) ? {{(VLEN-32){1'b0}}, m_red} : m_addsub;
+
+    // 2. R stage registers
+
+    reg r_valid;
+    reg r_last;
+    reg [3:0] r_op;
+    reg [1:0] r_sew;
+    reg [2:0] r_pass;
+    reg [31:0] r_prod [0:NUM_MULS-1];
+    reg [VLEN-1:0] r_single; // VADD/VSUB/VMOV/VNCLIP/reduction result
+    reg [20:0] r_nc; // VNCLIP.ACC offset and shift, {scalar[31:16], scalar[4:0]}
+
+    // widening accumulator for VMACC/VREDACC, one 32-bit lane per int8 lane
+    reg signed [31:0] acc [0:LANES_8-1];
+    reg signed [31:0] acc_sum;
+    integer a;
+    always @(*) begin
+        acc_sum = 32'sd0;
+        for (a = 0; a < LANES_8; a = a + 1) begin
+            acc_sum = acc_sum + acc[a];
+        end
+    end
 
-    // pack add/sub results
-    wire [63:0] vadd_result;
-    wire [63:0] vsub_result;
-
-    assign vadd_result = (sew == SEW_8) ? {add8[7], add8[6], add8[5], add8[4],
-                                             add8[3], add8[2], add8[1], add8[0]} :
-                        (sew == SEW_16) ? {add16[3], add16[2], add16[1], add16[0]} :
-                                        {add32[1], add32[0]};
-
-    assign vsub_result = (sew == SEW_8) ? {sub8[7], sub8[6], sub8[5], sub8[4],
-                                             sub8[3], sub8[2], sub8[1], sub8[0]} :
-                        (sew == SEW_16) ? {sub16[3], sub16[2], sub16[1], sub16[0]} :
-                                        {sub32[1], sub32[0]};
-    
-    // VMAC: multiply-accumulate (sum of products) - SEW dependent
-    // Result is 32-bit scalar stored in lower 32 bits of result
-    
-    // SEW=8: 8 lanes, int8 * int8 = 16-bit products, sum to 32-bit
-    wire signed [15:0] prod8_mac [0:7];
+    // VNCLIP.ACC, in R like VREDACC so an earlier VMACC has landed: the VNCLIP
+    // requantization of every accumulator lane, saturated to int8
+    wire [4:0] ra_shift = r_nc[4:0];
+    wire signed [33:0] ra_round = (ra_shift == 5'd0) ? 34'sd0 : (34'sd1 <<< (ra_shift - 5'd1));
+    wire signed [33:0] ra_off = {{18{r_nc[20]}}, r_nc[20:5]};
+    wire signed [33:0] ra_min = (r_op == OP_VNCLIP_ACC_RELU) ? 34'sd0 : -34'sd128;
+    wire [VLEN-1:0] r_ncacc;
     generate
-        for (i = 0; i < 8; i = i + 1) begin: gen_vmac_prod8
-            assign prod8_mac[i] = $signed(a8[i]) * $signed(b8[i]);
+        for (g = 0; g < LANES_8; g = g + 1) begin: gen_ncacc
+            wire signed [33:0] x = {{2{acc[g][31]}}, acc[g]};
+            wire signed [33:0] v = ((x + ra_round) >>> ra_shift) + ra_off;
+            wire signed [33:0] y = (v > 34'sd127) ? 34'sd127 : (v < ra_min) ? ra_min : v;
+            assign r_ncacc[g*8 +: 8] = y[7:0];
         end
     endgenerate
-    wire signed [31:0] vmac_sum_8;
-    assign vmac_sum_8 = {{16{prod8_mac[0][15]}}, prod8_mac[0]} + {{16{prod8_mac[1][15]}}, prod8_mac[1]} + 
-                        {{16{prod8_mac[2][15]}}, prod8_mac[2]} + {{16{prod8_mac[3][15]}}, prod8_mac[3]} +
-                        {{16{prod8_mac[4][15]}}, prod8_mac[4]} + {{16{prod8_mac[5][15]}}, prod8_mac[5]} + 
-                        {{16{prod8_mac[6][15]}}, prod8_mac[6]} + {{16{prod8_mac[7][15]}}, prod8_mac[7]};
-    
-    // SEW=16: 4 lanes, int16 * int16 = 32-bit products, sum to 32-bit (truncated)
-    wire signed [31:0] prod16_mac [0:3];
+
+    // VMAC/VMUL results of the passes so far
+    reg [31:0] part_sum;
+    reg [VLEN-1:0] part_lanes;
+
+    // adder tree over one pass of products
+    reg [31:0] r_prod_sum;
+    integer p;
+    always @(*) begin
+        r_prod_sum = 32'd0;
+        for (p = 0; p < NUM_MULS; p = p + 1) begin
+            r_prod_sum = r_prod_sum + r_prod[p];
+        end
+    end
+
+    // VMUL: products of this pass placed into lanes; over several passes each
+    // pass moves the earlier lanes down and fills the top
+    wire [VLEN-1:0] r_place8;
+    wire [VLEN-1:0] r_place16;
+    wire [VLEN-1:0] r_place32;
     generate
-        for (j = 0; j < 4; j = j + 1) begin: gen_vmac_prod16
-            assign prod16_mac[j] = $signed(a16[j]) * $signed(b16[j]);
+        for (g = 0; g < LANES_8; g = g + 1) begin: gen_place8
+            if (g < NUM_MULS) begin: g_p
+                assign r_place8[g*8 +: 8] = r_prod[g][7:0];
+            end else begin: g_z
+                assign r_place8[g*8 +: 8] = 8'd0;
+            end
+        end
+        for (g = 0; g < LANES_16; g = g + 1) begin: gen_place16
+            if (g < NUM_MULS) begin: g_p
+                assign r_place16[g*16 +: 16] = r_prod[g][15:0];
+            end else begin: g_z
+                assign r_place16[g*16 +: 16] = 16'd0;
+            end
+        end
+        for (g = 0; g < LANES_32; g = g + 1) begin: gen_place32
+            if (g < NUM_MULS) begin: g_p
+                assign r_place32[g*32 +: 32] = r_prod[g];
+            end else begin: g_z
+                assign r_place32[g*32 +: 32] = 32'd0;
+            end
         end
     endgenerate
-    wire signed [31:0] vmac_sum_16;
-    assign vmac_sum_16 = prod16_mac[0] + prod16_mac[1] + prod16_mac[2] + prod16_mac[3];
-    
-    // SEW=32: 2 lanes, int32 * int32 = 64-bit products, sum to 32-bit (truncated)
-    wire signed [63:0] prod32_mac [0:1];
+
+    localparam integer FILL_8 = (SHIFT_8 < VLEN) ? VLEN - SHIFT_8 : 0;
+    localparam integer FILL_16 = (SHIFT_16 < VLEN) ? VLEN - SHIFT_16 : 0;
+    localparam integer FILL_32 = (SHIFT_32 < VLEN) ? VLEN - SHIFT_32 : 0;
+    wire [VLEN-1:0] r_lanes8 = (PASSES_8 == 1) ? r_place8 : (part_lanes >> SHIFT_8) | (r_place8 << FILL_8);
+    wire [VLEN-1:0] r_lanes16 = (PASSES_16 == 1) ? r_place16 : (part_lanes >> SHIFT_16) | (r_place16 << FILL_16);
+    wire [VLEN-1:0] r_lanes32 = (PASSES_32 == 1) ? r_place32 : (part_lanes >> SHIFT_32) | (r_place32 << FILL_32);
+    wire [VLEN-1:0] r_lanes = (r_sew == SEW_8) ? r_lanes8 :
+                              (r_sew == SEW_16) ? r_lanes16 : r_lanes32;
+
+    // VMACC: accumulator lane l is multiplier l % NUM_MULS in pass l / NUM_MULS
+    wire [31:0] acc_next [0:LANES_8-1];
     generate
-        for (k = 0; k < 2; k = k + 1) begin: gen_vmac_prod32
-            assign prod32_mac[k] = $signed(a32[k]) * $signed(b32[k]);
+        for (g = 0; g < LANES_8; g = g + 1) begin: gen_acc
+            localparam integer LANE_PASS = g / NUM_MULS;
+            wire in_sew = (g < LANES_32) || (g < LANES_16 && r_sew != SEW_32) || (r_sew == SEW_8);
+            assign acc_next[g] = (in_sew && {29'd0, r_pass} == LANE_PASS) ? acc[g] + r_prod[g % NUM_MULS] : acc[g];
         end
     endgenerate
-    wire signed [31:0] vmac_sum_32;
-    assign vmac_sum_32 = prod32_mac[0][31:0] + prod32_mac[1][31:0];
-    
-    // Select VMAC result based on SEW
-    wire signed [31:0] vmac_sum;
-    assign vmac_sum = (sew == SEW_8)  ? vmac_sum_8  :
-                      (sew == SEW_16) ? vmac_sum_16 :
-                                        vmac_sum_32;
-
-    // 3. multi-cycle VMUL and VMAC
-
-    reg [2:0] mul_counter;
-    reg computing;
-
-    // multiply results storage for VMUL
-    reg [7:0] mul8 [0:7];
-    reg [15:0] mul16 [0:3];
-    reg [31:0] mul32 [0:1];
-    
-    // multiply results storage for VMAC (products before summation)
-    reg signed [15:0] mac8_prod [0:7];   // 8-bit * 8-bit = 16-bit
-    reg signed [31:0] mac16_prod [0:3];  // 16-bit * 16-bit = 32-bit
-    reg signed [63:0] mac32_prod [0:1];  // 32-bit * 32-bit = 64-bit
+
+    integer ln; // accumulator lane
 
     always @(posedge clk) begin
         if (!rst_n) begin
-            mul_counter <= 3'b0;
-            computing <= 1'b0;
-            result <= 64'b0;
-            valid_out <= 1'b0;
-        end else if (valid_in && !computing) begin
-            // start new op
-            computing <= 1'b1;
-            mul_counter <= 3'b0;
+            h_valid <= 1'b0;
+            r_valid <= 1'b0;
             valid_out <= 1'b0;
-        end else if (computing) begin
-            case (op)
-                OP_VADD: begin
-                    // single cycle
-                    result <= vadd_result;
-                    valid_out <= 1'b1;
-                    computing <= 1'b0;
-                end
-
-                OP_VSUB: begin
-                    // single cycle
-                    result <= vsub_result;
-                    valid_out <= 1'b1;
-                    computing <= 1'b0;
-                end
-
-                OP_VMAC: begin
-                    // multi-cycle MAC with 4 multipliers (fair comparison)
-                    // SEW=8:  8 multiplies, 4 per cycle = 2 cycles + 1 sum = 3 cycles
-                    // SEW=16: 4 multiplies, 4 per cycle = 1 cycle  + 1 sum = 2 cycles
-                    // SEW=32: 2 multiplies, 2 per cycle = 1 cycle  + 1 sum = 2 cycles
-                    case (sew)
-                        SEW_8: begin // 8 multiplies, 4 per cycle = 2 cycles + 1 sum = 3 cycles
-                            case (mul_counter)
-                                3'd0: begin
-                                    mac8_prod[0] <= $signed(a8[0]) * $signed(b8[0]);
-                                    mac8_prod[1] <= $signed(a8[1]) * $signed(b8[1]);
-                                    mac8_prod[2] <= $signed(a8[2]) * $signed(b8[2]);
-                                    mac8_prod[3] <= $signed(a8[3]) * $signed(b8[3]);
-                                    mul_counter <= mul_counter + 1'b1;
-                                end
-                                3'd1: begin
-                                    mac8_prod[4] <= $signed(a8[4]) * $signed(b8[4]);
-                                    mac8_prod[5] <= $signed(a8[5]) * $signed(b8[5]);
-                                    mac8_prod[6] <= $signed(a8[6]) * $signed(b8[6]);
-                                    mac8_prod[7] <= $signed(a8[7]) * $signed(b8[7]);
-                                    mul_counter <= mul_counter + 1'b1;
-                                end
-                                3'd2: begin
-                                    // sum all 8 products
-                                    result <= {32'd0, 
-                                        {{16{mac8_prod[0][15]}}, mac8_prod[0]} + 
-                                        {{16{mac8_prod[1][15]}}, mac8_prod[1]} + 
-                                        {{16{mac8_prod[2][15]}}, mac8_prod[2]} + 
-                                        {{16{mac8_prod[3][15]}}, mac8_prod[3]} +
-                                        {{16{mac8_prod[4][15]}}, mac8_prod[4]} + 
-                                        {{16{mac8_prod[5][15]}}, mac8_prod[5]} + 
-                                        {{16{mac8_prod[6][15]}}, mac8_prod[6]} + 
-                                        {{16{mac8_prod[7][15]}}, mac8_prod[7]}};
-                                    valid_out <= 1'b1;
-                                    computing <= 1'b0;
-                                    mul_counter <= 3'd0;
-                                end
-                                default: mul_counter <= 3'd0;
-                            endcase
-                        end
-                        SEW_16: begin // 4 multiplies, 4 per cycle = 1 cycle + 1 sum = 2 cycles
-                            case (mul_counter)
-                                3'd0: begin
-                                    mac16_prod[0] <= $signed(a16[0]) * $signed(b16[0]);
-                                    mac16_prod[1] <= $signed(a16[1]) * $signed(b16[1]);
-                                    mac16_prod[2] <= $signed(a16[2]) * $signed(b16[2]);
-                                    mac16_prod[3] <= $signed(a16[3]) * $signed(b16[3]);
-                                    mul_counter <= mul_counter + 1'b1;
-                                end
-                                3'd1: begin
-                                    // sum all 4 products
-                                    result <= {32'd0, mac16_prod[0] + mac16_prod[1] + 
-                                                      mac16_prod[2] + mac16_prod[3]};
-                                    valid_out <= 1'b1;
-                                    computing <= 1'b0;
-                                    mul_counter <= 3'd0;
-                                end
-                                default: mul_counter <= 3'd0;
-                            endcase
-                        end
-                        SEW_32: begin // 2 multiplies, 2 per cycle = 1 cycle + 1 sum = 2 cycles
-                            case (mul_counter)
-                                3'd0: begin
-                                    mac32_prod[0] <= $signed(a32[0]) * $signed(b32[0]);
-                                    mac32_prod[1] <= $signed(a32[1]) * $signed(b32[1]);
-                                    mul_counter <= mul_counter + 1'b1;
-                                end
-                                3'd1: begin
-                                    // sum 2 products (truncate to 32-bit)
-                                    result <= {32'd0, mac32_prod[0][31:0] + mac32_prod[1][31:0]};
-                                    valid_out <= 1'b1;
-                                    computing <= 1'b0;
-                                    mul_counter <= 3'd0;
-                                end
-                                default: mul_counter <= 3'd0;
-                            endcase
-                        end
-                        default: begin
-                            valid_out <= 1'b1;
-                            computing <= 1'b0;
-                        end
-                    endcase
-                end
+            result <= {VLEN{1'b0}};
+            part_sum <= 32'd0;
+            part_lanes <= {VLEN{1'b0}};
+            for (ln = 0; ln < LANES_8; ln = ln + 1) begin
+                acc[ln] <= 32'd0;
+            end
+        end else if (adv) begin
+            // M -> R
+            r_valid <= m_valid;
+            r_last <= m_last;
+            r_op <= m_op;
+            r_sew <= m_sew;
+            r_pass <= m_pass;
+            r_single <= m_single;
+            r_nc <= {scalar[31:16], scalar[4:0]};
+            for (ln = 0; ln < NUM_MULS; ln = ln + 1) begin
+                r_prod[ln] <= m_prod[ln];
+            end
+            if (m_valid && !m_last) begin
+                h_valid <= 1'b1;
+                h_op <= m_op;
+                h_sew <= m_sew;
+                h_a <= m_a_next;
+                h_b <= m_b_next;
+                h_pass <= m_pass + 3'd1;
+            end else begin
+                h_valid <= 1'b0;
+            end
 
-                OP_VMUL: begin
-                    // multi-cycle with 4 multipliers
-                    case (sew)
-                        SEW_8: begin // 8 multiplies, 4 per cycle = 2 cycles + 1 result = 3 cycles
-                            case (mul_counter)
-                                3'd0: begin
-                                    mul8[0] <= a8[0] * b8[0];
-                                    mul8[1] <= a8[1] * b8[1];
-                                    mul8[2] <= a8[2] * b8[2];
-                                    mul8[3] <= a8[3] * b8[3];
-                                    mul_counter <= mul_counter + 1'b1;
-                                end
-                                3'd1: begin
-                                    mul8[4] <= a8[4] * b8[4];
-                                    mul8[5] <= a8[5] * b8[5];
-                                    mul8[6] <= a8[6] * b8[6];
-                                    mul8[7] <= a8[7] * b8[7];
-                                    mul_counter <= mul_counter + 1'b1;
-                                end
-                                3'd2: begin
-                                    result <= {mul8[7], mul8[6], mul8[5], mul8[4],
-                                             mul8[3], mul8[2], mul8[1], mul8[0]};
-                                    valid_out <= 1'b1;
-                                    computing <= 1'b0;
-                                    mul_counter <= 3'd0;
-                                end
-                                default :mul_counter <= 3'd0;
-                            endcase
+            // R -> result
+            valid_out <= r_valid && r_last;
+            if (r_valid) begin
+                case (r_op)
+                    OP_VADD, OP_VSUB, OP_VMOV_S2V, OP_VMOV_V2S, OP_VNCLIP, OP_VNCLIP_RELU,
+                    OP_VREDSUM, OP_VREDMAX, OP_VREDMIN, OP_VARGMAX: begin
+                        result <= r_single;
+                    end
+                    OP_VMUL: begin
+                        part_lanes <= r_last ? {VLEN{1'b0}} : r_lanes;
+                        if (r_last) result <= r_lanes;
+                    end
+                    OP_VMAC: begin
+                        part_sum <= r_last ? 32'd0 : part_sum + r_prod_sum;
+                        if (r_last) result <= {{(VLEN-32){1'b0}}, part_sum + r_prod_sum};
+                    end
+                    OP_VMACC: begin
+                        for (ln = 0; ln < LANES_8; ln = ln + 1) begin
+                            acc[ln] <= acc_next[ln];
                         end
-                        SEW_16: begin // 4 multiplies, 4 per cycle = 1 cycle + 1 result = 2 cycles
-                            case (mul_counter)
-                                3'd0: begin
-                                    mul16[0] <= a16[0] * b16[0];
-                                    mul16[1] <= a16[1] * b16[1];
-                                    mul16[2] <= a16[2] * b16[2];
-                                    mul16[3] <= a16[3] * b16[3];
-                                    mul_counter <= mul_counter + 1'b1;
-                                end
-                                3'd1: begin
-                                    result <= {mul16[3], mul16[2], mul16[1], mul16[0]};
-                                    valid_out <= 1'b1;
-                                    computing <= 1'b0;
-                                    mul_counter <= 3'd0;
-                                end
-                                default :mul_counter <= 3'd0;
-                            endcase
+                    end
+                    OP_VREDACC: begin
+                        // horizontal sum, the accumulator starts over
+                        result <= {{(VLEN-32){1'b0}}, acc_sum};
+                        for (ln = 0; ln < LANES_8; ln = ln + 1) begin
+                            acc[ln] <= 32'd0;
                         end
-                        SEW_32: begin // 2 multiplies, 2 per cycle = 1 cycle + 1 result = 2 cycles
-                            case (mul_counter)
-                                3'd0: begin
-                                    mul32[0] <= a32[0] * b32[0];
-                                    mul32[1] <= a32[1] * b32[1];
-                                    mul_counter <= mul_counter + 1'b1;
-                                end
-                                3'd1: begin
-                                    result <= {mul32[1], mul32[0]};
-                                    valid_out <= 1'b1;
-                                    computing <= 1'b0;
-                                    mul_counter <= 3'd0;
-                                end
-                                default :mul_counter <= 3'd0;
-                            endcase
-                        end
-
-                        default : begin
-                            valid_out <= 1'b1;
-                            computing <= 1'b0;
+                    end
+                    OP_VNCLIP_ACC, OP_VNCLIP_ACC_RELU: begin
+                        result <= r_ncacc;
+                        for (ln = 0; ln < LANES_8; ln = ln + 1) begin
+                            acc[ln] <= 32'd0;
                         end
-                    endcase
-                end
-
-                default : begin
-                    valid_out <= 1'b0;
-                    computing <= 1'b0;
-                end
-            endcase
-        end
-        else begin
-            if (valid_out) begin
-                valid_out <= 1'b0;
+                    end
+                    default: begin
+                        result <= {VLEN{1'b0}};
+                    end
+                endcase
             end
         end
     end
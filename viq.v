@@ -0,0 +1,55 @@
+// vector issue queue for the multi-cycle core
+// Vector instructions are pushed in EXEC and retire; the vector back-end in
+// ucrv32.v pops them in order when their unit is free and their operands are
+// ready. Entries are opaque, the core packs/unpacks the fields.
+
+module viq #(
+    parameter DEPTH = 4, // entries, power of 2
+    parameter WIDTH = 32
+)(
+    input wire clk,
+    input wire rst_n,
+
+    input wire push,
+    input wire [WIDTH-1:0] push_data,
+    output wire can_push,
+
+    output wire head_valid,
+    output wire [WIDTH-1:0] head_data,
+    input wire pop,
+
+    output wire empty
+);
+
+    localparam PTR_BITS = (DEPTH > 1) ? $clog2(DEPTH) : 1;
+
+    reg [WIDTH-1:0] q [0:DEPTH-1];
+    reg [PTR_BITS-1:0] rd_ptr, wr_ptr;
+    reg [PTR_BITS:0] count;
+
+    assign can_push = (count < DEPTH);
+    assign head_valid = (count != 0);
+    assign head_data = q[rd_ptr];
+    assign empty = (count == 0);
+
+    wire do_push = push && can_push;
+    wire do_pop = pop && head_valid;
+
+    always @(posedge clk) begin
+        if (!rst_n) begin
+            rd_ptr <= 0;
+            wr_ptr <= 0;
+            count <= 0;
+        end else begin
+            if (do_push) begin
+                q[wr_ptr] <= push_data;
+                wr_ptr <= wr_ptr + 1'b1;
+            end
+            if (do_pop) begin
+                rd_ptr <= rd_ptr + 1'b1;
+            end
+            count <= count + {{PTR_BITS{1'b0}}, do_push} - {{PTR_BITS{1'b0}}, do_pop};
+        end
+    end
+
+endmodule
@@ -1,8 +1,17 @@
-// vector load/stor unit for 64 bit VLEN
+// vector load/stor unit, VLEN bits (64, 128 or 256)
 // Uses existing 32-bit memory bus with multi-cycle transfers
-// VLD: 2 cycles, VST: 2 cycles (both 32-bit x 2)
+// VLD/VST: VLEN/32 beats of one 32-bit word each, lowest address first
+// VLDS/VLDX: one beat per SEW element, element k from base + k*stride
+// (strided) or base + offset k (indexed, offsets are the unsigned SEW-wide
+// elements of a vector register). Elements must be SEW-aligned.
+// `bmask` enables the bytes of the active elements of a masked access: a VST
+// writes only those bytes (mem_wmask), a beat without an active byte is not
+// sent at all (a load shifts in 0 instead). Inactive bytes of a partly
+// active load word still arrive, the core clears them on write-back.
 
-module vlsu(
+module vlsu #(
+    parameter VLEN = 64
+)(
     input wire clk,
     input wire rst_n,
 
@@ -10,10 +19,15 @@ module vlsu(
     input wire start,
     input wire is_store, // 0=load, 1=store
     input wire [31:0] base_addr, // from scalar register
-    input wire [63:0] store_data, // data to store from vector register
+    input wire [VLEN-1:0] store_data, // data to store from vector register
+    input wire [1:0] mode, // load addressing: 00 unit, 01 strided, 10 indexed
+    input wire [1:0] sew, // element width of strided/indexed loads (00=8, 01=16, 10=32)
+    input wire [31:0] stride, // byte stride (strided)
+    input wire [VLEN-1:0] offsets, // byte offsets (indexed)
+    input wire [VLEN/8-1:0] bmask, // byte enables of the active elements (all ones unmasked)
 
     output reg done,
-    output reg [63:0] load_data, // loaded data to vector register
+    output reg [VLEN-1:0] load_data, // loaded data to vector register
 
     // memory interface
     output reg [31:0] mem_addr,
@@ -28,30 +42,89 @@ module vlsu(
 
     // fsm states
     localparam IDLE = 3'd0;
-    localparam REQ_WORD0 = 3'd1; // request first 32-bit word
-    localparam WAIT_WORD0 = 3'd2; // wait for first word response
-    localparam REQ_WORD1 = 3'd3; // request second 32-bit word
-    localparam WAIT_WORD1 = 3'd4; // wait for second word response
-    localparam COMPLETE = 3'd5; // signal completion
+    localparam REQ_WORD = 3'd1; // request the next 32-bit word
+    localparam WAIT_WORD = 3'd2; // wait until the bus accepts it
+    localparam COMPLETE = 3'd3; // signal completion
+    localparam WAIT_RESP = 3'd4; // load accepted, wait for its response
+
+    localparam MODE_UNIT = 2'b00;
+    localparam MODE_STRIDED = 2'b01;
+    localparam MODE_INDEXED = 2'b10;
+
+    // beats per access: VLEN/32 words, or up to VLEN/8 elements
+    localparam BEAT_BITS = $clog2(VLEN / 8);
+    localparam [BEAT_BITS-1:0] LAST_WORD = VLEN / 32 - 1;
+    localparam [BEAT_BITS-1:0] LAST_E8 = VLEN / 8 - 1;
+    localparam [BEAT_BITS-1:0] LAST_E16 = VLEN / 16 - 1;
 
     reg [2:0] state;
-    reg [31:0] addr_reg;
-    reg [63:0] data_reg;
+    reg [31:0] addr_reg; // next word, next strided element, or the indexed base
+    // stores shift out at the bottom, loads shift in at the top, so after
+    // the last beat word 0 is at the bottom either way
+    reg [VLEN-1:0] data_reg;
+    reg [BEAT_BITS-1:0] beat; // word/element being transferred
+    reg [BEAT_BITS-1:0] last_beat_num;
     reg is_store_reg;
+    reg [1:0] mode_reg;
+    reg [1:0] sew_reg;
+    reg [31:0] stride_reg;
+    reg [VLEN-1:0] offs_reg; // offset of the next element at the bottom
+    reg [1:0] byte_off; // element position in the requested word
+    reg [VLEN/8-1:0] bmask_reg; // enables of the next word/element at the bottom
+
+    wire last_beat = (beat == last_beat_num);
+    wire elem_mode = (mode_reg != MODE_UNIT);
+    // the beat has an active byte (an element's enables are all set or all clear)
+    wire beat_on = elem_mode ? bmask_reg[0] : (bmask_reg[3:0] != 4'b0000);
+
+    // address of the next element
+    reg [31:0] elem_off;
+    always @(*) begin
+        case (sew_reg)
+            2'b00: elem_off = {24'd0, offs_reg[7:0]};
+            2'b01: elem_off = {16'd0, offs_reg[15:0]};
+            default: elem_off = offs_reg[31:0];
+        endcase
+    end
+    wire [31:0] elem_addr = (mode_reg == MODE_INDEXED) ? addr_reg + elem_off : addr_reg;
+
+    // data_reg with the load response inserted at the top: a whole word, or
+    // the element picked out of the word
+    wire [31:0] resp_elem = mem_resp_rdata >> {byte_off, 3'b000};
+    reg [VLEN-1:0] data_ins;
+    always @(*) begin
+        if (!elem_mode) begin
+            data_ins = {mem_resp_rdata, data_reg[VLEN-33:0]};
+        end else begin
+            case (sew_reg)
+                2'b00: data_ins = {resp_elem[7:0], data_reg[VLEN-1:8]};
+                2'b01: data_ins = {resp_elem[15:0], data_reg[VLEN-1:16]};
+                default: data_ins = {resp_elem, data_reg[VLEN-1:32]};
+            endcase
+        end
+    end
 
     always @(posedge clk) begin
         if (!rst_n) begin
             state <= IDLE;
             done <=1'b0;
-            load_data <= 64'b0;
+            load_data <= {VLEN{1'b0}};
             mem_addr <= 32'b0;
             mem_wdata <= 32'b0;
             mem_wmask <= 4'b0;
             mem_write <= 1'b0;
             mem_valid <= 1'b0;
             addr_reg <= 32'b0;
-            data_reg <= 64'b0;
+            data_reg <= {VLEN{1'b0}};
+            beat <= {BEAT_BITS{1'b0}};
+            last_beat_num <= {BEAT_BITS{1'b0}};
             is_store_reg <= 1'b0;
+            mode_reg <= MODE_UNIT;
+            sew_reg <= 2'b00;
+            stride_reg <= 32'b0;
+            offs_reg <= {VLEN{1'b0}};
+            byte_off <= 2'b00;
+            bmask_reg <= {(VLEN/8){1'b0}};
         end else begin
             case (state)
                 IDLE: begin
@@ -61,86 +134,109 @@ module vlsu(
                         addr_reg <= base_addr;
                         data_reg <= store_data;
                         is_store_reg <= is_store;
-                        state <= REQ_WORD0;
+                        mode_reg <= is_store ? MODE_UNIT : mode;
+                        sew_reg <= sew;
+                        stride_reg <= stride;
+                        offs_reg <= offsets;
+                        bmask_reg <= bmask;
+                        beat <= {BEAT_BITS{1'b0}};
+                        if (is_store || mode == MODE_UNIT) begin
+                            last_beat_num <= LAST_WORD;
+                        end else begin
+                            last_beat_num <= (sew == 2'b00) ? LAST_E8 :
+                                             (sew == 2'b01) ? LAST_E16 : LAST_WORD;
+                        end
+                        state <= REQ_WORD;
                     end
                 end
 
-                REQ_WORD0: begin
-                    // request first word (lower 32 bits)
-                    mem_addr <= addr_reg;
-                    mem_valid <= 1'b1;
+                REQ_WORD: begin
+                    mem_valid <= beat_on;
                     mem_write <= is_store_reg;
-
-
-                    if (is_store_reg) begin
-                        mem_wdata <= data_reg[31:0]; // lower 32bits
-                        mem_wmask <= 4'b1111;
+                    if (!elem_mode) begin
+                        // request the word at addr_reg, lowest first
+                        mem_addr <= addr_reg;
+                        addr_reg <= addr_reg + 32'd4; // next 4 bytes
+                        data_reg <= data_reg >> 32; // store: word sent, load: make room at the top
+                        bmask_reg <= bmask_reg >> 4;
                     end else begin
-                        mem_wdata <= 32'd0;
-                        mem_wmask <= 4'b0000;
-                    end
-
-                    state <= WAIT_WORD0;
-                end
-                
-                WAIT_WORD0: begin
-                    if (mem_ready) begin
-                        mem_valid <= 1'b0;
-
-                        if (is_store_reg) begin
-                            // store: request accepted, move to second word
-                            state <= REQ_WORD1;
-                        end else begin
-                            // load: wait for response
-                            if (mem_resp_valid) begin
-                                data_reg[31:0] <= mem_resp_rdata; // save lower 32 bits
-                                state <= REQ_WORD1;
+                        // the word holding the next element
+                        mem_addr <= {elem_addr[31:2], 2'b00};
+                        byte_off <= elem_addr[1:0];
+                        if (mode_reg == MODE_STRIDED) begin
+                            addr_reg <= addr_reg + stride_reg;
+                        end
+                        case (sew_reg)
+                            2'b00: begin
+                                offs_reg <= offs_reg >> 8;
+                                bmask_reg <= bmask_reg >> 1;
+                            end
+                            2'b01: begin
+                                offs_reg <= offs_reg >> 16;
+                                bmask_reg <= bmask_reg >> 2;
+                            end
+                            default: begin
+                                offs_reg <= offs_reg >> 32;
+                                bmask_reg <= bmask_reg >> 4;
                             end
+                        endcase
+                        // a skipped element: 0 moves in at the top
+                        if (!beat_on) begin
+                            case (sew_reg)
+                                2'b00: data_reg <= data_reg >> 8;
+                                2'b01: data_reg <= data_reg >> 16;
+                                default: data_reg <= data_reg >> 32;
+                            endcase
                         end
                     end
-                    else if (!is_store_reg && mem_resp_valid) begin
-                        // load response came before ready (edge case)
-                        data_reg[31:0] <= mem_resp_rdata;
-                    end
-                end
-
-                REQ_WORD1: begin
-                    // request second word (upper 32bits)
-                    mem_addr <= addr_reg + 32'd4; // next 4 bytes
-                    mem_valid <= 1'b1;
-                    mem_write <= is_store_reg;
 
                     if (is_store_reg) begin
-                        mem_wdata <= data_reg[63:32]; // upper 32bits
-                        mem_wmask <= 4'b1111;
+                        mem_wdata <= data_reg[31:0];
+                        mem_wmask <= bmask_reg[3:0];
                     end else begin
                         mem_wdata <= 32'd0;
                         mem_wmask <= 4'b0000;
                     end
 
-                    state <= WAIT_WORD1;
+                    if (beat_on) begin
+                        state <= WAIT_WORD;
+                    end else begin
+                        // no active byte: nothing on the bus for this beat
+                        beat <= beat + 1'b1;
+                        state <= last_beat ? COMPLETE : REQ_WORD;
+                    end
                 end
-                
-                WAIT_WORD1: begin
+
+                WAIT_WORD: begin
+                    // ready only qualifies the request; once it is accepted
+                    // the load response may come any later cycle, whatever
+                    // mem_ready does by then
                     if (mem_ready) begin
                         mem_valid <= 1'b0;
 
                         if (is_store_reg) begin
-                            // store complete
-                            state <= COMPLETE;
+                            // store: request accepted, next word or done
+                            beat <= beat + 1'b1;
+                            state <= last_beat ? COMPLETE : REQ_WORD;
+                        end else if (mem_resp_valid) begin
+                            // load answered in the accepting cycle
+                            data_reg <= data_ins;
+                            beat <= beat + 1'b1;
+                            state <= last_beat ? COMPLETE : REQ_WORD;
                         end else begin
-                            // load, wait for response
-                            if (mem_resp_valid) begin
-                                data_reg[63:32] <= mem_resp_rdata; // save upper 32 bits
-                                state <= COMPLETE;
-                            end
+                            state <= WAIT_RESP;
                         end
                     end
-                    else if (!is_store_reg && mem_resp_valid) begin
-                        data_reg[63:32] <= mem_resp_rdata;
+                end
+
+                WAIT_RESP: begin
+                    if (mem_resp_valid) begin
+                        data_reg <= data_ins;
+                        beat <= beat + 1'b1;
+                        state <= last_beat ? COMPLETE : REQ_WORD;
                     end
                 end
-                
+
                 COMPLETE: begin
                     // output result and signal done
                     if (!is_store_reg) begin
@@ -0,0 +1,306 @@
+// stride prefetcher for the vector load/store unit
+// Sits between vlsu and the 32-bit data bus. Each VLD trains a small
+// reference prediction table (RPT) indexed by the VLD's PC, so interleaved
+// streams (input[i] and W1_packed[j][i] in the MNIST loop) are tracked
+// separately. Once a stream repeats its stride, the next DEPTH vector lines
+// (VLEN bits each) are fetched into a line buffer ahead of the demand VLDs.
+// Demand loads that hit the buffer are answered here without a bus access.
+//
+// Bus rules:
+//  - prefetches are only issued while `enable` is high (vector side owns the bus)
+//  - demand requests from vlsu always win over prefetch requests
+//  - responses are in order, so outstanding reads are tracked in a small FIFO
+//  - `idle` is low while prefetch responses are in flight; the core must not
+//    hand the bus back to the scalar side until it is high again
+
+module vprefetch #(
+    parameter VLEN = 64,       // line size in bits
+    parameter NUM_LINES = 4,   // line buffer entries (one vector each)
+    parameter NUM_STREAMS = 4, // RPT entries, power of 2
+    parameter DEPTH = 2        // how many strides ahead to prefetch
+)(
+    input wire clk,
+    input wire rst_n,
+    input wire enable, // vector side owns the bus
+
+    // training interface, one pulse per VLD
+    input wire train_valid,
+    input wire [31:0] train_pc,
+    input wire [31:0] train_addr,
+
+    // demand interface (from vlsu)
+    input wire [31:0] vlsu_addr,
+    input wire [31:0] vlsu_wdata,
+    input wire [3:0] vlsu_wmask,
+    input wire vlsu_write,
+    input wire vlsu_valid,
+    output wire vlsu_ready,
+    output wire vlsu_resp_valid,
+    output wire [31:0] vlsu_resp_rdata,
+
+    // memory interface
+    output wire [31:0] mem_addr,
+    output wire [31:0] mem_wdata,
+    output wire [3:0] mem_wmask,
+    output wire mem_write,
+    output wire mem_valid,
+    input wire mem_ready,
+    input wire mem_resp_valid,
+    input wire [31:0] mem_resp_rdata,
+
+    // write snoop (every accepted store on the data bus), keeps the buffer coherent
+    input wire snoop_write,
+    input wire [31:0] snoop_addr,
+
+    output wire idle,
+    output reg [31:0] useful_count,  // prefetched lines hit by a demand VLD
+    output reg [31:0] useless_count  // prefetched lines evicted/invalidated unused
+);
+
+    localparam STREAM_BITS = (NUM_STREAMS > 1) ? $clog2(NUM_STREAMS) : 1;
+    localparam LINE_BITS = (NUM_LINES > 1) ? $clog2(NUM_LINES) : 1;
+    localparam Q_DEPTH = 4;
+    localparam [2:0] PF_DEPTH = DEPTH;
+    localparam LINE_SHIFT = $clog2(VLEN / 8); // byte offset bits of a line
+    localparam WORDS = VLEN / 32;
+    localparam WORD_BITS = $clog2(WORDS);
+    localparam [WORD_BITS-1:0] LAST_WORD = WORDS - 1;
+
+    // 1. reference prediction table
+
+    reg rpt_valid [0:NUM_STREAMS-1];
+    reg [29:0] rpt_tag [0:NUM_STREAMS-1]; // pc[31:2]
+    reg [31:0] rpt_last [0:NUM_STREAMS-1];
+    reg [31:0] rpt_stride [0:NUM_STREAMS-1];
+
+    wire [STREAM_BITS-1:0] rpt_idx = train_pc[2 +: STREAM_BITS];
+    wire rpt_hit = rpt_valid[rpt_idx] && (rpt_tag[rpt_idx] == train_pc[31:2]);
+    wire [31:0] new_stride = train_addr - rpt_last[rpt_idx];
+    wire stride_match = rpt_hit && (new_stride == rpt_stride[rpt_idx]) && (new_stride != 32'd0);
+
+    // 2. line buffer
+
+    reg line_valid [0:NUM_LINES-1];
+    reg line_filling [0:NUM_LINES-1]; // fill in flight
+    reg line_stale [0:NUM_LINES-1];   // written while filling, drop on completion
+    reg line_used [0:NUM_LINES-1];
+    reg [31:LINE_SHIFT] line_addr [0:NUM_LINES-1];
+    reg [31:0] line_data [0:NUM_LINES*WORDS-1]; // word w of line l at {l, w}
+    reg [LINE_BITS-1:0] victim_ptr;
+
+    // demand lookup
+    reg hit;
+    reg [LINE_BITS-1:0] hit_idx;
+    integer i;
+    always @(*) begin
+        hit = 1'b0;
+        hit_idx = {LINE_BITS{1'b0}};
+        for (i = 0; i < NUM_LINES; i = i + 1) begin
+            if (line_valid[i] && line_addr[i] == vlsu_addr[31:LINE_SHIFT]) begin
+                hit = 1'b1;
+                hit_idx = i[LINE_BITS-1:0];
+            end
+        end
+    end
+    wire demand_hit = vlsu_valid && !vlsu_write && hit;
+
+    // 3. prefetch engine
+
+    reg pf_pending; // a stream is trained and has lines left to fetch
+    reg [31:0] pf_next; // next candidate line address
+    reg [31:0] pf_stride;
+    reg [2:0] pf_left;
+    reg pf_filling; // engine is issuing the beats of a line
+    reg [WORD_BITS-1:0] pf_beat; // word of the line requested next
+    reg [LINE_BITS-1:0] pf_slot;
+    reg [31:LINE_SHIFT] pf_line;
+
+    // candidate already buffered or being filled?
+    reg present;
+    always @(*) begin
+        present = 1'b0;
+        for (i = 0; i < NUM_LINES; i = i + 1) begin
+            if ((line_valid[i] || line_filling[i]) && line_addr[i] == pf_next[31:LINE_SHIFT]) begin
+                present = 1'b1;
+            end
+        end
+    end
+
+    // 4. outstanding read FIFO (responses come back in order)
+
+    reg q_pf [0:Q_DEPTH-1];
+    reg [LINE_BITS-1:0] q_slot [0:Q_DEPTH-1];
+    reg [WORD_BITS-1:0] q_beat [0:Q_DEPTH-1];
+    reg [1:0] q_head, q_tail;
+    reg [2:0] q_count;
+
+    // bus arbitration: demand misses first, then prefetch beats
+    wire demand_to_bus = vlsu_valid && !demand_hit;
+    wire pf_issue = enable && pf_filling && !demand_to_bus && (q_count < Q_DEPTH - 1);
+    wire [31:0] pf_addr = {pf_line, pf_beat, 2'b00};
+
+    assign mem_valid = demand_to_bus || pf_issue;
+    assign mem_write = demand_to_bus ? vlsu_write : 1'b0;
+    assign mem_addr = demand_to_bus ? vlsu_addr : pf_addr;
+    assign mem_wdata = vlsu_wdata;
+    assign mem_wmask = demand_to_bus ? vlsu_wmask : 4'b0000;
+    assign vlsu_ready = demand_hit || (demand_to_bus && mem_ready);
+
+    wire bus_read_accepted = mem_valid && mem_ready && !mem_write;
+    wire pf_accepted = pf_issue && mem_ready;
+    wire resp_is_pf = (q_count != 3'd0) && q_pf[q_head];
+
+    // buffered hit data is returned one cycle later, like the SRAM
+    reg hit_resp_valid;
+    reg [31:0] hit_resp_rdata;
+
+    assign vlsu_resp_valid = hit_resp_valid || (mem_resp_valid && (q_count != 3'd0) && !q_pf[q_head]);
+    assign vlsu_resp_rdata = hit_resp_valid ? hit_resp_rdata : mem_resp_rdata;
+    assign idle = (q_count == 3'd0);
+
+    // stop at the end of SRAM, never prefetch from MMIO space
+    wire pf_in_range = (pf_next[31:24] == 8'h00);
+
+    // the engine replaces the victim line with the next candidate
+    wire pf_evict = !train_valid && pf_pending && !pf_filling && (pf_left != 3'd0) && pf_in_range &&
+                    !present && !line_filling[victim_ptr];
+
+    // lines dropped unused this cycle, by the victim replacement or by a store
+    // invalidation (both can hit different lines in one cycle, one line counts once)
+    reg [LINE_BITS:0] useless_inc;
+    always @(*) begin
+        useless_inc = {(LINE_BITS+1){1'b0}};
+        for (i = 0; i < NUM_LINES; i = i + 1) begin
+            if (line_valid[i] && !line_used[i] &&
+                ((pf_evict && victim_ptr == i[LINE_BITS-1:0]) ||
+                 (snoop_write && line_addr[i] == snoop_addr[31:LINE_SHIFT]))) begin
+                useless_inc = useless_inc + 1'b1;
+            end
+        end
+    end
+
+    integer n;
+    always @(posedge clk) begin
+        if (!rst_n) begin
+            for (n = 0; n < NUM_STREAMS; n = n + 1) begin
+                rpt_valid[n] <= 1'b0;
+            end
+            for (n = 0; n < NUM_LINES; n = n + 1) begin
+                line_valid[n] <= 1'b0;
+                line_filling[n] <= 1'b0;
+                line_stale[n] <= 1'b0;
+                line_used[n] <= 1'b0;
+            end
+            victim_ptr <= {LINE_BITS{1'b0}};
+            pf_pending <= 1'b0;
+            pf_filling <= 1'b0;
+            pf_beat <= {WORD_BITS{1'b0}};
+            pf_left <= 3'd0;
+            q_head <= 2'd0;
+            q_tail <= 2'd0;
+            q_count <= 3'd0;
+            hit_resp_valid <= 1'b0;
+            hit_resp_rdata <= 32'd0;
+            useful_count <= 32'd0;
+            useless_count <= 32'd0;
+        end else begin
+            // training
+            if (train_valid) begin
+                if (rpt_hit) begin
+                    rpt_last[rpt_idx] <= train_addr;
+                    if (stride_match) begin
+                        // same stride twice in a row: stream is steady,
+                        // the newest stream takes over the engine
+                        pf_pending <= 1'b1;
+                        pf_next <= {train_addr[31:LINE_SHIFT], {LINE_SHIFT{1'b0}}} + new_stride;
+                        pf_stride <= new_stride;
+                        pf_left <= PF_DEPTH;
+                    end else begin
+                        rpt_stride[rpt_idx] <= new_stride;
+                    end
+                end else begin
+                    rpt_valid[rpt_idx] <= 1'b1;
+                    rpt_tag[rpt_idx] <= train_pc[31:2];
+                    rpt_last[rpt_idx] <= train_addr;
+                    rpt_stride[rpt_idx] <= 32'd0;
+                end
+            end
+
+            // pick the next line to fetch
+            if (!train_valid && pf_pending && !pf_filling) begin
+                if (pf_left == 3'd0 || !pf_in_range) begin
+                    pf_pending <= 1'b0;
+                end else if (present) begin
+                    pf_next <= pf_next + pf_stride;
+                    pf_left <= pf_left - 3'd1;
+                end else if (!line_filling[victim_ptr]) begin
+                    line_valid[victim_ptr] <= 1'b0;
+                    line_filling[victim_ptr] <= 1'b1;
+                    line_stale[victim_ptr] <= 1'b0;
+                    line_used[victim_ptr] <= 1'b0;
+                    line_addr[victim_ptr] <= pf_next[31:LINE_SHIFT];
+                    pf_slot <= victim_ptr;
+                    pf_line <= pf_next[31:LINE_SHIFT];
+                    pf_beat <= {WORD_BITS{1'b0}};
+                    pf_filling <= 1'b1;
+                    victim_ptr <= victim_ptr + 1'b1;
+                    pf_next <= pf_next + pf_stride;
+                    pf_left <= pf_left - 3'd1;
+                end
+            end
+
+            if (pf_accepted) begin
+                if (pf_beat == LAST_WORD) begin
+                    pf_filling <= 1'b0;
+                end
+                pf_beat <= pf_beat + 1'b1;
+            end
+
+            // outstanding FIFO push/pop
+            if (bus_read_accepted) begin
+                q_pf[q_tail] <= pf_issue;
+                q_slot[q_tail] <= pf_slot;
+                q_beat[q_tail] <= pf_beat;
+                q_tail <= q_tail + 2'd1;
+            end
+            if (mem_resp_valid && q_count != 3'd0) begin
+                q_head <= q_head + 2'd1;
+                if (resp_is_pf) begin
+                    line_data[{q_slot[q_head], q_beat[q_head]}] <= mem_resp_rdata;
+                    if (q_beat[q_head] == LAST_WORD) begin
+                        line_filling[q_slot[q_head]] <= 1'b0;
+                        line_valid[q_slot[q_head]] <= !line_stale[q_slot[q_head]];
+                    end
+                end
+            end
+            q_count <= q_count + (bus_read_accepted ? 3'd1 : 3'd0)
+                               - ((mem_resp_valid && q_count != 3'd0) ? 3'd1 : 3'd0);
+
+            // demand hit
+            hit_resp_valid <= demand_hit;
+            if (demand_hit) begin
+                hit_resp_rdata <= line_data[{hit_idx, vlsu_addr[LINE_SHIFT-1:2]}];
+                if (!line_used[hit_idx]) begin
+                    line_used[hit_idx] <= 1'b1;
+                    useful_count <= useful_count + 32'd1;
+                end
+            end
+
+            useless_count <= useless_count + useless_inc;
+
+            // stores invalidate matching lines (last, so they win)
+            if (snoop_write) begin
+                for (n = 0; n < NUM_LINES; n = n + 1) begin
+                    if (line_addr[n] == snoop_addr[31:LINE_SHIFT]) begin
+                        // also overrides a fill completing in this cycle
+                        line_valid[n] <= 1'b0;
+                        if (line_filling[n]) begin
+                            line_stale[n] <= 1'b1;
+                        end
+                    end
+                end
+            end
+        end
+    end
+
+endmodule
@@ -0,0 +1,136 @@
+// store/write-combining buffer for the data bus
+// Stores retire into the buffer and drain in the background whenever the core
+// is not using the bus. A store to the same word as the youngest entry is
+// merged into it (byte mask OR), so runs of SB/SH to one word cost one bus write.
+// Loads look the buffer up and get the buffered bytes forwarded
+// (older entries first, younger ones overwrite).
+// Only SRAM addresses are buffered; MMIO accesses must wait for `empty`.
+
+module wbuf #(
+    parameter DEPTH = 4, // entries, power of 2, at least VLEN/32
+    parameter VLEN = 64
+)(
+    input wire clk,
+    input wire rst_n,
+
+    // push port (scalar stores)
+    input wire push,
+    input wire [31:0] push_addr,
+    input wire [31:0] push_wdata,
+    input wire [3:0] push_wmask,
+    // vector push port (a whole VST, one entry per word, never merged)
+    input wire push_vec,
+    input wire [31:0] push_vec_addr,
+    input wire [VLEN-1:0] push_vec_wdata,
+    output wire can_push, // room for one store (or it merges)
+    output wire can_push_vec, // room for VLEN/32 words
+
+    // load-after-store forwarding
+    input wire [31:0] lookup_addr,
+    output reg [31:0] fwd_data,
+    output reg [3:0] fwd_mask,
+    // any buffered word inside the VLEN/8-byte line (VLD ordering check)
+    input wire [31:0] line_addr,
+    output reg line_match,
+
+    // drain port
+    output wire drain_valid,
+    output wire [31:0] drain_addr,
+    output wire [31:0] drain_wdata,
+    output wire [3:0] drain_wmask,
+    input wire drain_ready,
+
+    output wire empty
+);
+
+    localparam PTR_BITS = (DEPTH > 1) ? $clog2(DEPTH) : 1;
+    localparam LINE_SHIFT = $clog2(VLEN / 8); // byte offset bits of a vector line
+    localparam [PTR_BITS:0] VEC_WORDS = VLEN / 32;
+    localparam [PTR_BITS-1:0] PTR_ONE = 1;
+    localparam [PTR_BITS:0] COUNT_ONE = 1;
+
+    reg [29:0] buf_addr [0:DEPTH-1]; // addr[31:2]
+    reg [31:0] buf_data [0:DEPTH-1];
+    reg [3:0] buf_mask [0:DEPTH-1];
+    reg [PTR_BITS-1:0] head, tail;
+    reg [PTR_BITS:0] count;
+
+    wire [PTR_BITS-1:0] youngest = tail - 1'b1;
+    wire drain_fire = drain_valid && drain_ready;
+
+    // merge into the youngest entry unless it is leaving this cycle
+    wire merge_ok = (count != 0) && (buf_addr[youngest] == push_addr[31:2]) &&
+                    !(count == 1 && drain_fire);
+    wire merge = push && !push_vec && merge_ok;
+
+    assign can_push = (count < DEPTH) || merge_ok;
+    assign can_push_vec = (count + VEC_WORDS <= DEPTH);
+    assign empty = (count == 0);
+
+    assign drain_valid = (count != 0);
+    assign drain_addr = {buf_addr[head], 2'b00};
+    assign drain_wdata = buf_data[head];
+    assign drain_wmask = buf_mask[head];
+
+    // forwarding, oldest to youngest
+    integer k, b;
+    reg [PTR_BITS-1:0] idx;
+    always @(*) begin
+        fwd_data = 32'd0;
+        fwd_mask = 4'b0000;
+        line_match = 1'b0;
+        for (k = 0; k < DEPTH; k = k + 1) begin
+            idx = head + k[PTR_BITS-1:0];
+            if (k < count) begin
+                if (buf_addr[idx] == lookup_addr[31:2]) begin
+                    for (b = 0; b < 4; b = b + 1) begin
+                        if (buf_mask[idx][b]) begin
+                            fwd_data[b*8 +: 8] = buf_data[idx][b*8 +: 8];
+                        end
+                    end
+                    fwd_mask = fwd_mask | buf_mask[idx];
+                end
+                if (buf_addr[idx][29:LINE_SHIFT-2] == line_addr[31:LINE_SHIFT]) begin
+                    line_match = 1'b1;
+                end
+            end
+        end
+    end
+
+    integer n, m;
+    always @(posedge clk) begin
+        if (!rst_n) begin
+            head <= {PTR_BITS{1'b0}};
+            tail <= {PTR_BITS{1'b0}};
+            count <= {(PTR_BITS+1){1'b0}};
+        end else begin
+            if (merge) begin
+                for (m = 0; m < 4; m = m + 1) begin
+                    if (push_wmask[m]) begin
+                        buf_data[youngest][m*8 +: 8] <= push_wdata[m*8 +: 8];
+                    end
+                end
+                buf_mask[youngest] <= buf_mask[youngest] | push_wmask;
+            end else if (push) begin
+                buf_addr[tail] <= push_addr[31:2];
+                buf_data[tail] <= push_wdata;
+                buf_mask[tail] <= push_wmask;
+            end
+            if (push_vec) begin
+                for (n = 0; n < VLEN / 32; n = n + 1) begin
+                    buf_addr[tail + n[PTR_BITS-1:0]] <= push_vec_addr[31:2] + n[29:0];
+                    buf_data[tail + n[PTR_BITS-1:0]] <= push_vec_wdata[n*32 +: 32];
+                    buf_mask[tail + n[PTR_BITS-1:0]] <= 4'b1111;
+                end
+            end
+
+            if (drain_fire) begin
+                head <= head + 1'b1;
+            end
+            tail <= tail + ((push && !merge) ? PTR_ONE : {PTR_BITS{1'b0}}) + (push_vec ? VEC_WORDS[PTR_BITS-1:0] : {PTR_BITS{1'b0}});
+            count <= count + ((push && !merge) ? COUNT_ONE : {(PTR_BITS+1){1'b0}}) + (push_vec ? VEC_WORDS : {(PTR_BITS+1){1'b0}})
+                           - (drain_fire ? COUNT_ONE : {(PTR_BITS+1){1'b0}});
+        end
+    end
+
+endmodule